@@ -31,9 +31,14 @@
 #include "kpDefs.h"
 #include "document/kpDocument.h"
 #include "generic/kpSetOverrideCursorSaver.h"
+#include "generic/kpTrace.h"
+#include "pixmapfx/kpPixmapFX.h"
 
 #include <KLocalizedString>
 
+#include <QRegion>
+#include <QVector>
+
 //--------------------------------------------------------------------------------
 
 struct kpEffectCommandBasePrivate
@@ -42,6 +47,11 @@ struct kpEffectCommandBasePrivate
     bool actOnSelection{false};
 
     kpImage oldImage;
+
+    // If the effect only changed part of the image, the old contents of the
+    // changed tiles are kept instead of <oldImage>.
+    QVector <QRect> oldRects;
+    QVector <kpImage> oldTiles;
 };
 
 kpEffectCommandBase::kpEffectCommandBase (const QString &name,
@@ -70,7 +80,11 @@ QString kpEffectCommandBase::name () const
 // public virtual [base kpCommand]
 kpCommandSize::SizeType kpEffectCommandBase::size () const
 {
-    return ImageSize (d->oldImage);
+    kpCommandSize::SizeType s = ImageSize (d->oldImage);
+    for (const auto &tile : d->oldTiles) {
+        s += ImageSize (tile);
+    }
+    return s;
 }
 
 
@@ -85,15 +99,35 @@ void kpEffectCommandBase::execute ()
 
     const kpImage oldImage = doc->image (d->actOnSelection);
 
-    if (!isInvertible ())
+
+    kpImage newImage;
     {
-        d->oldImage = oldImage;
+        kpTraceScope traceScope ("imagelib", "kpEffectCommandBase::applyEffect");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (d->name);
+        }
+
+        newImage = /*pure virtual*/applyEffect (oldImage);
     }
 
+    // Both storeOldImage() and kpDocument::setImage() need to know which
+    // pixels changed so only work that out once.
+    const bool needChanged = !d->actOnSelection ||
+        (!isInvertible () && !kpPixmapFX::isIndexed (oldImage));
+    const QRegion changed = needChanged ?
+        kpPixmapFX::changedRegion (oldImage, newImage) : QRegion ();
 
-    kpImage newImage = /*pure virtual*/applyEffect (oldImage);
+    if (!isInvertible ())
+    {
+        storeOldImage (oldImage, changed);
+    }
 
-    doc->setImage (d->actOnSelection, newImage);
+    if (d->actOnSelection) {
+        doc->setImage (true/*of selection*/, newImage);
+    }
+    else {
+        doc->setImage (newImage, changed);
+    }
 }
 
 // public virtual [base kpCommand]
@@ -109,10 +143,25 @@ void kpEffectCommandBase::unexecute ()
 
     if (!isInvertible ())
     {
-        newImage = d->oldImage;
+        if (!d->oldRects.isEmpty ())
+        {
+            newImage = doc->image (d->actOnSelection);
+            for (int i = 0; i < d->oldRects.count (); i++) {
+                kpPixmapFX::setPixmapAt (&newImage, d->oldRects [i], d->oldTiles [i]);
+            }
+        }
+        else
+        {
+            newImage = d->oldImage;
+        }
     }
     else
     {
+        kpTraceScope traceScope ("imagelib", "kpEffectCommandBase::applyEffect");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (d->name);
+        }
+
         newImage = /*pure virtual*/applyEffect (doc->image (d->actOnSelection));
     }
 
@@ -120,5 +169,42 @@ void kpEffectCommandBase::unexecute ()
 
 
     d->oldImage = kpImage ();
+    d->oldRects.clear ();
+    d->oldTiles.clear ();
+}
+
+// private
+void kpEffectCommandBase::storeOldImage (const kpImage &oldImage,
+                                         const QRegion &changed)
+{
+    d->oldImage = kpImage ();
+    d->oldRects.clear ();
+    d->oldTiles.clear ();
+
+    // setPixmapAt() can't restore tiles of indexed images.
+    if (kpPixmapFX::isIndexed (oldImage)) {
+        d->oldImage = oldImage;
+        return;
+    }
+
+    qint64 changedArea = 0;
+    for (const auto &rect : changed) {
+        changedArea += qint64 (rect.width ()) * rect.height ();
+    }
+
+    // Not worth splitting up the image if most of it changed (or none of
+    // it did, in which case <oldImage> probably still shares its pixels
+    // with <newImage>).
+    if (changed.isEmpty () ||
+        changedArea * 2 > qint64 (oldImage.width ()) * oldImage.height ()) {
+        d->oldImage = oldImage;
+        return;
+    }
+
+    for (const auto &rect : changed)
+    {
+        d->oldRects.append (rect);
+        d->oldTiles.append (kpPixmapFX::getPixmapAt (oldImage, rect));
+    }
 }
 
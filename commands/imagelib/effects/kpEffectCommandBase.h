@@ -36,6 +36,9 @@
 #include "imagelib/kpImage.h"
 
 
+class QRegion;
+
+
 class kpEffectCommandBase : public kpCommand
 {
 public:
@@ -60,6 +63,8 @@ protected:
     virtual kpImage applyEffect (const kpImage &image) = 0;
 
 private:
+    void storeOldImage (const kpImage &oldImage, const QRegion &changed);
+
     struct kpEffectCommandBasePrivate *d;
 };
 
@@ -0,0 +1,77 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "kpEffectReduceToPaletteCommand.h"
+#include "imagelib/effects/kpEffectReduceToPalette.h"
+
+#include <KLocalizedString>
+
+//---------------------------------------------------------------------
+
+kpEffectReduceToPaletteCommand::kpEffectReduceToPaletteCommand (
+        const QVector <QRgb> &palette, bool dither,
+        bool actOnSelection,
+        kpCommandEnvironment *environ)
+    : kpEffectCommandBase (commandName (dither), actOnSelection, environ),
+      m_palette (palette), m_dither (dither)
+{
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QString kpEffectReduceToPaletteCommand::commandName (bool dither)
+{
+    if (dither) {
+        return i18n ("Reduce to Palette (Dithered)");
+    }
+
+    return i18n ("Reduce to Palette");
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [base kpEffectCommandBase]
+kpCommandSize::SizeType kpEffectReduceToPaletteCommand::size () const
+{
+    return kpEffectCommandBase::size () +
+           static_cast<kpCommandSize::SizeType> (m_palette.size ()) * sizeof (QRgb);
+}
+
+//---------------------------------------------------------------------
+
+//
+// kpEffectReduceToPaletteCommand implements kpEffectCommandBase interface
+//
+
+// protected virtual [base kpEffectCommandBase]
+kpImage kpEffectReduceToPaletteCommand::applyEffect (const kpImage &image)
+{
+    return kpEffectReduceToPalette::applyEffect (image, m_palette, m_dither);
+}
+
+//---------------------------------------------------------------------
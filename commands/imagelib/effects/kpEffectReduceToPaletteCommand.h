@@ -0,0 +1,63 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpEffectReduceToPaletteCommand_H
+#define kpEffectReduceToPaletteCommand_H
+
+
+#include <QRgb>
+#include <QVector>
+
+#include "kpEffectCommandBase.h"
+#include "imagelib/kpImage.h"
+
+
+class kpEffectReduceToPaletteCommand : public kpEffectCommandBase
+{
+public:
+    kpEffectReduceToPaletteCommand (const QVector <QRgb> &palette, bool dither,
+                                    bool actOnSelection,
+                                    kpCommandEnvironment *environ);
+
+    static QString commandName (bool dither);
+
+    SizeType size () const override;
+
+    //
+    // kpEffectCommandBase interface
+    //
+
+protected:
+    kpImage applyEffect (const kpImage &image) override;
+
+    // (copied, since the user can change the palette later)
+    QVector <QRgb> m_palette;
+    bool m_dither;
+};
+
+
+#endif  // kpEffectReduceToPaletteCommand_H
@@ -132,8 +132,7 @@ QString kpTransformResizeScaleCommand::name () const
 kpCommandSize::SizeType kpTransformResizeScaleCommand::size () const
 {
     return ImageSize (m_oldImage) +
-           ImageSize (m_oldRightImage) +
-           ImageSize (m_oldBottomImage) +
+           m_oldEdges.size () +
            SelectionSize (m_oldSelectionPtr);
 }
 
@@ -287,19 +286,9 @@ void kpTransformResizeScaleCommand::execute ()
             QApplication::setOverrideCursor (Qt::WaitCursor);
 
 
-            if (m_newWidth < m_oldWidth)
-            {
-                m_oldRightImage = document ()->getImageAt (
-                    QRect (m_newWidth, 0,
-                        m_oldWidth - m_newWidth, m_oldHeight));
-            }
-
-            if (m_newHeight < m_oldHeight)
-            {
-                m_oldBottomImage = document ()->getImageAt (
-                    QRect (0, m_newHeight,
-                        m_newWidth, m_oldHeight - m_newHeight));
-            }
+            // Only the trimmed off right and bottom edges need to be saved.
+            m_oldEdges = kpTransformEdgeDelta (document ()->image (),
+                QRect (0, 0, m_newWidth, m_newHeight));
 
             document ()->resize (m_newWidth, m_newHeight, m_backgroundColor);
 
@@ -410,26 +399,8 @@ void kpTransformResizeScaleCommand::unexecute ()
             QApplication::setOverrideCursor (Qt::WaitCursor);
 
 
-            kpImage newImage (m_oldWidth, m_oldHeight, QImage::Format_ARGB32_Premultiplied);
-
-            kpPixmapFX::setPixmapAt (&newImage, QPoint (0, 0),
-                                     doc->image ());
-
-            if (m_newWidth < m_oldWidth)
-            {
-                kpPixmapFX::setPixmapAt (&newImage,
-                                        QPoint (m_newWidth, 0),
-                                        m_oldRightImage);
-            }
-
-            if (m_newHeight < m_oldHeight)
-            {
-                kpPixmapFX::setPixmapAt (&newImage,
-                                        QPoint (0, m_newHeight),
-                                        m_oldBottomImage);
-            }
-
-            doc->setImage (newImage);
+            doc->setImage (m_oldEdges.restore (doc->image ()));
+            m_oldEdges = kpTransformEdgeDelta ();
 
 
             QApplication::restoreOverrideCursor ();
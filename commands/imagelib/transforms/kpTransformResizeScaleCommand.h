@@ -35,6 +35,7 @@
 #include "imagelib/kpColor.h"
 #include "commands/kpCommand.h"
 #include "imagelib/kpImage.h"
+#include "imagelib/transforms/kpTransformEdgeDelta.h"
 
 
 class QSize;
@@ -92,7 +93,8 @@ protected:
 
     int m_oldWidth, m_oldHeight;
     bool m_actOnTextSelection;
-    kpImage m_oldImage, m_oldRightImage, m_oldBottomImage;
+    kpImage m_oldImage;
+    kpTransformEdgeDelta m_oldEdges;
     kpAbstractSelection *m_oldSelectionPtr;
 };
 
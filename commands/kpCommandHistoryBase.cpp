@@ -48,6 +48,7 @@
 #include "environments/commands/kpCommandEnvironment.h"
 #include "kpDefs.h"
 #include "document/kpDocument.h"
+#include "generic/kpTrace.h"
 #include "mainWindow/kpMainWindow.h"
 #include "tools/kpTool.h"
 
@@ -256,7 +257,13 @@ void kpCommandHistoryBase::addCommand (kpCommand *command, bool execute)
                << ",execute=" << execute << ")"
 #endif
 
-    if (execute) {
+    if (execute)
+    {
+        kpTraceScope traceScope ("commands", "kpCommand::execute");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (command->name ());
+        }
+
         command->execute ();
     }
 
@@ -311,7 +318,14 @@ void kpCommandHistoryBase::undoInternal ()
         return;
     }
 
-    undoCommand->unexecute ();
+    {
+        kpTraceScope traceScope ("commands", "kpCommand::unexecute");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (undoCommand->name ());
+        }
+
+        undoCommand->unexecute ();
+    }
 
 
     m_undoCommandList.erase (m_undoCommandList.begin ());
@@ -345,7 +359,14 @@ void kpCommandHistoryBase::redoInternal ()
         return;
     }
 
-    redoCommand->execute ();
+    {
+        kpTraceScope traceScope ("commands", "kpCommand::execute");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (redoCommand->name ());
+        }
+
+        redoCommand->execute ();
+    }
 
 
     m_redoCommandList.erase (m_redoCommandList.begin ());
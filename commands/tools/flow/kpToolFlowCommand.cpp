@@ -32,6 +32,7 @@
 #include "kpToolFlowCommand.h"
 
 #include "document/kpDocument.h"
+#include "generic/kpRandom.h"
 #include "imagelib/kpImage.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
@@ -44,6 +45,7 @@ struct kpToolFlowCommandPrivate
 {
     kpImage image;
     QRect boundingRect;
+    quint32 seed;
 };
 
 
@@ -52,6 +54,7 @@ kpToolFlowCommand::kpToolFlowCommand (const QString &name, kpCommandEnvironment
       d (new kpToolFlowCommandPrivate ())
 {
     d->image = document ()->image ();
+    d->seed = kpRandom::newSeed ();
 }
 
 kpToolFlowCommand::~kpToolFlowCommand ()
@@ -138,3 +141,9 @@ void kpToolFlowCommand::cancel ()
         viewManager ()->restoreFastUpdates ();
     }
 }
+
+// public
+quint32 kpToolFlowCommand::seed () const
+{
+    return d->seed;
+}
@@ -54,6 +54,10 @@ public:
     void finalize ();
     void cancel ();
 
+    // The seed for anything drawn at random during this stroke (e.g. by
+    // the Spraycan), so that the stroke can be reproduced.
+    quint32 seed () const;
+
 private:
     void swapOldAndNew ();
 
@@ -47,6 +47,11 @@ struct kpToolFloodFillCommandPrivate
 {
     kpImage oldImage;
     bool fillEntireImage{false};
+
+    // If replaceAllSimilarColors(), the old colors of the changed pixels
+    // (see kpFloodFill::colorsOfPixelsToChange()), instead of <oldImage>.
+    QVector <QRgb> oldColors;
+    bool haveOldColors{false};
 };
 
 //---------------------------------------------------------------------
@@ -56,7 +61,8 @@ kpToolFloodFillCommand::kpToolFloodFillCommand (int x, int y,
         kpCommandEnvironment *environ)
 
     : kpCommand (environ),
-      kpFloodFill (document ()->imagePointer (), x, y, color, processedColorSimilarity),
+      kpFloodFill (document ()->imagePointer (true/*allow indexed*/), x, y,
+                   color, processedColorSimilarity),
       d (new kpToolFloodFillCommandPrivate ())
 {
     d->fillEntireImage = false;
@@ -74,6 +80,10 @@ kpToolFloodFillCommand::~kpToolFloodFillCommand ()
 // public virtual [base kpCommand]
 QString kpToolFloodFillCommand::name () const
 {
+    if (kpFloodFill::replaceAllSimilarColors ()) {
+        return i18n ("Replace Similar Colors");
+    }
+
     return i18n ("Flood Fill");
 }
 
@@ -82,7 +92,8 @@ QString kpToolFloodFillCommand::name () const
 // public virtual [base kpCommand]
 kpCommandSize::SizeType kpToolFloodFillCommand::size () const
 {
-    return kpFloodFill::size () + ImageSize (d->oldImage);
+    return kpFloodFill::size () + ImageSize (d->oldImage) +
+           d->oldColors.size () * sizeof (QRgb);
 }
 
 //---------------------------------------------------------------------
@@ -118,7 +129,20 @@ void kpToolFloodFillCommand::execute ()
         {
             QApplication::setOverrideCursor (Qt::WaitCursor);
             {
-                d->oldImage = doc->getImageAt (rect);
+                if (kpFloodFill::replaceAllSimilarColors ())
+                {
+                    // The changed pixels can be spread over the whole image
+                    // so only remember the ones we change.
+                    if (!d->haveOldColors)
+                    {
+                        d->oldColors = kpFloodFill::colorsOfPixelsToChange ();
+                        d->haveOldColors = true;
+                    }
+                }
+                else
+                {
+                    d->oldImage = doc->getImageAt (rect);
+                }
 
                 kpFloodFill::fill ();
                 doc->slotContentsChanged (rect);
@@ -157,9 +181,16 @@ void kpToolFloodFillCommand::unexecute ()
         QRect rect = kpFloodFill::boundingRect ();
         if (rect.isValid ())
         {
-            doc->setImageAt (d->oldImage, rect.topLeft ());
+            if (kpFloodFill::replaceAllSimilarColors ())
+            {
+                kpFloodFill::unfill (d->oldColors);
+            }
+            else
+            {
+                doc->setImageAt (d->oldImage, rect.topLeft ());
 
-            d->oldImage = kpImage ();
+                d->oldImage = kpImage ();
+            }
 
             doc->slotContentsChanged (rect);
         }
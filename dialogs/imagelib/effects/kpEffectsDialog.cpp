@@ -270,7 +270,8 @@ void kpEffectsDialog::selectEffect (int which)
         break;
 
     case 6:
-        CREATE_EFFECT_WIDGET (kpEffectReduceColorsWidget);
+        m_effectWidget = new kpEffectReduceColorsWidget (m_actOnSelection,
+            m_environ->paletteColors (), m_settingsGroupBox);
         break;
 
     case 7:
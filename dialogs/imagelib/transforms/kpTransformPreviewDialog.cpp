@@ -330,6 +330,10 @@ void kpTransformPreviewDialog::updateShrunkenDocumentPixmap ()
             image = doc->image ();
         }
 
+        // The document is shrunk smoothly, so that the preview is not
+        // aliased.  This is only redone when the preview changes size and,
+        // since smooth scaling is multi-threaded, costs little more than the
+        // fast scale used to.
         m_shrunkenDocumentPixmap = kpPixmapFX::scale (
             image,
             scaleDimension (m_oldWidth,
@@ -337,7 +341,8 @@ void kpTransformPreviewDialog::updateShrunkenDocumentPixmap ()
                             1, m_previewPixmapLabel->width ()),
             scaleDimension (m_oldHeight,
                             keepsAspectScale,
-                            1, m_previewPixmapLabel->height ()));
+                            1, m_previewPixmapLabel->height ()),
+            true/*pretty*/);
 
         m_previewPixmapLabelSizeWhenUpdatedPixmap = m_previewPixmapLabel->size ();
     }
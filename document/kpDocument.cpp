@@ -44,6 +44,7 @@
 #include "tools/kpTool.h"
 #include "widgets/toolbars/kpToolToolBar.h"
 #include "lgpl/generic/kpUrlFormatter.h"
+#include "pixmapfx/kpPixmapFX.h"
 
 
 #include "kpLogCategories.h"
@@ -58,6 +59,7 @@
 #include <QList>
 #include <QPainter>
 #include <QRect>
+#include <QRegion>
 #include <QSize>
 #include <QTransform>
 
@@ -308,10 +310,34 @@ QRect kpDocument::rect (bool ofSelection) const
 
 //---------------------------------------------------------------------
 
+// private
+void kpDocument::convertImageToFullColor () const
+{
+    if (!kpPixmapFX::isIndexed (*m_image)) {
+        return;
+    }
+
+#if DEBUG_KP_DOCUMENT
+    qCDebug(kpLogDocument) << "kpDocument::convertImageToFullColor() from depth"
+               << m_image->depth ();
+#endif
+
+    *m_image = m_image->convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    d->fullColorImage = kpImage ();
+}
+
+//---------------------------------------------------------------------
+
 // public
 kpImage kpDocument::getImageAt (const QRect &rect) const
 {
-    return kpPixmapFX::getPixmapAt (*m_image, rect);
+    const kpImage image = kpPixmapFX::getPixmapAt (*m_image, rect);
+
+    if (kpPixmapFX::isIndexed (image)) {
+        return image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    }
+
+    return image;
 }
 
 //---------------------------------------------------------------------
@@ -327,7 +353,13 @@ void kpDocument::setImageAt (const kpImage &image, const QPoint &at)
                << ",y=" << at.y ();
 #endif
 
-    kpPixmapFX::setPixmapAt (m_image, at, image);
+    if (!kpPixmapFX::isIndexed (*m_image) ||
+        !kpPixmapFX::setIndexedPixmapAt (m_image, at, image))
+    {
+        convertImageToFullColor ();
+        kpPixmapFX::setPixmapAt (m_image, at, image);
+    }
+
     slotContentsChanged (QRect (at.x (), at.y (), image.width (), image.height ()));
 }
 
@@ -345,6 +377,19 @@ kpImage kpDocument::image (bool ofSelection) const
 
         ret = imageSel->baseImage ();
     }
+    else if (kpPixmapFX::isIndexed (*m_image))
+    {
+        // Any write to <m_image>, even through imagePointer(), changes its
+        // cacheKey().
+        if (d->fullColorImage.isNull () ||
+            d->fullColorImageKey != m_image->cacheKey ())
+        {
+            d->fullColorImage = m_image->convertToFormat (QImage::Format_ARGB32_Premultiplied);
+            d->fullColorImageKey = m_image->cacheKey ();
+        }
+
+        ret = d->fullColorImage;
+    }
     else {
         ret = *m_image;
     }
@@ -355,8 +400,12 @@ kpImage kpDocument::image (bool ofSelection) const
 //---------------------------------------------------------------------
 
 // public
-kpImage *kpDocument::imagePointer () const
+kpImage *kpDocument::imagePointer (bool allowIndexed) const
 {
+    if (!allowIndexed) {
+        convertImageToFullColor ();
+    }
+
     return m_image;
 }
 
@@ -364,14 +413,37 @@ kpImage *kpDocument::imagePointer () const
 
 // public
 void kpDocument::setImage (const kpImage &image)
+{
+    setImage (image, kpPixmapFX::changedRegion (*m_image, image));
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocument::setImage (const kpImage &image, const QRegion &changedRegion)
 {
     m_oldWidth = width ();
     m_oldHeight = height ();
 
     *m_image = image;
+    d->fullColorImage = kpImage ();
 
-    if (m_oldWidth == width () && m_oldHeight == height ()) {
-        slotContentsChanged (image.rect ());
+    if (m_oldWidth == width () && m_oldHeight == height ())
+    {
+        // Only repaint the tiles that actually changed.
+        if (changedRegion.isEmpty ()) {
+            setModified ();
+        }
+        // A scattered change is cheaper to repaint in one go.
+        else if (changedRegion.rectCount () > 256) {
+            slotContentsChanged (changedRegion.boundingRect ());
+        }
+        else
+        {
+            for (const auto &rect : changedRegion) {
+                slotContentsChanged (rect);
+            }
+        }
     }
     else {
         slotSizeChanged (QSize (width (), height ()));
@@ -405,7 +477,16 @@ void kpDocument::fill (const kpColor &color)
     qCDebug(kpLogDocument) << "kpDocument::fill ()";
 #endif
 
-    m_image->fill(color.toQRgb());
+    const int index = kpPixmapFX::isIndexed (*m_image) ?
+        kpPixmapFX::colorTableIndex (*m_image, color) : -1;
+    if (index >= 0) {
+        m_image->fill (uint (index));
+    }
+    else
+    {
+        convertImageToFullColor ();
+        m_image->fill(color.toQRgb());
+    }
     slotContentsChanged (m_image->rect ());
 }
 
@@ -429,6 +510,7 @@ void kpDocument::resize (int w, int h, const kpColor &backgroundColor)
         return;
     }
 
+    convertImageToFullColor ();
     kpPixmapFX::resize (m_image, w, h, backgroundColor);
 
     slotSizeChanged (QSize (width (), height ()));
@@ -43,6 +43,7 @@ class QImage;
 class QIODevice;
 class QPoint;
 class QRect;
+class QRegion;
 class QSize;
 
 class kpColor;
@@ -80,10 +81,14 @@ public:
     //
 
 
+    // The returned image is QImage::Format_ARGB32_Premultiplied unless
+    // <keepIndexed> is set, in which case 1-bit and 8-bit images are
+    // returned in their original indexed format (see kpPixmapFX::isIndexed()).
     static QImage getPixmapFromFile (const QUrl &url, bool suppressDoesntExistDialog,
                                      QWidget *parent,
                                      kpDocumentSaveOptions *saveOptions = nullptr,
-                                     kpDocumentMetaInfo *metaInfo = nullptr);
+                                     kpDocumentMetaInfo *metaInfo = nullptr,
+                                     bool keepIndexed = false);
     // REFACTOR: fix: open*() should only be called once.
     //                Create a new kpDocument() if you want to open again.
     void openNew (const QUrl &url);
@@ -184,10 +189,21 @@ public:
     // Image access
     //
 
+    //
+    // The document's image is stored in its original format if it was opened
+    // from a 1-bit or 8-bit indexed image, to save memory.  It is only
+    // converted to 32-bit when something draws a color that is not in its
+    // color table or needs to paint on it directly.  Apart from
+    // imagePointer(true) and imageWithSelection(), the methods below
+    // always hand out 32-bit images.
+    //
+
     // Returns a copy of part of the document's image (not including the
     // selection).
     kpImage getImageAt (const QRect &rect) const;
 
+    // This keeps indexed storage if all of <image>'s colors are already in
+    // the color table.
     void setImageAt (const kpImage &image, const QPoint &at);
 
     // "image(false)" returns a copy of the document's image, ignoring any
@@ -199,9 +215,17 @@ public:
     //
     // ASSUMPTION: For <ofSelection> == true only, an image selection exists.
     kpImage image (bool ofSelection = false) const;
-    kpImage *imagePointer () const;
+
+    // If <allowIndexed>, the caller must cope with an indexed image (see
+    // kpPixmapFX::isIndexed()).  Otherwise, the document's image is first
+    // converted to 32-bit so that it can be painted on.
+    kpImage *imagePointer (bool allowIndexed = false) const;
 
     void setImage (const kpImage &image);
+    // Same as above but, to save working it out again, the caller passes
+    // where <image> differs from image() e.g. as returned by
+    // kpPixmapFX::changedRegion().
+    void setImage (const kpImage &image, const QRegion &changedRegion);
     // ASSUMPTION: If setting the selection's image, the selection must be
     //             an image selection.
     void setImage (bool ofSelection, const kpImage &image);
@@ -295,8 +319,16 @@ public:
     //
     //    b) with a transparent background: this makes no difference.
     //
+    // If there is no selection, this may be an indexed image (so that saving
+    // it back to the same color depth does not need any conversion).
     kpImage imageWithSelection () const;
 
+    // Same as imageWithSelection() but only returns the part of the
+    // document inside <rect>.  This is much cheaper than
+    // imageWithSelection().copy(<rect>) for small <rect>s as it never
+    // copies the whole document.
+    kpImage imageWithSelection (const QRect &rect) const;
+
 
     /*
      * Transformations
@@ -334,6 +366,9 @@ signals:
     void selectionIsTextChanged (bool isText);
 
 private:
+    // Converts <m_image> to 32-bit if it is indexed.
+    void convertImageToFullColor () const;
+
     int m_constructorWidth, m_constructorHeight;
     kpImage *m_image;
 
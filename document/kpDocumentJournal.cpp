@@ -0,0 +1,615 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_DOCUMENT_JOURNAL 0
+
+
+#include "document/kpDocumentJournal.h"
+
+#include <cstring>
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QLockFile>
+#include <QRegion>
+#include <QSaveFile>
+#include <QStandardPaths>
+#include <QThread>
+#include <QTimer>
+#include <QUrl>
+
+#include "kpLogCategories.h"
+
+#include "document/kpDocument.h"
+#include "document/kpDocumentSaveOptions.h"
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+static const quint32 JournalMagic = 0x4B504A31;  // "KPJ1"
+static const quint32 JournalVersion = 1;
+static const int JournalHeaderBytes = 8;
+
+enum JournalRecordType
+{
+    RecordCheckpoint = 1,
+    RecordRect = 2
+};
+
+// Changes are written after the document has been left alone for this long
+// (so that a brush stroke is one record, not hundreds)...
+static const int FlushDelayMS = 2000;
+
+// ...or, if it is never left alone, at least this often.
+static const int MaxFlushDelayMS = 10000;
+
+// Beyond this many rectangles, the bounding rectangle is written instead.
+static const int MaxRectsPerFlush = 32;
+
+//---------------------------------------------------------------------
+
+static QString JournalDirectory ()
+{
+    return QStandardPaths::writableLocation (QStandardPaths::AppLocalDataLocation) +
+           QLatin1String ("/journal");
+}
+
+//---------------------------------------------------------------------
+
+// The pixels are stored as ARGB32_Premultiplied, compressed.
+static QByteArray CompressPixels (const QImage &image)
+{
+    Q_ASSERT (image.format () == QImage::Format_ARGB32_Premultiplied);
+    Q_ASSERT (image.bytesPerLine () == image.width () * 4);
+
+    return qCompress (image.constBits (), int (image.sizeInBytes ()),
+                      1/*fastest -- this is only for recovery*/);
+}
+
+//---------------------------------------------------------------------
+
+static QImage UncompressPixels (const QByteArray &compressed, int width, int height)
+{
+    const QByteArray pixels = qUncompress (compressed);
+    if (width <= 0 || height <= 0 || pixels.size () != width * height * 4) {
+        return {};
+    }
+
+    QImage image (width, height, QImage::Format_ARGB32_Premultiplied);
+    std::memcpy (image.bits (), pixels.constData (), size_t (pixels.size ()));
+    return image;
+}
+
+//---------------------------------------------------------------------
+
+// The journal file, only accessed by the writer thread.
+struct kpDocumentJournalFile
+{
+    QString path;
+    QFile file;
+
+    qint64 checkpointBytes{0};
+    qint64 bytesSinceCheckpoint{0};
+};
+
+//---------------------------------------------------------------------
+
+static bool WriteHeader (QIODevice *device)
+{
+    QDataStream stream (device);
+    stream << JournalMagic << JournalVersion;
+    return (stream.status () == QDataStream::Ok);
+}
+
+//---------------------------------------------------------------------
+
+static bool WriteRecord (QIODevice *device, quint8 type, const QByteArray &payload)
+{
+    QDataStream stream (device);
+    stream << quint32 (payload.size ()) << type;
+    stream.writeRawData (payload.constData (), payload.size ());
+    return (stream.status () == QDataStream::Ok);
+}
+
+//---------------------------------------------------------------------
+
+// Empties the journal.
+static void ResetJournalFile (kpDocumentJournalFile *journal)
+{
+    journal->file.close ();
+    journal->file.setFileName (journal->path);
+    if (!journal->file.open (QIODevice::WriteOnly | QIODevice::Truncate) ||
+        !::WriteHeader (&journal->file))
+    {
+        qCWarning(kpLogDocument) << "Could not write journal" << journal->path;
+    }
+    journal->file.flush ();
+
+    journal->checkpointBytes = 0;
+    journal->bytesSinceCheckpoint = 0;
+}
+
+//---------------------------------------------------------------------
+
+// Replaces the journal with a checkpoint of <image>.
+static void WriteCheckpoint (kpDocumentJournalFile *journal, const QImage &image,
+        const QUrl &url, const kpDocumentSaveOptions &saveOptions)
+{
+    KP_TRACE_SCOPE ("document", "kpDocumentJournal WriteCheckpoint");
+
+    const QImage pixels = image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+
+    QByteArray payload;
+    {
+        QDataStream stream (&payload, QIODevice::WriteOnly);
+        stream << url << saveOptions.mimeType ()
+               << qint32 (saveOptions.colorDepth ()) << saveOptions.dither ()
+               << qint32 (saveOptions.quality ())
+               << qint32 (pixels.width ()) << qint32 (pixels.height ())
+               << ::CompressPixels (pixels);
+    }
+
+    // Write the new journal beside the old one so that there is always a
+    // recoverable journal, even if we crash right now.
+    journal->file.close ();
+
+    QSaveFile saveFile (journal->path);
+    if (!saveFile.open (QIODevice::WriteOnly) ||
+        !::WriteHeader (&saveFile) ||
+        !::WriteRecord (&saveFile, RecordCheckpoint, payload) ||
+        !saveFile.commit ())
+    {
+        qCWarning(kpLogDocument) << "Could not write journal checkpoint" << journal->path;
+    }
+
+    journal->file.setFileName (journal->path);
+    if (!journal->file.open (QIODevice::WriteOnly | QIODevice::Append)) {
+        qCWarning(kpLogDocument) << "Could not reopen journal" << journal->path;
+    }
+
+    journal->checkpointBytes = payload.size ();
+    journal->bytesSinceCheckpoint = 0;
+}
+
+//---------------------------------------------------------------------
+
+// Appends the pixels of the rectangle <rect>, <image>, to the journal.
+static void WriteRect (kpDocumentJournalFile *journal, const QRect &rect,
+        const QImage &image)
+{
+    const QImage pixels = image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+
+    QByteArray payload;
+    {
+        QDataStream stream (&payload, QIODevice::WriteOnly);
+        stream << rect << ::CompressPixels (pixels);
+    }
+
+    if (!::WriteRecord (&journal->file, RecordRect, payload)) {
+        qCWarning(kpLogDocument) << "Could not append to journal" << journal->path;
+    }
+
+    journal->bytesSinceCheckpoint += payload.size ();
+}
+
+//---------------------------------------------------------------------
+
+struct kpDocumentJournalPrivate
+{
+    kpDocument *document{nullptr};
+
+    // Stops other KolourPaint instances from treating the journal as
+    // orphaned.
+    QLockFile *lockFile{nullptr};
+
+    // The writer thread and an object living in it, to queue work onto.
+    QThread *writerThread{nullptr};
+    QObject *writer{nullptr};
+    kpDocumentJournalFile *journal{nullptr};
+
+    QTimer *flushTimer{nullptr};
+    QRegion dirtyRegion;
+    // Started by the first change since the last flush.
+    QElapsedTimer dirtyTimer;
+
+    // Whether the next write must be a checkpoint because the records
+    // since the last one do not describe the document anymore.
+    bool needsCheckpoint{true};
+
+    // Set by the writer thread once the records since the last checkpoint
+    // take up more space than the checkpoint.
+    QAtomicInt wantsCompaction{0};
+};
+
+//---------------------------------------------------------------------
+
+kpDocumentJournal::kpDocumentJournal (kpDocument *document, QObject *parent)
+    : QObject (parent),
+      d (new kpDocumentJournalPrivate ())
+{
+    Q_ASSERT (document);
+    d->document = document;
+
+    static int journalCount = 0;
+
+    QDir ().mkpath (::JournalDirectory ());
+    const QString path = ::JournalDirectory () +
+        QStringLiteral ("/%1-%2-%3.kpjournal")
+            .arg (QCoreApplication::applicationPid ())
+            .arg (QDateTime::currentMSecsSinceEpoch ())
+            .arg (++journalCount);
+
+    d->lockFile = new QLockFile (path + QLatin1String (".lock"));
+    // (never stale while we are running -- see orphanedJournals())
+    d->lockFile->setStaleLockTime (0);
+    if (!d->lockFile->tryLock (0)) {
+        qCWarning(kpLogDocument) << "Could not lock journal" << path;
+    }
+
+    d->journal = new kpDocumentJournalFile ();
+    d->journal->path = path;
+
+    d->writerThread = new QThread (this);
+    d->writerThread->setObjectName (QStringLiteral ("kpDocumentJournal"));
+    d->writer = new QObject ();
+    d->writer->moveToThread (d->writerThread);
+    d->writerThread->start (QThread::LowPriority);
+
+    kpDocumentJournalFile *journal = d->journal;
+    QMetaObject::invokeMethod (d->writer, [journal] ()
+    {
+        ::ResetJournalFile (journal);
+    }, Qt::QueuedConnection);
+
+    d->flushTimer = new QTimer (this);
+    d->flushTimer->setSingleShot (true);
+    connect (d->flushTimer, &QTimer::timeout, this, &kpDocumentJournal::flush);
+
+    connect (document, &kpDocument::contentsChanged,
+             this, &kpDocumentJournal::slotContentsChanged);
+    connect (document, static_cast<void (kpDocument::*)(const QSize &)>(&kpDocument::sizeChanged),
+             this, &kpDocumentJournal::slotSizeChanged);
+    connect (document, &kpDocument::documentSaved,
+             this, &kpDocumentJournal::slotDocumentSaved);
+}
+
+//---------------------------------------------------------------------
+
+kpDocumentJournal::~kpDocumentJournal ()
+{
+    // The document is being closed normally so there is nothing to recover.
+    // This waits for the writer thread to finish the work queued before it.
+    kpDocumentJournalFile *journal = d->journal;
+    QMetaObject::invokeMethod (d->writer, [journal] ()
+    {
+        journal->file.close ();
+        QFile::remove (journal->path);
+    }, Qt::BlockingQueuedConnection);
+
+    d->writerThread->quit ();
+    d->writerThread->wait ();
+
+    delete d->writer;
+    delete d->journal;
+
+    // (removes the lock file)
+    delete d->lockFile;
+
+    delete d;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpDocumentJournal::checkpoint ()
+{
+    d->needsCheckpoint = true;
+    d->dirtyRegion = d->document->rect ();
+    flush ();
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentJournal::slotContentsChanged (const QRect &rect)
+{
+    if (d->dirtyRegion.isEmpty ()) {
+        d->dirtyTimer.start ();
+    }
+    d->dirtyRegion += rect;
+
+    // Wait until the document has been left alone for FlushDelayMS.
+    const int maxDelay = MaxFlushDelayMS - int (d->dirtyTimer.elapsed ());
+    d->flushTimer->start (qBound (0, maxDelay, FlushDelayMS));
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentJournal::slotSizeChanged ()
+{
+    d->needsCheckpoint = true;
+    slotContentsChanged (d->document->rect ());
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentJournal::slotDocumentSaved ()
+{
+    // The saved file has everything.
+    d->flushTimer->stop ();
+    d->dirtyRegion = QRegion ();
+    d->needsCheckpoint = true;
+
+    kpDocumentJournalFile *journal = d->journal;
+    QMetaObject::invokeMethod (d->writer, [journal] ()
+    {
+        ::ResetJournalFile (journal);
+    }, Qt::QueuedConnection);
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpDocumentJournal::flush ()
+{
+    KP_TRACE_SCOPE ("document", "kpDocumentJournal::flush");
+
+    d->flushTimer->stop ();
+
+    const QRect docRect = d->document->rect ();
+    const QRegion dirtyRegion = d->dirtyRegion.intersected (docRect);
+    d->dirtyRegion = QRegion ();
+
+    if (dirtyRegion.isEmpty ()) {
+        return;
+    }
+
+    kpDocumentJournalFile *journal = d->journal;
+
+    // Opening a document or undoing back to the saved state does not
+    // leave anything to recover.
+    if (!d->document->isModified ())
+    {
+        if (!d->needsCheckpoint)
+        {
+            QMetaObject::invokeMethod (d->writer, [journal] ()
+            {
+                ::ResetJournalFile (journal);
+            }, Qt::QueuedConnection);
+        }
+
+        d->needsCheckpoint = true;
+        return;
+    }
+
+    const bool writeCheckpoint =
+        (d->needsCheckpoint ||
+         d->wantsCompaction.loadAcquire () ||
+         dirtyRegion == QRegion (docRect));
+
+#if DEBUG_KP_DOCUMENT_JOURNAL
+    qCDebug(kpLogDocument) << "kpDocumentJournal::flush() dirty="
+                           << dirtyRegion.boundingRect ()
+                           << "checkpoint=" << writeCheckpoint;
+#endif
+
+    if (writeCheckpoint)
+    {
+        // (shares the pixels until the document next changes)
+        const QImage image = d->document->image ();
+        const QUrl url = d->document->url ();
+        const kpDocumentSaveOptions saveOptions = *d->document->saveOptions ();
+
+        QMetaObject::invokeMethod (d->writer, [journal, image, url, saveOptions] ()
+        {
+            ::WriteCheckpoint (journal, image, url, saveOptions);
+        }, Qt::QueuedConnection);
+
+        d->needsCheckpoint = false;
+        d->wantsCompaction.storeRelease (0);
+        return;
+    }
+
+    QVector <QRect> rects;
+    if (dirtyRegion.rectCount () > MaxRectsPerFlush) {
+        rects.append (dirtyRegion.boundingRect ());
+    }
+    else {
+        for (const auto &rect : dirtyRegion) {
+            rects.append (rect);
+        }
+    }
+
+    QVector <QImage> images;
+    for (const auto &rect : rects) {
+        images.append (d->document->getImageAt (rect));
+    }
+
+    QAtomicInt *wantsCompaction = &d->wantsCompaction;
+    QMetaObject::invokeMethod (d->writer,
+        [journal, rects, images, wantsCompaction] ()
+    {
+        for (int i = 0; i < rects.size (); i++) {
+            ::WriteRect (journal, rects [i], images [i]);
+        }
+        journal->file.flush ();
+
+        if (journal->bytesSinceCheckpoint > journal->checkpointBytes) {
+            wantsCompaction->storeRelease (1);
+        }
+    }, Qt::QueuedConnection);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QStringList kpDocumentJournal::orphanedJournals ()
+{
+    const QDir dir (::JournalDirectory ());
+
+    QStringList paths;
+    for (const auto &fileInfo : dir.entryInfoList (
+             QStringList (QStringLiteral ("*.kpjournal")), QDir::Files, QDir::Time))
+    {
+        const QString path = fileInfo.absoluteFilePath ();
+
+        // A journal is in use for as long as its lock is held.  QLockFile
+        // treats the lock of a process that is no longer running as stale.
+        //
+        // By default, it would also treat any lock older than 30 seconds as
+        // stale, even if its process were still running, so turn that off.
+        QLockFile lockFile (path + QLatin1String (".lock"));
+        lockFile.setStaleLockTime (0);
+        if (!lockFile.tryLock (0)) {
+            continue;
+        }
+        lockFile.unlock ();
+
+        // Was the document ever changed?
+        if (fileInfo.size () <= JournalHeaderBytes)
+        {
+            kpDocumentJournal::discard (path);
+            continue;
+        }
+
+        paths.append (path);
+    }
+
+    return paths;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpDocumentJournal::recover (const QString &path,
+        QImage *image, QUrl *url,
+        kpDocumentSaveOptions *saveOptions)
+{
+    KP_TRACE_SCOPE ("document", "kpDocumentJournal::recover");
+
+    Q_ASSERT (image && url && saveOptions);
+
+    QFile file (path);
+    if (!file.open (QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream (&file);
+
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != JournalMagic || version != JournalVersion) {
+        return false;
+    }
+
+    *image = QImage ();
+
+    // Replay the records.  A crash while writing can leave a truncated
+    // record at the end, which is ignored.
+    forever
+    {
+        quint32 payloadSize = 0;
+        quint8 type = 0;
+        stream >> payloadSize >> type;
+        if (stream.status () != QDataStream::Ok ||
+            payloadSize > quint64 (file.size () - file.pos ()))
+        {
+            break;
+        }
+
+        const QByteArray payload = file.read (payloadSize);
+        QDataStream payloadStream (payload);
+
+        if (type == RecordCheckpoint)
+        {
+            QUrl checkpointURL;
+            QString mimeType;
+            qint32 colorDepth = 0, quality = 0, width = 0, height = 0;
+            bool dither = false;
+            QByteArray pixels;
+            payloadStream >> checkpointURL >> mimeType
+                          >> colorDepth >> dither >> quality
+                          >> width >> height >> pixels;
+
+            const QImage checkpointImage = ::UncompressPixels (pixels, width, height);
+            if (payloadStream.status () != QDataStream::Ok || checkpointImage.isNull ()) {
+                break;
+            }
+
+            *image = checkpointImage;
+            *url = checkpointURL;
+            *saveOptions = kpDocumentSaveOptions (mimeType, colorDepth, dither, quality);
+        }
+        else if (type == RecordRect && !image->isNull ())
+        {
+            QRect rect;
+            QByteArray pixels;
+            payloadStream >> rect >> pixels;
+
+            const QImage rectImage = ::UncompressPixels (pixels,
+                rect.width (), rect.height ());
+            if (payloadStream.status () != QDataStream::Ok || rectImage.isNull () ||
+                !image->rect ().contains (rect))
+            {
+                break;
+            }
+
+            for (int y = 0; y < rect.height (); y++)
+            {
+                std::memcpy (image->scanLine (rect.y () + y) + rect.x () * 4,
+                             rectImage.constScanLine (y),
+                             size_t (rect.width ()) * 4);
+            }
+        }
+    }
+
+#if DEBUG_KP_DOCUMENT_JOURNAL
+    qCDebug(kpLogDocument) << "kpDocumentJournal::recover(" << path << ") image="
+                           << image->size () << "url=" << *url;
+#endif
+
+    return !image->isNull ();
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpDocumentJournal::discard (const QString &path)
+{
+    QFile::remove (path);
+    QFile::remove (path + QLatin1String (".lock"));
+}
+
+//---------------------------------------------------------------------
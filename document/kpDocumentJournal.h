@@ -0,0 +1,111 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpDocumentJournal_H
+#define kpDocumentJournal_H
+
+
+#include <QObject>
+#include <QStringList>
+
+
+class QImage;
+class QRect;
+class QUrl;
+
+class kpDocument;
+class kpDocumentSaveOptions;
+
+
+//
+// Append-only journal of a document's unsaved changes, so that they can be
+// recovered if KolourPaint crashes.
+//
+// The journal starts with a checkpoint -- a full copy of the document's
+// image, written at the first change after the document was opened or
+// saved -- followed by the pixels of each rectangle that has changed since.
+// So after the checkpoint, the cost of journaling is proportional to the
+// size of the edits, not the size of the image.  Changes are collected
+// for a short while before being written, so that e.g. a whole brush
+// stroke is written as one record.
+//
+// Once the records after the checkpoint become larger than the checkpoint
+// itself, or the document is resized, the journal is compacted by writing
+// a new checkpoint in their place.
+//
+// Records are compressed and written in a background thread.
+//
+// Only the document's image is journaled -- a floating selection is only
+// recorded once it is deselected.
+//
+// The journal is deleted when this object is destroyed i.e. when the
+// document is closed normally.  Journals left behind by KolourPaint
+// instances that have exited without doing so are returned by
+// orphanedJournals().
+//
+class kpDocumentJournal : public QObject
+{
+Q_OBJECT
+
+public:
+    kpDocumentJournal (kpDocument *document, QObject *parent = nullptr);
+    ~kpDocumentJournal () override;
+
+    // Writes a new checkpoint as soon as possible, even if the document
+    // has not been changed (e.g. after recovering a document, so that it
+    // can be recovered again).
+    void checkpoint ();
+
+
+    // Returns the paths of the journals whose KolourPaint instance is no
+    // longer running.
+    static QStringList orphanedJournals ();
+
+    // Replays the journal at <path>, setting <image> to the recovered
+    // image and <url> and <saveOptions> to those of the document at the
+    // time.  Returns false if the journal contains nothing that can be
+    // recovered.
+    static bool recover (const QString &path,
+                         QImage *image, QUrl *url,
+                         kpDocumentSaveOptions *saveOptions);
+
+    // Deletes the journal at <path>.
+    static void discard (const QString &path);
+
+private slots:
+    void slotContentsChanged (const QRect &rect);
+    void slotSizeChanged ();
+    void slotDocumentSaved ();
+
+    void flush ();
+
+private:
+    struct kpDocumentJournalPrivate * const d;
+};
+
+
+#endif  // kpDocumentJournal_H
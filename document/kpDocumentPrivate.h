@@ -30,17 +30,26 @@
 #define kpDocumentPrivate_H
 
 
+#include "imagelib/kpImage.h"
+
+
 class kpDocumentEnvironment;
 
 
 struct kpDocumentPrivate
 {
     kpDocumentPrivate ()
-      : environ(nullptr)
+      : environ(nullptr),
+        fullColorImageKey(0)
     {
     }
 
     kpDocumentEnvironment *environ;
+
+    // 32-bit copy of an indexed kpDocument::m_image, returned by image().
+    // Only valid while <fullColorImageKey> is m_image's QImage::cacheKey().
+    kpImage fullColorImage;
+    qint64 fullColorImageKey;
 };
 
 
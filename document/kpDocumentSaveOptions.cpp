@@ -31,6 +31,7 @@
 #include "kpDocumentSaveOptions.h"
 
 #include "kpDefs.h"
+#include "imagelib/kpColorCounter.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 #include <KConfigGroup>
@@ -507,7 +508,11 @@ int kpDocumentSaveOptions::isLossyForSaving (const QImage &image) const
 {
     int ret = 0;
 
-    if (mimeTypeMaximumColorDepth () < image.depth ())
+    // An image with few enough colors, and no transparency, can be stored at
+    // a lower color depth than its own without losing anything
+    // (kpDocument::savePixmapToDevice() keeps the exact colors).
+    if (mimeTypeMaximumColorDepth () < image.depth () &&
+        !kpColorCounter::fitsInColorTable (image, mimeTypeMaximumColorDepth ()))
     {
         ret |= MimeTypeMaximumColorDepthLow;
     }
@@ -515,7 +520,8 @@ int kpDocumentSaveOptions::isLossyForSaving (const QImage &image) const
     if (mimeTypeHasConfigurableColorDepth () &&
         !colorDepthIsInvalid () /*REFACTOR: guarantee it is valid*/ &&
         ((colorDepth () < image.depth ()) ||
-         (colorDepth () < 32 && image.hasAlphaChannel())))
+         (colorDepth () < 32 && image.hasAlphaChannel())) &&
+        !kpColorCounter::fitsInColorTable (image, colorDepth ()))
     {
         ret |= ColorDepthLow;
     }
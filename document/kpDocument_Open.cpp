@@ -38,6 +38,7 @@
 #include "document/kpDocumentSaveOptions.h"
 #include "imagelib/kpDocumentMetaInfo.h"
 #include "imagelib/effects/kpEffectReduceColors.h"
+#include "generic/kpTrace.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
 #include "lgpl/generic/kpUrlFormatter.h"
@@ -81,12 +82,18 @@ void kpDocument::getDataFromImage(const QImage &image,
 QImage kpDocument::getPixmapFromFile(const QUrl &url, bool suppressDoesntExistDialog,
                                      QWidget *parent,
                                      kpDocumentSaveOptions *saveOptions,
-                                     kpDocumentMetaInfo *metaInfo)
+                                     kpDocumentMetaInfo *metaInfo,
+                                     bool keepIndexed)
 {
 #if DEBUG_KP_DOCUMENT
     qCDebug(kpLogDocument) << "kpDocument::getPixmapFromFile(" << url << "," << parent << ")";
 #endif
 
+    kpTraceScope traceScope ("document", "kpDocument::getPixmapFromFile");
+    if (kpTrace::isEnabled ()) {
+        traceScope.setDetail (url.toDisplayString ());
+    }
+
     if (saveOptions) {
         *saveOptions = kpDocumentSaveOptions ();
     }
@@ -162,6 +169,15 @@ QImage kpDocument::getPixmapFromFile(const QUrl &url, bool suppressDoesntExistDi
         getDataFromImage(image, *saveOptions, *metaInfo);
     }
 
+    // Keeping 1-bit and 8-bit images indexed uses a lot less memory.  kpDocument
+    // converts them when needed.
+    if ( keepIndexed && kpPixmapFX::isIndexed(image) ) {
+      if ( image.format() == QImage::Format_Mono ) {
+        image = image.convertToFormat(QImage::Format_MonoLSB);
+      }
+      return image;
+    }
+
     // make sure we always have Format_ARGB32_Premultiplied as this is the fastest to draw on
     // and Qt can not draw onto Format_Indexed8 (Qt-4.7)
     if ( image.format() != QImage::Format_ARGB32_Premultiplied ) {
@@ -217,12 +233,14 @@ bool kpDocument::open (const QUrl &url, bool newDocSameNameIfNotExist)
         newDocSameNameIfNotExist/*suppress "doesn't exist" dialog*/,
         d->environ->dialogParent (),
         &newSaveOptions,
-        &newMetaInfo);
+        &newMetaInfo,
+        true/*keep indexed*/);
 
     if (!newPixmap.isNull ())
     {
         delete m_image;
         m_image = new kpImage (newPixmap);
+        d->fullColorImage = kpImage ();
 
         setURL (url, true/*is from url*/);
         *m_saveOptions = newSaveOptions;
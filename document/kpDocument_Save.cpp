@@ -53,12 +53,15 @@
 #include <KMessageBox>
 
 #include "imagelib/kpColor.h"
+#include "imagelib/kpColorCounter.h"
 #include "widgets/toolbars/kpColorToolBar.h"
 #include "kpDefs.h"
 #include "environments/document/kpDocumentEnvironment.h"
 #include "document/kpDocumentSaveOptions.h"
 #include "imagelib/kpDocumentMetaInfo.h"
+#include "imagelib/kpPNGWriter.h"
 #include "imagelib/effects/kpEffectReduceColors.h"
+#include "generic/kpTrace.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
 #include "widgets/toolbars/kpToolToolBar.h"
@@ -159,6 +162,35 @@ bool kpDocument::lossyPromptContinue (const QImage &pixmap,
 
 //---------------------------------------------------------------------
 
+// Returns <image> at <depth> (1 or 8) with exactly its own colors as the
+// color table, or a null image if it has too many colors for that or has
+// partially transparent ones.
+static QImage ImageWithExactColorTable (const QImage &image, int depth)
+{
+    if (depth != 1 && depth != 8) {
+        return {};
+    }
+
+    QVector <QRgb> colors;
+    if (!kpColorCounter::distinctColors (image, 1 << depth, &colors)) {
+        return {};
+    }
+
+    // (partially transparent colors can't be kept by
+    //  kpEffectReduceColors::convertImageDepth() either but don't change
+    //  its results)
+    for (const QRgb color : colors)
+    {
+        if (qAlpha (color) != 0 && qAlpha (color) != 255) {
+            return {};
+        }
+    }
+
+    return kpColorCounter::toIndexed (image, colors, depth);
+}
+
+//---------------------------------------------------------------------
+
 // public static
 bool kpDocument::savePixmapToDevice (const QImage &image,
                                      QIODevice *device,
@@ -168,6 +200,11 @@ bool kpDocument::savePixmapToDevice (const QImage &image,
                                      QWidget *parent,
                                      bool *userCancelled)
 {
+    kpTraceScope traceScope ("document", "kpDocument::savePixmapToDevice");
+    if (kpTrace::isEnabled ()) {
+        traceScope.setDetail (saveOptions.mimeType ());
+    }
+
     if (userCancelled)
         *userCancelled = false;
 
@@ -223,9 +260,22 @@ bool kpDocument::savePixmapToDevice (const QImage &image,
         //
         //       Later: I think the mask is preserved for 8-bit since Qt4
         //              seems to support it for QImage.
-        imageToSave = kpEffectReduceColors::convertImageDepth (imageToSave,
-                                           saveOptions.colorDepth (),
-                                           saveOptions.dither ());
+        //
+        // If the image already has few enough colors, keep exactly those
+        // colors.  This is lossless, unlike convertImageDepth(), and a lot
+        // faster than dithering.  (The Reduce Colors effect does not do
+        // this, so that e.g. dithering a 2 color image to monochrome still
+        // makes it black and white.)
+        const QImage exactImage = ::ImageWithExactColorTable (imageToSave,
+            saveOptions.colorDepth ());
+        if (!exactImage.isNull ()) {
+            imageToSave = exactImage;
+        }
+        else {
+            imageToSave = kpEffectReduceColors::convertImageDepth (imageToSave,
+                                               saveOptions.colorDepth (),
+                                               saveOptions.dither ());
+        }
     }
 
 
@@ -252,7 +302,23 @@ bool kpDocument::savePixmapToDevice (const QImage &image,
 #if DEBUG_KP_DOCUMENT
     qCDebug(kpLogDocument) << "\tsaving";
 #endif
-    if (!imageToSave.save (device, type.toLatin1 (), quality))
+    // Large 32-bit PNGs are slow to compress on a single core.
+    if (saveOptions.mimeType () == QLatin1String ("image/png") &&
+        kpPNGWriter::canWrite (imageToSave))
+    {
+        // (same quality to zlib level mapping as Qt's PNG plugin)
+        const int compressionLevel =
+            (quality < 0) ? -1 : (100 - qMin (quality, 100)) * 9 / 91;
+
+        if (!kpPNGWriter::write (imageToSave, device, compressionLevel))
+        {
+        #if DEBUG_KP_DOCUMENT
+            qCDebug(kpLogDocument) << "\tkpPNGWriter::write() returned false";
+        #endif
+            return false;
+        }
+    }
+    else if (!imageToSave.save (device, type.toLatin1 (), quality))
     {
     #if DEBUG_KP_DOCUMENT
         qCDebug(kpLogDocument) << "\tQImage::save() returned false";
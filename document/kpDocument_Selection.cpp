@@ -43,6 +43,7 @@
 #include "imagelib/kpColor.h"
 #include "kpDefs.h"
 #include "environments/document/kpDocumentEnvironment.h"
+#include "pixmapfx/kpPixmapFX.h"
 #include "layers/selections/kpAbstractSelection.h"
 #include "layers/selections/image/kpAbstractImageSelection.h"
 #include "layers/selections/text/kpTextSelection.h"
@@ -233,10 +234,31 @@ void kpDocument::imageSelectionPullFromDocument (const kpColor &backgroundColor)
     eraseImage.fill(backgroundColor.toQRgb());
 
     // only paint the region of the shape of the selection
-    QPainter painter(m_image);
-    painter.setClipRegion(imageSel->shapeRegion());
-    painter.setCompositionMode(QPainter::CompositionMode_Source);
-    painter.drawImage(boundingRect.topLeft(), eraseImage);
+    if (kpPixmapFX::isIndexed (*m_image))
+    {
+        // (QPainter can't paint on indexed images so paint on a 32-bit copy
+        //  of the area and then try to keep the document indexed)
+        kpImage area = getImageAt (boundingRect);
+        {
+            QPainter painter(&area);
+            painter.setClipRegion(imageSel->shapeRegion().translated(-boundingRect.topLeft()));
+            painter.setCompositionMode(QPainter::CompositionMode_Source);
+            painter.drawImage(0, 0, eraseImage);
+        }
+
+        if (!kpPixmapFX::setIndexedPixmapAt (m_image, boundingRect.topLeft (), area))
+        {
+            convertImageToFullColor ();
+            kpPixmapFX::setPixmapAt (m_image, boundingRect.topLeft (), area);
+        }
+    }
+    else
+    {
+        QPainter painter(m_image);
+        painter.setClipRegion(imageSel->shapeRegion());
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(boundingRect.topLeft(), eraseImage);
+    }
     slotContentsChanged(boundingRect);
 
     d->environ->restoreQueueViewUpdates ();
@@ -286,19 +308,36 @@ void kpDocument::selectionCopyOntoDocument (bool applySelTransparency)
     const QRect boundingRect = m_selection->boundingRect ();
     Q_ASSERT (boundingRect.isValid ());
 
+    // QPainter can't paint on indexed images so paint on a 32-bit copy of
+    // the area instead and then try to keep the document indexed.
+    const bool isIndexed = kpPixmapFX::isIndexed (*m_image);
+    kpImage area;
+    if (isIndexed) {
+        area = getImageAt (boundingRect);
+    }
+    kpImage * const dest = isIndexed ? &area : m_image;
+    const QRect destRect = isIndexed ? boundingRect : rect ();
+
     if (imageSelection ())
     {
         if (applySelTransparency) {
-            imageSelection ()->paint (m_image, rect ());
+            imageSelection ()->paint (dest, destRect);
         }
         else {
-            imageSelection ()->paintWithBaseImage (m_image, rect ());
+            imageSelection ()->paintWithBaseImage (dest, destRect);
         }
     }
     else
     {
         // (for antialiasing with background)
-        m_selection->paint (m_image, rect ());
+        m_selection->paint (dest, destRect);
+    }
+
+    if (isIndexed &&
+        !kpPixmapFX::setIndexedPixmapAt (m_image, boundingRect.topLeft (), area))
+    {
+        convertImageToFullColor ();
+        kpPixmapFX::setPixmapAt (m_image, boundingRect.topLeft (), area);
     }
 
     slotContentsChanged (boundingRect);
@@ -332,6 +371,9 @@ kpImage kpDocument::imageWithSelection () const
         qCDebug(kpLogDocument) << "\tselection @ " << m_selection->boundingRect ();
     #endif
         kpImage output = *m_image;
+        if (kpPixmapFX::isIndexed (output)) {
+            output = output.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+        }
 
         // (this is a NOP for image selections without content)
         m_selection->paint (&output, rect ());
@@ -348,3 +390,22 @@ kpImage kpDocument::imageWithSelection () const
 }
 
 //---------------------------------------------------------------------
+
+// public
+kpImage kpDocument::imageWithSelection (const QRect &rect) const
+{
+#if DEBUG_KP_DOCUMENT && 1
+    qCDebug(kpLogDocument) << "kpDocument::imageWithSelection(" << rect << ")";
+#endif
+
+    kpImage output = getImageAt (rect);
+
+    // (this is a NOP for image selections without content or outside <rect>)
+    if (m_selection) {
+        m_selection->paint (&output, rect);
+    }
+
+    return output;
+}
+
+//---------------------------------------------------------------------
@@ -28,7 +28,9 @@
 
 #include "environments/dialogs/imagelib/transforms/kpTransformDialogEnvironment.h"
 
+#include "lgpl/generic/kpColorCollection.h"
 #include "mainWindow/kpMainWindow.h"
+#include "widgets/kpColorCells.h"
 
 
 //---------------------------------------------------------------------
@@ -40,3 +42,26 @@ kpTransformDialogEnvironment::kpTransformDialogEnvironment(kpMainWindow *mainWin
 
 //---------------------------------------------------------------------
 
+// public
+QVector <QRgb> kpTransformDialogEnvironment::paletteColors () const
+{
+    QVector <QRgb> colors;
+
+    const kpColorCells *colorCells = mainWindow ()->colorCells ();
+    if (!colorCells) {
+        return colors;
+    }
+
+    const kpColorCollection *colorCol = colorCells->colorCollection ();
+    for (int i = 0; i < colorCol->count (); i++)
+    {
+        const QColor color = colorCol->color (i);
+        if (color.isValid ()) {
+            colors.append (color.rgba ());
+        }
+    }
+
+    return colors;
+}
+
+//---------------------------------------------------------------------
@@ -30,6 +30,9 @@
 #define kpTransformDialogEnvironment_H
 
 
+#include <QRgb>
+#include <QVector>
+
 #include "environments/kpEnvironmentBase.h"
 
 
@@ -45,6 +48,10 @@ public:
     //       classes we are trying to hide as that would defeat the point of
     //       the facade.
     kpTransformDialogEnvironment (kpMainWindow *mainWindow);
+
+    // The valid colors of the color palette in the Color Box (for effects
+    // that reduce images to those colors).
+    QVector <QRgb> paletteColors () const;
 };
 
 
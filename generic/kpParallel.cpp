@@ -0,0 +1,154 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "generic/kpParallel.h"
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QRunnable>
+#include <QSharedPointer>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+//---------------------------------------------------------------------
+
+namespace
+{
+
+struct BandState
+{
+    // Only dereferenced while a band is being processed, which the caller
+    // of kpParallel::forBands() always waits for.
+    const std::function <void (int, int)> *func;
+
+    int count;
+    int bandSize;
+    int numBands;
+
+    QAtomicInt nextBand;
+    QAtomicInt numBandsDone;
+
+    QMutex mutex;
+    QWaitCondition allBandsDone;
+};
+
+// Claims and processes bands until there are none left.
+void ProcessBands (BandState *state)
+{
+    for (;;)
+    {
+        const int band = state->nextBand.fetchAndAddOrdered (1);
+        if (band >= state->numBands) {
+            return;
+        }
+
+        const int begin = band * state->bandSize;
+        const int end = qMin (begin + state->bandSize, state->count);
+        (*state->func) (begin, end);
+
+        if (state->numBandsDone.fetchAndAddOrdered (1) + 1 == state->numBands)
+        {
+            QMutexLocker lock (&state->mutex);
+            state->allBandsDone.wakeAll ();
+        }
+    }
+}
+
+class BandRunnable : public QRunnable
+{
+public:
+    explicit BandRunnable (const QSharedPointer <BandState> &state)
+        : m_state (state)
+    {
+    }
+
+    void run () override
+    {
+        ::ProcessBands (m_state.data ());
+    }
+
+private:
+    // Shared since we might only start running after forBands() has
+    // returned, by which time there is nothing left for us to do.
+    QSharedPointer <BandState> m_state;
+};
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+// public static
+void kpParallel::forBands (int count, int minBandSize,
+                           const std::function <void (int begin, int end)> &func)
+{
+    if (count <= 0) {
+        return;
+    }
+
+    minBandSize = qMax (1, minBandSize);
+
+    const int numThreads = kpParallel::maxThreadCount ();
+
+    // A few bands per thread so that a slow band does not hold up the rest.
+    const int numBands = qMin ((count + minBandSize - 1) / minBandSize,
+                               numThreads * 4);
+    if (numThreads <= 1 || numBands <= 1)
+    {
+        func (0, count);
+        return;
+    }
+
+    QSharedPointer <BandState> state (new BandState ());
+    state->func = &func;
+    state->count = count;
+    state->bandSize = (count + numBands - 1) / numBands;
+    state->numBands = (count + state->bandSize - 1) / state->bandSize;
+
+    QThreadPool *pool = QThreadPool::globalInstance ();
+    for (int i = 0; i < qMin (numThreads - 1, state->numBands - 1); i++) {
+        pool->start (new BandRunnable (state));
+    }
+
+    ::ProcessBands (state.data ());
+
+    QMutexLocker lock (&state->mutex);
+    while (state->numBandsDone.loadAcquire () < state->numBands) {
+        state->allBandsDone.wait (&state->mutex);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public static
+int kpParallel::maxThreadCount ()
+{
+    return qMax (1, QThreadPool::globalInstance ()->maxThreadCount ());
+}
+
+//---------------------------------------------------------------------
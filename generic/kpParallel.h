@@ -0,0 +1,66 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpParallel_H
+#define kpParallel_H
+
+
+#include <functional>
+
+
+//
+// Helpers for splitting image processing work across threads.
+//
+// Work is shared between QThreadPool::globalInstance() and the calling
+// thread.  The calling thread processes bands too and only waits for bands
+// that other threads have already started, so it is safe to call these
+// from inside a band (e.g. an effect applied by a worker thread) without
+// deadlocking the pool.
+//
+class kpParallel
+{
+public:
+    // Calls <func (begin, end)> for consecutive, non-overlapping sub-ranges
+    // ("bands") of [0, count), each at least <minBandSize> long (except
+    // possibly the last), from multiple threads.  Returns once all of
+    // [0, count) has been processed.
+    //
+    // <func> must only write to data belonging to its own band.
+    //
+    // If <count> is small or only 1 core is available, this simply calls
+    // <func (0, count)>.
+    static void forBands (int count, int minBandSize,
+                          const std::function <void (int begin, int end)> &func);
+
+    // The maximum number of threads that forBands() will use, including
+    // the calling thread.
+    static int maxThreadCount ();
+};
+
+
+#endif  // kpParallel_H
@@ -0,0 +1,60 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "generic/kpRandom.h"
+
+#include <QRandomGenerator>
+
+//---------------------------------------------------------------------
+
+kpRandom::kpRandom (quint32 seed)
+{
+    // Spread <seed> over the whole state with SplitMix64.  Unlike using
+    // <seed> directly, this keeps e.g. seed 0 from producing the all-zero
+    // state, which xoshiro128** can never get out of.
+    quint64 splitMix = seed;
+    for (int i = 0; i < 4; i += 2)
+    {
+        quint64 z = (splitMix += Q_UINT64_C (0x9E3779B97F4A7C15));
+        z = (z ^ (z >> 30)) * Q_UINT64_C (0xBF58476D1CE4E5B9);
+        z = (z ^ (z >> 27)) * Q_UINT64_C (0x94D049BB133111EB);
+        z = z ^ (z >> 31);
+
+        m_state [i] = quint32 (z);
+        m_state [i + 1] = quint32 (z >> 32);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public static
+quint32 kpRandom::newSeed ()
+{
+    return QRandomGenerator::global ()->generate ();
+}
+
+//---------------------------------------------------------------------
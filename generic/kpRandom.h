@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpRandom_H
+#define kpRandom_H
+
+
+#include <QtGlobal>
+
+
+//
+// A small, fast pseudo-random number generator (xoshiro128**).
+//
+// Unlike QRandomGenerator::global(), it is neither shared nor synchronized,
+// and the same seed always produces the same sequence of numbers - so that
+// e.g. a spraycan stroke can be reproduced from its seed.
+//
+class kpRandom
+{
+public:
+    explicit kpRandom (quint32 seed = 0);
+
+    // Returns a different seed each time, for starting a new sequence.
+    static quint32 newSeed ();
+
+    quint32 generate ()
+    {
+        const quint32 result = rotateLeft (m_state [1] * 5, 7) * 9;
+        const quint32 t = m_state [1] << 9;
+
+        m_state [2] ^= m_state [0];
+        m_state [3] ^= m_state [1];
+        m_state [1] ^= m_state [2];
+        m_state [0] ^= m_state [3];
+        m_state [2] ^= t;
+        m_state [3] = rotateLeft (m_state [3], 11);
+
+        return result;
+    }
+
+    // Returns a number in [0, <bound>).
+    quint32 bounded (quint32 bound)
+    {
+        return quint32 ((quint64 (generate ()) * bound) >> 32);
+    }
+
+private:
+    static quint32 rotateLeft (quint32 x, int k)
+    {
+        return (x << k) | (x >> (32 - k));
+    }
+
+    quint32 m_state [4];
+};
+
+
+#endif  // kpRandom_H
@@ -0,0 +1,144 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "generic/kpStartupProfile.h"
+
+#include <cstdio>
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QVector>
+
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+namespace
+{
+
+struct Phase
+{
+    const char *name;
+    qint64 endNsec;
+};
+
+struct ProfileState
+{
+    QElapsedTimer clock;
+    bool enabled = false;
+
+    QVector <Phase> phases;
+};
+
+ProfileState *State ()
+{
+    static ProfileState state;
+    return &state;
+}
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+bool kpStartupProfile::s_finished = false;
+
+//---------------------------------------------------------------------
+
+// public static
+void kpStartupProfile::start ()
+{
+    ::State ()->clock.start ();
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpStartupProfile::enable ()
+{
+    ::State ()->enabled = true;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpStartupProfile::mark (const char *phase)
+{
+    ProfileState *state = ::State ();
+    if (s_finished || !state->clock.isValid ()) {
+        return;
+    }
+
+    const qint64 endNsec = state->clock.nsecsElapsed ();
+
+    if (kpTrace::isEnabled ())
+    {
+        const qint64 startNsec = state->phases.isEmpty () ?
+            0 : state->phases.last ().endNsec;
+        const qint64 durationUsec = (endNsec - startNsec) / 1000;
+        kpTrace::addSpan ("startup", phase,
+                          kpTrace::timestamp () - durationUsec, durationUsec,
+                          QString ());
+    }
+
+    state->phases.append ({phase, endNsec});
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpStartupProfile::finish ()
+{
+    if (s_finished) {
+        return;
+    }
+
+    mark ("first paint");
+    s_finished = true;
+
+    ProfileState *state = ::State ();
+    if (!state->enabled) {
+        return;
+    }
+
+    printf ("startup profile (ms):         phase  cumulative\n");
+
+    qint64 startNsec = 0;
+    for (const auto &phase : state->phases)
+    {
+        printf ("  %-24s %8.1f    %8.1f\n",
+                phase.name,
+                (phase.endNsec - startNsec) / 1e6,
+                phase.endNsec / 1e6);
+        startNsec = phase.endNsec;
+    }
+
+    fflush (stdout);
+
+    state->phases.clear ();
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,75 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpStartupProfile_H
+#define kpStartupProfile_H
+
+
+//
+// Timeline of the phases of startup, up to the first paint of a view, for
+// the --startup-profile command line option e.g.:
+//
+//     kolourpaint --startup-profile big.png
+//
+// prints something like:
+//
+//     startup profile (ms):         phase  cumulative
+//       application                   4.1         4.1
+//       command line                  1.3         5.4
+//       ...
+//       first paint                  21.0       187.5
+//
+// Phases are marked at their end, with mark().  Once finish() has been
+// called (by the first view to paint), everything else is ignored.
+// If tracing is on (see kpTrace.h), the phases are also recorded as
+// "startup" spans.
+//
+class kpStartupProfile
+{
+public:
+    // Starts the clock.  Call this first thing in main().
+    static void start ();
+
+    // Print the timeline when finish() is called.
+    static void enable ();
+
+    // Ends the phase <phase>, which began at the previous mark() or start().
+    //
+    // <phase> is not copied so it must be a string literal.
+    static void mark (const char *phase);
+
+    // Ends the "first paint" phase and, if enable()d, prints the timeline.
+    static void finish ();
+
+    static bool isFinished () { return s_finished; }
+
+private:
+    static bool s_finished;
+};
+
+
+#endif  // kpStartupProfile_H
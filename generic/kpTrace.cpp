@@ -0,0 +1,222 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "generic/kpTrace.h"
+
+#include <QAtomicInt>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QString>
+#include <QVector>
+
+#include "kpLogCategories.h"
+
+//---------------------------------------------------------------------
+
+namespace
+{
+
+struct Span
+{
+    const char *category;
+    const char *name;
+    qint64 startUsec;
+    qint64 durationUsec;
+    int threadID;
+    QString detail;
+};
+
+struct TraceState
+{
+    QString fileName;
+    QElapsedTimer clock;
+
+    QMutex mutex;
+    QVector <Span> spans;
+};
+
+TraceState *State ()
+{
+    static TraceState state;
+    return &state;
+}
+
+// Small, stable per-thread IDs read better in the trace viewer than
+// QThread::currentThreadId().
+int CurrentThreadID ()
+{
+    static QAtomicInt nextThreadID (1);
+    thread_local const int threadID = nextThreadID.fetchAndAddRelaxed (1);
+    return threadID;
+}
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+bool kpTrace::s_enabled = false;
+
+//---------------------------------------------------------------------
+
+// public static
+void kpTrace::initialize ()
+{
+    const QString fileName = qEnvironmentVariable ("KOLOURPAINT_TRACE");
+    if (fileName.isEmpty () || s_enabled) {
+        return;
+    }
+
+    TraceState *state = ::State ();
+    state->fileName = fileName;
+    state->spans.reserve (64 * 1024);
+    state->clock.start ();
+
+    s_enabled = true;
+    qAddPostRoutine (&kpTrace::flush);
+
+    qCDebug(kpLogMisc) << "kpTrace: tracing to" << fileName;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpTrace::flush ()
+{
+    if (!s_enabled) {
+        return;
+    }
+
+    TraceState *state = ::State ();
+
+    QVector <Span> spans;
+    {
+        QMutexLocker lock (&state->mutex);
+        spans = state->spans;
+    }
+
+    QFile file (state->fileName);
+    if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCWarning(kpLogMisc) << "kpTrace: could not open" << state->fileName
+                             << "for writing:" << file.errorString ();
+        return;
+    }
+
+    const qint64 pid = QCoreApplication::applicationPid ();
+
+    file.write ("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+
+    for (int i = 0; i < spans.size (); i++)
+    {
+        const Span &span = spans [i];
+
+        // "X" is a "complete" event: a begin timestamp and a duration.
+        QJsonObject event;
+        event.insert (QStringLiteral ("ph"), QStringLiteral ("X"));
+        event.insert (QStringLiteral ("cat"), QString::fromLatin1 (span.category));
+        event.insert (QStringLiteral ("name"), QString::fromLatin1 (span.name));
+        event.insert (QStringLiteral ("ts"), span.startUsec);
+        event.insert (QStringLiteral ("dur"), span.durationUsec);
+        event.insert (QStringLiteral ("pid"), pid);
+        event.insert (QStringLiteral ("tid"), span.threadID);
+
+        if (!span.detail.isEmpty ())
+        {
+            QJsonObject args;
+            args.insert (QStringLiteral ("detail"), span.detail);
+            event.insert (QStringLiteral ("args"), args);
+        }
+
+        file.write (QJsonDocument (event).toJson (QJsonDocument::Compact));
+        file.write (i + 1 < spans.size () ? ",\n" : "\n");
+    }
+
+    file.write ("]}\n");
+}
+
+//---------------------------------------------------------------------
+
+// public static
+qint64 kpTrace::timestamp ()
+{
+    return ::State ()->clock.nsecsElapsed () / 1000;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpTrace::addSpan (const char *category, const char *name,
+                       qint64 startUsec, qint64 durationUsec,
+                       const QString &detail)
+{
+    if (!s_enabled) {
+        return;
+    }
+
+    const Span span {category, name, startUsec, durationUsec,
+                     ::CurrentThreadID (), detail};
+
+    TraceState *state = ::State ();
+    QMutexLocker lock (&state->mutex);
+    state->spans.append (span);
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpTraceScope::setDetail (const QString &detail)
+{
+    if (m_startUsec < 0) {
+        return;
+    }
+
+    if (!m_detail) {
+        m_detail = new QString (detail);
+    }
+    else {
+        *m_detail = detail;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTraceScope::end ()
+{
+    kpTrace::addSpan (m_category, m_name,
+                      m_startUsec, kpTrace::timestamp () - m_startUsec,
+                      m_detail ? *m_detail : QString ());
+    delete m_detail;
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,138 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpTrace_H
+#define kpTrace_H
+
+
+#include <QtGlobal>
+
+
+class QString;
+
+
+//
+// Always-compiled-in tracing of scoped spans, for profiling release builds
+// without rebuilding them with the DEBUG_KP_* macros.
+//
+// Tracing is off unless, at startup, the environment variable
+// KOLOURPAINT_TRACE is set to the path of a file e.g.:
+//
+//     KOLOURPAINT_TRACE=/tmp/kolourpaint.json kolourpaint big.png
+//
+// In that case, every kpTraceScope records a span and, when the application
+// quits, all spans are written to that file in the Chrome trace-event JSON
+// format (load it in chrome://tracing or https://ui.perfetto.dev/).
+//
+// When tracing is off, a kpTraceScope only costs a test of a static bool.
+//
+// Example Usage:
+//
+//     void method ()
+//     {
+//         KP_TRACE_SCOPE ("imagelib", "kpEffectBalance::applyEffect");
+//
+//         <potentially time-consuming operation>
+//
+//     }   // Stack unwinds, calling the kpTraceScope's destructor,
+//         // which records the span
+//
+// <category> and <name> are not copied so they must be string literals.
+// Use kpTraceScope::setDetail() for anything computed at runtime.
+//
+class kpTrace
+{
+public:
+    // Reads KOLOURPAINT_TRACE and, if set, enables tracing and arranges
+    // for flush() to be called when the QCoreApplication is destroyed.
+    //
+    // Call this once, from main(), after constructing the QApplication.
+    static void initialize ();
+
+    // Writes all spans recorded so far to the trace file.
+    static void flush ();
+
+    static bool isEnabled () { return s_enabled; }
+
+    // Returns the number of microseconds since initialize().
+    static qint64 timestamp ();
+
+    // Records a span.  Thread-safe.
+    static void addSpan (const char *category, const char *name,
+                         qint64 startUsec, qint64 durationUsec,
+                         const QString &detail);
+
+private:
+    static bool s_enabled;
+};
+
+
+class kpTraceScope
+{
+public:
+    kpTraceScope (const char *category, const char *name)
+        : m_category (category),
+          m_name (name),
+          m_startUsec (kpTrace::isEnabled () ? kpTrace::timestamp () : -1),
+          m_detail (nullptr)
+    {
+    }
+
+    ~kpTraceScope ()
+    {
+        if (m_startUsec >= 0) {
+            end ();
+        }
+    }
+
+    // Attaches a string (e.g. a command name or an image size) to the span.
+    // Only call this if kpTrace::isEnabled(), to avoid building <detail>
+    // for nothing.
+    void setDetail (const QString &detail);
+
+private:
+    Q_DISABLE_COPY (kpTraceScope)
+
+    void end ();
+
+    const char * const m_category;
+    const char * const m_name;
+    const qint64 m_startUsec;
+    QString *m_detail;
+};
+
+
+#define KP_TRACE_CONCAT_2(a, b) a##b
+#define KP_TRACE_CONCAT(a, b) KP_TRACE_CONCAT_2 (a, b)
+
+// Records a span from here to the end of the enclosing block.
+#define KP_TRACE_SCOPE(category, name) \
+    kpTraceScope KP_TRACE_CONCAT (kpTraceScope_, __LINE__) (category, name)
+
+
+#endif  // kpTrace_H
@@ -37,14 +37,10 @@
 
 #include "kpLogCategories.h"
 
+#include "generic/kpTrace.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 
-#if DEBUG_KP_EFFECT_BALANCE
-    #include <qdatetime.h>
-#endif
-
-
 static inline int between0And255 (int val)
 {
     if (val < 0) {
@@ -97,13 +93,11 @@ kpImage kpEffectBalance::applyEffect (const kpImage &image,
                << ",contrast=" << contrast
                << ",gamma=" << gamma
                << ")";
-    QTime timer; timer.start ();
 #endif
 
+    KP_TRACE_SCOPE ("imagelib", "kpEffectBalance::applyEffect");
+
     QImage qimage = image;
-#if DEBUG_KP_EFFECT_BALANCE
-    qCDebug(kpLogImagelib) << "\tconvertToImage=" << timer.restart ();
-#endif
 
 
     quint8 transformRed [256],
@@ -136,10 +130,6 @@ kpImage kpEffectBalance::applyEffect (const kpImage &image,
         }
     }
 
-#if DEBUG_KP_EFFECT_BALANCE
-    qCDebug(kpLogImagelib) << "\tbuild lookup=" << timer.restart ();
-#endif
-
 
     if (qimage.depth () > 8)
     {
@@ -33,14 +33,10 @@
 
 #include "kpLogCategories.h"
 
+#include "generic/kpTrace.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 
-#if DEBUG_KP_EFFECT_BLUR_SHARPEN
-    #include <QTime>
-#endif
-
-
 //---------------------------------------------------------------------
 
 //
@@ -135,15 +131,10 @@ static QImage SharpenQImage (const QImage &qimage_, int strength)
 
     for (int i = 0; i < repeat; i++)
     {
-    #if DEBUG_KP_EFFECT_BLUR_SHARPEN
-        QTime timer; timer.start ();
-    #endif
+        KP_TRACE_SCOPE ("imagelib", "Blitz::gaussianSharpen");
+
         qimage = Blitz::gaussianSharpen (qimage, static_cast<float> (radius),
                                          static_cast<float> (sigma));
-    #if DEBUG_KP_EFFECT_BLUR_SHARPEN
-        qCDebug(kpLogImagelib) << "\titeration #" + QString::number (i)
-                  << ": " + QString::number (timer.elapsed ()) << "ms";
-    #endif
     }
 
 
@@ -165,6 +156,8 @@ kpImage kpEffectBlurSharpen::applyEffect (const kpImage &image,
 
     Q_ASSERT (strength >= MinStrength && strength <= MaxStrength);
 
+    KP_TRACE_SCOPE ("imagelib", "kpEffectBlurSharpen::applyEffect");
+
     if (type == Blur) {
         return ::BlurQImage (image, strength);
     }
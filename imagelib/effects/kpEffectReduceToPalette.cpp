@@ -0,0 +1,573 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_EFFECT_REDUCE_TO_PALETTE 0
+
+
+#include "imagelib/effects/kpEffectReduceToPalette.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <QAtomicInteger>
+#include <QScopedPointer>
+#include <QSet>
+#include <QString>
+
+#include "kpLogCategories.h"
+
+#include "generic/kpParallel.h"
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+// Don't bother giving a thread fewer pixels than this.
+static const int MinPixelsPerBand = 64 * 1024;
+
+// When dithering, the image is split into bands of exactly this many rows,
+// however many threads there are, so that the result is the same on every
+// machine.
+static const int DitherRowsPerBand = 128;
+
+// Error diffusion can't carry on from the band above, which another thread
+// may not have done yet.  Instead, each band starts diffusing this many
+// rows above its first row (without writing them) so that, by its first
+// row, the error looks like it came from the band above and there is no
+// visible seam.
+static const int DitherWarmUpRows = 16;
+
+// Images with at least this many pixels share a NearestColorTable between
+// bands (see below).
+static const int MinPixelsForTable = 4 * 1024 * 1024;
+
+//---------------------------------------------------------------------
+
+// Returns the table mapping sRGB components to linear light.
+static const float *SRGBToLinearTable ()
+{
+    static const QVector <float> table = [] ()
+    {
+        QVector <float> ret (256);
+        for (int i = 0; i < 256; i++)
+        {
+            const double c = i / 255.0;
+            ret [i] = static_cast<float> (c <= 0.04045 ?
+                c / 12.92 : std::pow ((c + 0.055) / 1.055, 2.4));
+        }
+        return ret;
+    } ();
+
+    return table.constData ();
+}
+
+//---------------------------------------------------------------------
+
+// Converts <rgb> to Oklab (L, a, b) in <lab>.
+static void ToOklab (QRgb rgb, float lab [3])
+{
+    const float *linear = ::SRGBToLinearTable ();
+    const float r = linear [qRed (rgb)],
+                g = linear [qGreen (rgb)],
+                b = linear [qBlue (rgb)];
+
+    const float l = std::cbrt (0.4122214708f * r + 0.5363325363f * g + 0.0514459929f * b);
+    const float m = std::cbrt (0.2119034982f * r + 0.6806995451f * g + 0.1073969566f * b);
+    const float s = std::cbrt (0.0883024619f * r + 0.2817188376f * g + 0.6299787005f * b);
+
+    lab [0] = 0.2104542553f * l + 0.7936177850f * m - 0.0040720468f * s;
+    lab [1] = 1.9779984951f * l - 2.4285922050f * m + 0.4505937099f * s;
+    lab [2] = 0.0259040371f * l + 0.7827717662f * m - 0.8086757660f * s;
+}
+
+//---------------------------------------------------------------------
+
+namespace
+{
+
+// A k-d tree of palette colors in Oklab, for finding the nearest palette
+// color to any given color without comparing against every palette color.
+//
+// The tree is implicit: the node for [begin, end) of <m_points> is the
+// point at the middle, with its left and right subtrees on either side.
+class PaletteTree
+{
+public:
+    explicit PaletteTree (const QVector <QRgb> &palette)
+    {
+        m_points.reserve (palette.size ());
+        for (int i = 0; i < palette.size (); i++)
+        {
+            Point point;
+            ::ToOklab (palette [i], point.lab);
+            point.rgb = palette [i];
+            point.index = i;
+            point.axis = 0;
+            m_points.append (point);
+        }
+
+        build (0, m_points.size ());
+    }
+
+    bool isEmpty () const
+    {
+        return m_points.isEmpty ();
+    }
+
+    int size () const
+    {
+        return m_points.size ();
+    }
+
+    // Returns the index into the palette of the color that is nearest to
+    // <rgb> (ignoring alpha).
+    int nearestIndex (QRgb rgb) const
+    {
+        return nearestPoint (rgb)->index;
+    }
+
+    // Returns the palette color that is nearest to <rgb> (ignoring alpha).
+    QRgb nearest (QRgb rgb) const
+    {
+        return nearestPoint (rgb)->rgb;
+    }
+
+private:
+    struct Point
+    {
+        float lab [3];
+        QRgb rgb;
+        int index;
+        // The axis that this node splits its subtrees on.
+        int axis;
+    };
+
+    const Point *nearestPoint (QRgb rgb) const
+    {
+        Q_ASSERT (!isEmpty ());
+
+        float lab [3];
+        ::ToOklab (rgb, lab);
+
+        const Point *best = nullptr;
+        float bestDistance = std::numeric_limits <float>::max ();
+        search (0, m_points.size (), lab, &best, &bestDistance);
+
+        return best;
+    }
+
+    void build (int begin, int end)
+    {
+        if (end - begin <= 1) {
+            return;
+        }
+
+        // Split on the axis with the greatest spread.
+        float minLab [3], maxLab [3];
+        std::copy (m_points [begin].lab, m_points [begin].lab + 3, minLab);
+        std::copy (m_points [begin].lab, m_points [begin].lab + 3, maxLab);
+        for (int i = begin + 1; i < end; i++)
+        {
+            for (int c = 0; c < 3; c++)
+            {
+                minLab [c] = qMin (minLab [c], m_points [i].lab [c]);
+                maxLab [c] = qMax (maxLab [c], m_points [i].lab [c]);
+            }
+        }
+
+        int axis = 0;
+        for (int c = 1; c < 3; c++)
+        {
+            if (maxLab [c] - minLab [c] > maxLab [axis] - minLab [axis]) {
+                axis = c;
+            }
+        }
+
+        const int mid = (begin + end) / 2;
+        std::nth_element (m_points.begin () + begin,
+                          m_points.begin () + mid,
+                          m_points.begin () + end,
+                          [axis] (const Point &a, const Point &b)
+                          {
+                              return a.lab [axis] < b.lab [axis];
+                          });
+        m_points [mid].axis = axis;
+
+        build (begin, mid);
+        build (mid + 1, end);
+    }
+
+    void search (int begin, int end, const float lab [3],
+                 const Point **best, float *bestDistance) const
+    {
+        if (begin >= end) {
+            return;
+        }
+
+        const int mid = (begin + end) / 2;
+        const Point &point = m_points [mid];
+
+        const float dl = lab [0] - point.lab [0],
+                    da = lab [1] - point.lab [1],
+                    db = lab [2] - point.lab [2];
+        const float distance = dl * dl + da * da + db * db;
+        if (distance < *bestDistance)
+        {
+            *bestDistance = distance;
+            *best = &point;
+        }
+
+        // Search the side that <lab> is on first and only search the
+        // other side if it could contain something nearer.
+        const float axisDistance = lab [point.axis] - point.lab [point.axis];
+        if (axisDistance < 0)
+        {
+            search (begin, mid, lab, best, bestDistance);
+            if (axisDistance * axisDistance < *bestDistance) {
+                search (mid + 1, end, lab, best, bestDistance);
+            }
+        }
+        else
+        {
+            search (mid + 1, end, lab, best, bestDistance);
+            if (axisDistance * axisDistance < *bestDistance) {
+                search (begin, mid, lab, best, bestDistance);
+            }
+        }
+    }
+
+    QVector <Point> m_points;
+};
+
+// A lookup table of the nearest palette color for every RGB color, filled
+// in as colors are seen, shared by all bands.
+//
+// For big images, this makes sure that each distinct color is only
+// searched for once, however the colors are spread over the bands.
+class NearestColorTable
+{
+public:
+    NearestColorTable (const QVector <QRgb> &palette, const PaletteTree &tree)
+        : m_palette (palette),
+          m_tree (tree),
+          // (zero-initialized i.e. "not searched for yet")
+          m_entries (new QAtomicInteger <quint16> [1 << 24])
+    {
+        Q_ASSERT (palette.size () == tree.size ());
+    }
+
+    // Whether a palette this size fits in a table entry.
+    static bool canHold (int paletteSize)
+    {
+        return paletteSize < 0xFFFF;
+    }
+
+    QRgb nearest (QRgb rgb) const
+    {
+        // (palette index + 1)
+        QAtomicInteger <quint16> &entry = m_entries [rgb & 0xFFFFFF];
+        int value = entry.loadAcquire ();
+
+        // Another band might search for the same color at the same time
+        // but they will both store the same answer.
+        if (value == 0)
+        {
+            value = m_tree.nearestIndex (rgb) + 1;
+            entry.storeRelease (quint16 (value));
+        }
+
+        return m_palette [value - 1];
+    }
+
+private:
+    const QVector <QRgb> &m_palette;
+    const PaletteTree &m_tree;
+    QScopedArrayPointer <QAtomicInteger <quint16> > m_entries;
+};
+
+// Remembers the most recent answers of a NearestColorTable or, if there is
+// none, a PaletteTree.
+//
+// Most images repeat colors a lot (even photos, within a band), so this
+// avoids most of the Oklab conversions and tree searches.  Each band has
+// its own, so that no locking is needed.
+class NearestColorCache
+{
+public:
+    NearestColorCache (const PaletteTree &tree, const NearestColorTable *table)
+        : m_tree (tree),
+          m_table (table)
+    {
+        // Keys always have alpha set (see nearest()) so 0 means "unused".
+        std::fill (m_keys, m_keys + CacheSize, QRgb (0));
+    }
+
+    QRgb nearest (QRgb rgb)
+    {
+        const QRgb key = rgb | 0xFF000000;
+        const uint slot = (key * 2654435761u) >> (32 - CacheBits);
+
+        if (m_keys [slot] != key)
+        {
+            m_keys [slot] = key;
+            m_values [slot] = m_table ? m_table->nearest (key) : m_tree.nearest (key);
+        }
+
+        return m_values [slot];
+    }
+
+private:
+    static const int CacheBits = 14;
+    static const int CacheSize = 1 << CacheBits;
+
+    const PaletteTree &m_tree;
+    const NearestColorTable *m_table;
+    QRgb m_keys [CacheSize];
+    QRgb m_values [CacheSize];
+};
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+// Returns <rgb> (which is opaque) with the alpha of <alpha>, premultiplied.
+static inline QRgb WithAlpha (QRgb rgb, int alpha)
+{
+    return (alpha == 255) ? rgb : qPremultiply (qRgba (qRed (rgb), qGreen (rgb), qBlue (rgb), alpha));
+}
+
+//---------------------------------------------------------------------
+
+// Maps rows [begin, end) of <src> to the image at <destBits> without
+// dithering.
+static void MapRows (const QImage &src, uchar *destBits, int destBytesPerLine,
+                     int begin, int end, NearestColorCache *cache)
+{
+    const int width = src.width ();
+
+    for (int y = begin; y < end; y++)
+    {
+        const auto *srcLine = reinterpret_cast <const QRgb *> (src.constScanLine (y));
+        auto *destLine = reinterpret_cast <QRgb *> (
+            destBits + qint64 (y) * destBytesPerLine);
+
+        for (int x = 0; x < width; x++)
+        {
+            const QRgb pixel = srcLine [x];
+            const int alpha = qAlpha (pixel);
+
+            destLine [x] = (alpha == 0) ?
+                0 : ::WithAlpha (cache->nearest (pixel), alpha);
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Maps rows [begin, end) of <src> to the image at <destBits>, diffusing the
+// error of each pixel to its neighbors (Floyd-Steinberg).  The diffusion
+// starts at row <warmUpBegin> (<= <begin>) but rows before <begin> are not
+// written.
+static void MapRowsDithered (const QImage &src, uchar *destBits, int destBytesPerLine,
+                             int warmUpBegin, int begin, int end,
+                             NearestColorCache *cache)
+{
+    const int width = src.width ();
+
+    // The error diffused to this row and the next, for each of R, G and B,
+    // with a pixel of padding on either side, in 16ths.
+    QVector <int> thisRowError ((width + 2) * 3, 0),
+                  nextRowError ((width + 2) * 3, 0);
+
+    // (somewhere to write the warm up rows to)
+    QVector <QRgb> warmUpLine (begin > warmUpBegin ? width : 0);
+
+    for (int y = warmUpBegin; y < end; y++)
+    {
+        const auto *srcLine = reinterpret_cast <const QRgb *> (src.constScanLine (y));
+        auto *destLine = (y >= begin) ?
+            reinterpret_cast <QRgb *> (destBits + qint64 (y) * destBytesPerLine) :
+            warmUpLine.data ();
+
+        int *thisError = thisRowError.data () + 3;
+        int *nextError = nextRowError.data () + 3;
+        std::fill (nextRowError.begin (), nextRowError.end (), 0);
+
+        for (int x = 0; x < width; x++)
+        {
+            const QRgb pixel = srcLine [x];
+            const int alpha = qAlpha (pixel);
+
+            if (alpha == 0)
+            {
+                destLine [x] = 0;
+                continue;
+            }
+
+            const int wanted [3] = {
+                qBound (0, qRed (pixel) + thisError [x * 3 + 0] / 16, 255),
+                qBound (0, qGreen (pixel) + thisError [x * 3 + 1] / 16, 255),
+                qBound (0, qBlue (pixel) + thisError [x * 3 + 2] / 16, 255)
+            };
+
+            const QRgb got = cache->nearest (qRgb (wanted [0], wanted [1], wanted [2]));
+            destLine [x] = ::WithAlpha (got, alpha);
+
+            const int error [3] = {
+                wanted [0] - qRed (got),
+                wanted [1] - qGreen (got),
+                wanted [2] - qBlue (got)
+            };
+
+            for (int c = 0; c < 3; c++)
+            {
+                thisError [(x + 1) * 3 + c] += error [c] * 7;
+                nextError [(x - 1) * 3 + c] += error [c] * 3;
+                nextError [x * 3 + c] += error [c] * 5;
+                nextError [(x + 1) * 3 + c] += error [c] * 1;
+            }
+        }
+
+        thisRowError.swap (nextRowError);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpEffectReduceToPalette::applyEffect (QImage *destPtr,
+        const QVector <QRgb> &palette, bool dither)
+{
+    if (!destPtr) {
+        return;
+    }
+
+    *destPtr = applyEffect (*destPtr, palette, dither);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QImage kpEffectReduceToPalette::applyEffect (const QImage &image,
+        const QVector <QRgb> &palette, bool dither)
+{
+    kpTraceScope traceScope ("imagelib", "kpEffectReduceToPalette::applyEffect");
+    if (kpTrace::isEnabled ()) {
+        traceScope.setDetail (QString::number (palette.size ()));
+    }
+
+#if DEBUG_KP_EFFECT_REDUCE_TO_PALETTE
+    qCDebug(kpLogImagelib) << "kpEffectReduceToPalette::applyEffect() size="
+                           << image.size () << " palette.size=" << palette.size ()
+                           << " dither=" << dither;
+#endif
+
+    if (image.isNull ()) {
+        return image;
+    }
+
+    // (ignore duplicates, as well as the palette's alpha)
+    QVector <QRgb> colors;
+    QSet <QRgb> seenColors;
+    for (const QRgb rgb : palette)
+    {
+        const QRgb opaque = rgb | 0xFF000000;
+        if (!seenColors.contains (opaque))
+        {
+            seenColors.insert (opaque);
+            colors.append (opaque);
+        }
+    }
+
+    const PaletteTree tree (colors);
+    if (tree.isEmpty ()) {
+        return image;
+    }
+
+    // Work on unpremultiplied pixels directly, rather than through
+    // QImage::pixel() and QImage::setPixel().
+    const QImage src = image.convertToFormat (QImage::Format_ARGB32);
+    QImage dest (src.size (), QImage::Format_ARGB32_Premultiplied);
+
+    // (detach before sharing between threads -- scanLine() would detach
+    //  from each of them)
+    uchar *destBits = dest.bits ();
+    const int destBytesPerLine = dest.bytesPerLine ();
+
+    const int width = src.width ();
+
+    QScopedPointer <NearestColorTable> table;
+    if (qint64 (width) * src.height () >= MinPixelsForTable &&
+        NearestColorTable::canHold (colors.size ()))
+    {
+        table.reset (new NearestColorTable (colors, tree));
+    }
+
+    if (dither)
+    {
+        const int height = src.height ();
+        const int numBands = (height + DitherRowsPerBand - 1) / DitherRowsPerBand;
+        const int minBandsPerThread = qMax (1,
+            MinPixelsPerBand / qMax (1, width * DitherRowsPerBand));
+
+        kpParallel::forBands (numBands, minBandsPerThread,
+            [&] (int beginBand, int endBand)
+        {
+            // (too big for the stack)
+            QScopedPointer <NearestColorCache> cache (
+                new NearestColorCache (tree, table.data ()));
+
+            for (int band = beginBand; band < endBand; band++)
+            {
+                const int begin = band * DitherRowsPerBand;
+                const int end = qMin (begin + DitherRowsPerBand, height);
+
+                ::MapRowsDithered (src, destBits, destBytesPerLine,
+                                   qMax (0, begin - DitherWarmUpRows), begin, end,
+                                   cache.data ());
+            }
+        });
+    }
+    else
+    {
+        kpParallel::forBands (src.height (),
+            qMax (1, MinPixelsPerBand / qMax (1, width)),
+            [&] (int begin, int end)
+        {
+            // (too big for the stack)
+            QScopedPointer <NearestColorCache> cache (
+                new NearestColorCache (tree, table.data ()));
+
+            ::MapRows (src, destBits, destBytesPerLine, begin, end,
+                       cache.data ());
+        });
+    }
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
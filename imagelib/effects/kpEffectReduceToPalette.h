@@ -0,0 +1,60 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpEffectReduceToPalette_H
+#define kpEffectReduceToPalette_H
+
+
+#include <QImage>
+#include <QRgb>
+#include <QVector>
+
+
+//
+// Changes every pixel of an image to the color in a fixed palette (e.g. the
+// colors of the kpColorCollection in the Color Box) that looks the most
+// similar.
+//
+// Similarity is measured in the Oklab color space, where distances match
+// perceived differences much better than in RGB.
+//
+// The alpha of each pixel is kept; only its color changes.  The alpha of
+// the palette colors is ignored.
+//
+class kpEffectReduceToPalette
+{
+public:
+    // If <dither>, the error of each pixel is diffused to its neighbors
+    // (Floyd-Steinberg), so that areas average out to their original color.
+    static void applyEffect (QImage *destPtr, const QVector <QRgb> &palette,
+                             bool dither);
+    static QImage applyEffect (const QImage &image, const QVector <QRgb> &palette,
+                               bool dither);
+};
+
+
+#endif  // kpEffectReduceToPalette_H
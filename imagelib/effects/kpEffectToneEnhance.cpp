@@ -32,9 +32,12 @@
 #include "kpEffectToneEnhance.h"
 
 #include <QImage>
+#include <QVector>
 
 #include "kpLogCategories.h"
 
+#include "generic/kpParallel.h"
+#include "generic/kpTrace.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 
@@ -71,25 +74,39 @@ inline unsigned int AdjustTone(unsigned int color, unsigned int oldTone, unsigne
 
 //---------------------------------------------------------------------
 
+// Minimum number of pixels for each thread to process.
+static const int MinPixelsPerBand = 64 * 1024;
+
+//---------------------------------------------------------------------
+
 class kpEffectToneEnhanceApplier
 {
   public:
     kpEffectToneEnhanceApplier ();
-    ~kpEffectToneEnhanceApplier ();
 
-    void BalanceImageTone(QImage* pImage, double granularity, double amount);
+    // <imageKey> identifies the contents of <pImage> (e.g. QImage::cacheKey()
+    // of the original image) so that the tone maps can be reused when only
+    // <amount> changes.
+    //
+    // ASSUMPTION: <pImage> is QImage::Format_ARGB32.
+    void BalanceImageTone(QImage* pImage, qint64 imageKey, double granularity, double amount);
 
   protected:
     int m_nToneMapGranularity, m_areaWid, m_areaHgt;
-    unsigned int m_nComputedWid, m_nComputedHgt;
-    // LOTODO: Use less error-prone QTL containers instead.
-    unsigned int* m_pHistogram;
-    unsigned int** m_pToneMaps;
-
-    void DeleteToneMaps();
-    unsigned int* MakeToneMap(QImage* pImage, int x, int y, int nGranularity);
-    void ComputeToneMaps(QImage* pImage, int nGranularity);
-    unsigned int InterpolateNewTone(QImage* pImage, unsigned int oldTone, int x, int y, int nGranularity);
+    int m_nComputedWid, m_nComputedHgt;
+    qint64 m_nComputedImageKey;
+
+    // The tone map for area (u, v) is the TONE_MAP_SIZE entries starting at
+    // m_toneMaps [(m_nToneMapGranularity * v + u) * TONE_MAP_SIZE].
+    QVector <unsigned int> m_toneMaps;
+
+    int AreaX(const QImage* pImage, int u, int nGranularity) const;
+    int AreaY(const QImage* pImage, int v, int nGranularity) const;
+    void AddToHistogram(unsigned int* pHistogram, const QVector <quint16> &tones,
+        int imageWid, int x0, int x1, int yy, bool add) const;
+    static void MakeToneMap(const unsigned int* pHistogram, unsigned int* pToneMap);
+    void ComputeToneMaps(const QImage* pImage, const QVector <quint16> &tones,
+        qint64 imageKey, int nGranularity);
 };
 
 //---------------------------------------------------------------------
@@ -101,168 +118,153 @@ kpEffectToneEnhanceApplier::kpEffectToneEnhanceApplier ()
   m_areaHgt = 0;
   m_nComputedWid = 0;
   m_nComputedHgt = 0;
-  m_pHistogram = new unsigned int[TONE_MAP_SIZE];
-  m_pToneMaps = nullptr;
+  m_nComputedImageKey = 0;
 }
 
 //---------------------------------------------------------------------
 
-kpEffectToneEnhanceApplier::~kpEffectToneEnhanceApplier ()
+// protected
+int kpEffectToneEnhanceApplier::AreaX(const QImage* pImage, int u, int nGranularity) const
 {
-  DeleteToneMaps();
-  delete[] m_pHistogram;
+  if(nGranularity <= 1) {
+      return 0;
+  }
+
+  const int xx = u * (pImage->width() - 1) / (nGranularity - 1) - m_areaWid / 2;
+  return qBound(0, xx, pImage->width() - m_areaWid);
 }
 
 //---------------------------------------------------------------------
 
 // protected
-void kpEffectToneEnhanceApplier::DeleteToneMaps()
+int kpEffectToneEnhanceApplier::AreaY(const QImage* pImage, int v, int nGranularity) const
 {
-  int nToneMaps = m_nToneMapGranularity * m_nToneMapGranularity;
-  for(int i = 0; i < nToneMaps; i++) {
-      delete[] m_pToneMaps[i];
+  if(nGranularity <= 1) {
+      return 0;
   }
-  delete[] m_pToneMaps;
-  m_pToneMaps = nullptr;
-  m_nToneMapGranularity = 0;
+
+  // LOTODO: This should surely be the height but the effect has always
+  //         placed its areas like this.
+  const int yy = v * (pImage->width() - 1) / (nGranularity - 1) - m_areaHgt / 2;
+  return qBound(0, yy, pImage->height() - m_areaHgt);
 }
 
 //---------------------------------------------------------------------
 
 // protected
-unsigned int* kpEffectToneEnhanceApplier::MakeToneMap(QImage* pImage, int u, int v, int nGranularity)
+void kpEffectToneEnhanceApplier::AddToHistogram(unsigned int* pHistogram,
+    const QVector <quint16> &tones,
+    int imageWid, int x0, int x1, int yy, bool add) const
 {
-    // Compute the region to make the tone map for
-    int xx, yy;
-    if(nGranularity > 1)
+  for(int y = yy; y < yy + m_areaHgt; y++)
+  {
+    const quint16 *line = tones.constData() + qint64(y) * imageWid;
+    if(add)
     {
-        xx = u * (pImage->width() - 1) / (nGranularity - 1) - m_areaWid / 2;
-        if(xx < 0) {
-            xx = 0;
-        }
-        else if(xx + m_areaWid > pImage->width()) {
-            xx = pImage->width() - m_areaWid;
-        }
-
-        yy = v * (pImage->width() - 1) / (nGranularity - 1) - m_areaHgt / 2;
-
-        if(yy < 0) {
-            yy = 0;
-        }
-        else if(yy + m_areaHgt > pImage->height()) {
-            yy = pImage->height() - m_areaHgt;
-        }
+      for(int x = x0; x < x1; x++) {
+          pHistogram[line[x] >> TONE_DROP_BITS]++;
+      }
     }
     else
     {
-        xx = 0;
-        yy = 0;
-    }
-
-  // Make a tone histogram for the region
-  memset(m_pHistogram, '\0', sizeof(unsigned int) * TONE_MAP_SIZE);
-  int x, y;
-  unsigned int tone;
-  for(y = 0; y < m_areaHgt; y++)
-  {
-    for(x = 0; x < m_areaWid; x++)
-    {
-      tone = ComputeTone(pImage->pixel(xx + x, yy + y));
-      m_pHistogram[tone >> TONE_DROP_BITS]++;
+      for(int x = x0; x < x1; x++) {
+          pHistogram[line[x] >> TONE_DROP_BITS]--;
+      }
     }
   }
+}
 
+//---------------------------------------------------------------------
+
+// protected static
+void kpEffectToneEnhanceApplier::MakeToneMap(const unsigned int* pHistogram, unsigned int* pToneMap)
+{
   // Forward sum the tone histogram
-  int i{};
-  for(i = 1; i < TONE_MAP_SIZE; i++) {
-      m_pHistogram[i] += m_pHistogram[i - 1];
+  unsigned int total = 0;
+  for(int i = 0; i < TONE_MAP_SIZE; i++)
+  {
+      total += pHistogram[i];
+      pToneMap[i] = total;
   }
 
   // Compute the forward contribution to the tone map
-  auto total = m_pHistogram[i - 1];
-  auto *pToneMap = new unsigned int[TONE_MAP_SIZE];
-  for(i = 0; i < TONE_MAP_SIZE; i++) {
-      pToneMap[i] = static_cast<uint> (static_cast<unsigned long long int> (m_pHistogram[i] * MAX_TONE_VALUE / total));
-  }
-/*
-  // Undo the forward sum and reverse sum the tone histogram
-  m_pHistogram[TONE_MAP_SIZE - 1] -= m_pHistogram[TONE_MAP_SIZE - 2];
-  for(i = TONE_MAP_SIZE - 2; i > 0; i--)
-  {
-    m_pHistogram[i] -= m_pHistogram[i - 1];
-    m_pHistogram[i] += m_pHistogram[i + 1];
+  for(int i = 0; i < TONE_MAP_SIZE; i++) {
+      pToneMap[i] = static_cast<uint> (static_cast<unsigned long long int> (pToneMap[i]) * MAX_TONE_VALUE / total);
   }
-  m_pHistogram[0] += m_pHistogram[1];
-*/
-  return pToneMap;
 }
 
 //---------------------------------------------------------------------
 
 // protected
-void kpEffectToneEnhanceApplier::ComputeToneMaps(QImage* pImage, int nGranularity)
+void kpEffectToneEnhanceApplier::ComputeToneMaps(const QImage* pImage,
+    const QVector <quint16> &tones, qint64 imageKey, int nGranularity)
 {
-  if(nGranularity == m_nToneMapGranularity && pImage->width() ==
-          static_cast<int> (m_nComputedWid) && pImage->height() == static_cast<int> (m_nComputedHgt))
+  if(nGranularity == m_nToneMapGranularity &&
+     pImage->width() == m_nComputedWid && pImage->height() == m_nComputedHgt &&
+     imageKey == m_nComputedImageKey)
   {
-    return; // We've already computed tone maps for this granularity
+    return; // We've already computed tone maps for this image and granularity
   }
-  DeleteToneMaps();
-  m_pToneMaps = new unsigned int*[nGranularity * nGranularity];
+
+  KP_TRACE_SCOPE ("imagelib", "kpEffectToneEnhance::ComputeToneMaps");
+
+  m_toneMaps.resize(nGranularity * nGranularity * TONE_MAP_SIZE);
   m_nToneMapGranularity = nGranularity;
-  m_nComputedWid = static_cast<unsigned int> (pImage->width());
-  m_nComputedHgt = static_cast<unsigned int> (pImage->height());
-  int u, v;
-  for(v = 0; v < nGranularity; v++)
+  m_nComputedWid = pImage->width();
+  m_nComputedHgt = pImage->height();
+  m_nComputedImageKey = imageKey;
+
+  // Each row of areas is handled by one thread, which slides the histogram
+  // along the row instead of recounting overlapping columns.
+  unsigned int * const pToneMaps = m_toneMaps.data();
+  kpParallel::forBands(nGranularity, 1, [&](int begin, int end)
   {
-      for(u = 0; u < nGranularity; u++) {
-          m_pToneMaps[nGranularity * v + u] = MakeToneMap(pImage, u, v, nGranularity);
-      }
-  }
-}
-
-//---------------------------------------------------------------------
+    QVector <unsigned int> histogram(TONE_MAP_SIZE);
+    unsigned int * const pHistogram = histogram.data();
 
-// protected
-unsigned int kpEffectToneEnhanceApplier::InterpolateNewTone(QImage* pImage, unsigned int oldTone, int x, int y, int nGranularity)
-{
-  oldTone = (oldTone >> TONE_DROP_BITS);
-  if(m_nToneMapGranularity <= 1) {
-      return m_pToneMaps[0][oldTone];
-  }
-  auto u = x * (nGranularity - 1) / pImage->width();
-  auto v = y * (nGranularity - 1) / pImage->height();
-  auto x1y1 = m_pToneMaps[m_nToneMapGranularity * v + u][oldTone];
-  auto x2y1 = m_pToneMaps[m_nToneMapGranularity * v + u + 1][oldTone];
-  auto x1y2 = m_pToneMaps[m_nToneMapGranularity * (v + 1) + u][oldTone];
-  auto x2y2 = m_pToneMaps[m_nToneMapGranularity * (v + 1) + u + 1][oldTone];
-  auto hFac = x - (u * (pImage->width() - 1) / (nGranularity - 1));
-  if(hFac > m_areaWid) {
-      hFac = m_areaWid;
-  }
-  unsigned int y1 = (x1y1 * (static_cast<unsigned int> (m_areaWid) - static_cast<unsigned int> (hFac))
-                     + x2y1 * static_cast<unsigned int> (hFac)) / static_cast<unsigned int> (m_areaWid);
+    for(int v = begin; v < end; v++)
+    {
+      const int yy = AreaY(pImage, v, nGranularity);
 
-  unsigned int y2 = (x1y2 * (static_cast<unsigned int> (m_areaWid) - static_cast<unsigned int> (hFac))
-                     + x2y2 * static_cast<unsigned int> (hFac)) / static_cast<unsigned int> (m_areaWid);
+      int prevXX = 0;
+      for(int u = 0; u < nGranularity; u++)
+      {
+        const int xx = AreaX(pImage, u, nGranularity);
+        if(u > 0 && xx < prevXX + m_areaWid)
+        {
+          // (areas only ever move right)
+          AddToHistogram(pHistogram, tones, m_nComputedWid,
+              prevXX, xx, yy, false/*remove*/);
+          AddToHistogram(pHistogram, tones, m_nComputedWid,
+              prevXX + m_areaWid, xx + m_areaWid, yy, true/*add*/);
+        }
+        else
+        {
+          histogram.fill(0);
+          AddToHistogram(pHistogram, tones, m_nComputedWid,
+              xx, xx + m_areaWid, yy, true/*add*/);
+        }
+        prevXX = xx;
 
-  int vFac = y - (v * (pImage->height() - 1) / (nGranularity - 1));
-  if(vFac > m_areaHgt) {
-      vFac = m_areaHgt;
-  }
-  return (y1 * (static_cast<unsigned int> (m_areaHgt) - static_cast<unsigned int> (vFac))
-          + y2 * static_cast<unsigned int> (vFac)) / static_cast<unsigned int> (m_areaHgt);
+        MakeToneMap(pHistogram,
+            pToneMaps + (nGranularity * v + u) * TONE_MAP_SIZE);
+      }
+    }
+  });
 }
 
 //---------------------------------------------------------------------
 
 // public
-void kpEffectToneEnhanceApplier::BalanceImageTone(QImage* pImage, double granularity, double amount)
+void kpEffectToneEnhanceApplier::BalanceImageTone(QImage* pImage, qint64 imageKey,
+    double granularity, double amount)
 {
     if(pImage->width() < MIN_IMAGE_DIM || pImage->height() < MIN_IMAGE_DIM) {
         return; // the image is not big enough to perform this operation
     }
-  int nGranularity = static_cast<int> (granularity * (MAX_GRANULARITY - 2)) + 1;
+  Q_ASSERT(pImage->format() == QImage::Format_ARGB32);
+
+  const int nGranularity = static_cast<int> (granularity * (MAX_GRANULARITY - 2)) + 1;
   m_areaWid = pImage->width() / nGranularity;
   if(m_areaWid < MIN_IMAGE_DIM) {
       m_areaWid = MIN_IMAGE_DIM;
@@ -271,38 +273,132 @@ void kpEffectToneEnhanceApplier::BalanceImageTone(QImage* pImage, double granula
   if(m_areaHgt < MIN_IMAGE_DIM) {
       m_areaHgt = MIN_IMAGE_DIM;
   }
-  ComputeToneMaps(pImage, nGranularity);
-  int x, y;
-  unsigned int oldTone, newTone, col;
-  for(y = 0; y < pImage->height(); y++)
+
+  const int width = pImage->width(), height = pImage->height();
+  uchar * const bits = pImage->bits();
+  const int bytesPerLine = pImage->bytesPerLine();
+
+  // Compute the tone of each pixel once, instead of once per area it falls
+  // in and then again when adjusting it.
+  QVector <quint16> tones(width * height);
+  kpParallel::forBands(height, qMax(1, MinPixelsPerBand / width), [&](int begin, int end)
   {
-      for(x = 0; x < pImage->width(); x++)
-      {
-          col = pImage->pixel(x, y);
-          oldTone = ComputeTone(col);
-          newTone = InterpolateNewTone(pImage, oldTone, x, y, nGranularity);
-          pImage->setPixel(x, y, AdjustTone(col, oldTone, newTone, amount));
+    for(int y = begin; y < end; y++)
+    {
+      const auto *line = reinterpret_cast <const QRgb *> (bits + qint64(y) * bytesPerLine);
+      quint16 *toneLine = tones.data() + qint64(y) * width;
+      for(int x = 0; x < width; x++) {
+          toneLine[x] = static_cast<quint16> (ComputeTone(line[x]));
       }
+    }
+  });
+
+  ComputeToneMaps(pImage, tones, imageKey, nGranularity);
+
+  // Which tone maps to interpolate between, and how far between, only
+  // depends on the column and on the row.
+  QVector <int> areaU(width), areaHFac(width), areaV(height), areaVFac(height);
+  if(nGranularity > 1)
+  {
+    for(int x = 0; x < width; x++)
+    {
+      areaU[x] = x * (nGranularity - 1) / width;
+      areaHFac[x] = qMin(m_areaWid, x - (areaU[x] * (width - 1) / (nGranularity - 1)));
+    }
+    for(int y = 0; y < height; y++)
+    {
+      areaV[y] = y * (nGranularity - 1) / height;
+      areaVFac[y] = qMin(m_areaHgt, y - (areaV[y] * (height - 1) / (nGranularity - 1)));
+    }
   }
+
+  const unsigned int * const pToneMaps = m_toneMaps.constData();
+  const auto areaWid = static_cast<unsigned int> (m_areaWid);
+  const auto areaHgt = static_cast<unsigned int> (m_areaHgt);
+  kpParallel::forBands(height, qMax(1, MinPixelsPerBand / width), [&](int begin, int end)
+  {
+    for(int y = begin; y < end; y++)
+    {
+      auto *line = reinterpret_cast <QRgb *> (bits + qint64(y) * bytesPerLine);
+      const quint16 *toneLine = tones.constData() + qint64(y) * width;
+
+      const unsigned int *pRowToneMaps = pToneMaps +
+          nGranularity * areaV[y] * TONE_MAP_SIZE;
+      const auto vFac = static_cast<unsigned int> (areaVFac[y]);
+
+      for(int x = 0; x < width; x++)
+      {
+        const unsigned int oldTone = toneLine[x];
+        if(oldTone == 0) {
+            continue;  // black stays black
+        }
+        const unsigned int toneIndex = oldTone >> TONE_DROP_BITS;
+
+        unsigned int newTone;
+        if(nGranularity <= 1) {
+            newTone = pToneMaps[toneIndex];
+        }
+        else
+        {
+          const unsigned int *x1y1Map = pRowToneMaps + areaU[x] * TONE_MAP_SIZE;
+          const unsigned int *x1y2Map = x1y1Map + nGranularity * TONE_MAP_SIZE;
+          const auto hFac = static_cast<unsigned int> (areaHFac[x]);
+
+          const unsigned int y1 = (x1y1Map[toneIndex] * (areaWid - hFac) +
+              x1y1Map[TONE_MAP_SIZE + toneIndex] * hFac) / areaWid;
+          const unsigned int y2 = (x1y2Map[toneIndex] * (areaWid - hFac) +
+              x1y2Map[TONE_MAP_SIZE + toneIndex] * hFac) / areaWid;
+
+          newTone = (y1 * (areaHgt - vFac) + y2 * vFac) / areaHgt;
+        }
+
+        line[x] = AdjustTone(line[x], oldTone, newTone, amount);
+      }
+    }
+  });
+}
+
+//---------------------------------------------------------------------
+
+kpEffectToneEnhanceCache::kpEffectToneEnhanceCache ()
+    : m_applier (new kpEffectToneEnhanceApplier ())
+{
+}
+
+//---------------------------------------------------------------------
+
+kpEffectToneEnhanceCache::~kpEffectToneEnhanceCache ()
+{
+    delete m_applier;
 }
 
 //---------------------------------------------------------------------
 
 // public static
 kpImage kpEffectToneEnhance::applyEffect (const kpImage &image,
-                                          double granularity, double amount)
+                                          double granularity, double amount,
+                                          kpEffectToneEnhanceCache *cache)
 {
   if (amount == 0.0) {
       return image;
   }
 
-  QImage qimage(image);
+  KP_TRACE_SCOPE ("imagelib", "kpEffectToneEnhance::applyEffect");
 
-  // OPT: Cache the calculated values?
-  kpEffectToneEnhanceApplier applier;
-  applier.BalanceImageTone (&qimage, granularity, amount);
+  QImage qimage = image.convertToFormat (QImage::Format_ARGB32);
+
+  if (cache)
+  {
+    cache->m_applier->BalanceImageTone (&qimage, image.cacheKey (),
+        granularity, amount);
+  }
+  else
+  {
+    kpEffectToneEnhanceApplier applier;
+    applier.BalanceImageTone (&qimage, image.cacheKey (), granularity, amount);
+  }
 
-  return qimage;
+  return qimage.convertToFormat (image.format ());
 }
 
 //---------------------------------------------------------------------
@@ -34,6 +34,30 @@
 #include "imagelib/kpImage.h"
 
 
+class kpEffectToneEnhanceApplier;
+
+
+//
+// Keeps the tone maps that kpEffectToneEnhance::applyEffect() computed for
+// the last image and granularity it was given, so that they can be reused
+// when only the amount changes (e.g. while the user drags the "Amount"
+// slider of the effect's preview).
+//
+class kpEffectToneEnhanceCache
+{
+public:
+    kpEffectToneEnhanceCache ();
+    ~kpEffectToneEnhanceCache ();
+
+private:
+    Q_DISABLE_COPY (kpEffectToneEnhanceCache)
+
+    kpEffectToneEnhanceApplier *m_applier;
+
+    friend class kpEffectToneEnhance;
+};
+
+
 //
 // Histogram Equalizer effect.
 //
@@ -53,8 +77,11 @@
 class kpEffectToneEnhance
 {
 public:
+    // If <cache> is not null, the tone maps are kept in it and reused from
+    // it.  Otherwise, they are only kept for this call.
     static kpImage applyEffect (const kpImage &image,
-        double granularity, double amount);
+        double granularity, double amount,
+        kpEffectToneEnhanceCache *cache = nullptr);
 };
 
 
@@ -0,0 +1,340 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_COLOR_COUNTER 0
+
+
+#include "imagelib/kpColorCounter.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include "kpLogCategories.h"
+
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+// A small open addressing hash set of premultiplied colors, that
+// remembers the order that the colors were added in.
+class kpColorCounterSet
+{
+public:
+    explicit kpColorCounterSet (int maxColors)
+        : m_maxColors (maxColors)
+    {
+        int size = 16;
+        while (size < maxColors * 4) {
+            size *= 2;
+        }
+
+        m_mask = size - 1;
+        m_slots.fill (-1, size);
+        m_colors.reserve (maxColors + 1);
+    }
+
+    // Returns false if there are now more than <maxColors> colors.
+    bool add (QRgb color)
+    {
+        int slot = int ((color * 0x9E3779B1u) >> 7) & m_mask;
+        for (;;)
+        {
+            const int index = m_slots [slot];
+            if (index < 0)
+            {
+                m_slots [slot] = m_colors.size ();
+                m_colors.append (color);
+                return m_colors.size () <= m_maxColors;
+            }
+
+            if (m_colors [index] == color) {
+                return true;
+            }
+
+            slot = (slot + 1) & m_mask;
+        }
+    }
+
+    const QVector <QRgb> &colors () const { return m_colors; }
+
+private:
+    int m_maxColors;
+    int m_mask;
+    QVector <int> m_slots;
+    QVector <QRgb> m_colors;
+};
+
+//---------------------------------------------------------------------
+
+// Returns whether <image> has at most <maxColors> colors, setting
+// <*colors> to them.
+static bool FindDistinctColors (const QImage &image, int maxColors,
+        QVector <QRgb> *colors)
+{
+    colors->clear ();
+
+    // Only look at the color table entries that are used.
+    if (image.format () == QImage::Format_Indexed8 ||
+        image.format () == QImage::Format_Mono ||
+        image.format () == QImage::Format_MonoLSB)
+    {
+        QVector <bool> used (image.colorCount (), false);
+        int numUsed = 0;
+        for (int y = 0; y < image.height () && numUsed < used.size (); y++)
+        {
+            for (int x = 0; x < image.width (); x++)
+            {
+                const int index = image.pixelIndex (x, y);
+                if (!used [index])
+                {
+                    used [index] = true;
+                    numUsed++;
+                }
+            }
+        }
+
+        kpColorCounterSet set (maxColors);
+        for (int i = 0; i < used.size (); i++)
+        {
+            const QRgb color = image.color (i);
+            if (used [i] && !set.add (qAlpha (color) == 0 ? 0 : color)) {
+                return false;
+            }
+        }
+
+        *colors = set.colors ();
+        return true;
+    }
+
+    // Work on the 32-bit pixels directly, premultiplied if possible, as we
+    // only need to unpremultiply the few distinct colors at the end.
+    QImage image32 = image;
+    if (image32.format () != QImage::Format_ARGB32_Premultiplied &&
+        image32.format () != QImage::Format_ARGB32 &&
+        image32.format () != QImage::Format_RGB32)
+    {
+        image32 = image32.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    }
+    const bool isPremultiplied =
+        (image32.format () == QImage::Format_ARGB32_Premultiplied);
+    const bool isOpaqueFormat = (image32.format () == QImage::Format_RGB32);
+
+    kpColorCounterSet set (maxColors);
+    QRgb lastPixel = 0;
+    bool haveLastPixel = false;
+    for (int y = 0; y < image32.height (); y++)
+    {
+        const auto *line = reinterpret_cast <const QRgb *> (image32.constScanLine (y));
+        for (int x = 0; x < image32.width (); x++)
+        {
+            QRgb pixel = line [x];
+
+            // Most images have runs of the same color.
+            if (haveLastPixel && pixel == lastPixel) {
+                continue;
+            }
+            lastPixel = pixel;
+            haveLastPixel = true;
+
+            if (isOpaqueFormat) {
+                pixel |= 0xFF000000;
+            }
+            else if (qAlpha (pixel) == 0) {
+                pixel = 0;
+            }
+
+            if (!set.add (pixel))
+            {
+            #if DEBUG_KP_COLOR_COUNTER
+                qCDebug(kpLogImagelib) << "kpColorCounter: more than" << maxColors
+                                       << "colors at x=" << x << "y=" << y;
+            #endif
+                return false;
+            }
+        }
+    }
+
+    // Different premultiplied colors can unpremultiply to the same color.
+    // That only ever leaves us with fewer colors.
+    QVector <QRgb> ret;
+    for (const QRgb color : set.colors ())
+    {
+        const QRgb unpremultiplied = isPremultiplied ? qUnpremultiply (color) : color;
+        if (!ret.contains (unpremultiplied)) {
+            ret.append (unpremultiplied);
+        }
+    }
+
+    *colors = ret;
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// The last result of kpColorCounter::distinctColors().
+struct kpColorCounterCache
+{
+    qint64 imageKey{0};
+    // The largest number of colors that we found, or that we looked for
+    // if we gave up.
+    int maxColors{-1};
+    bool fits{false};
+    QVector <QRgb> colors;
+};
+
+// public static
+bool kpColorCounter::distinctColors (const QImage &image, int maxColors,
+        QVector <QRgb> *colors)
+{
+    static QMutex cacheMutex;
+    static kpColorCounterCache cache;
+
+    if (image.isNull ()) {
+        return false;
+    }
+
+    QMutexLocker cacheLocker (&cacheMutex);
+
+    // Can we answer from the cache?
+    if (cache.imageKey == image.cacheKey () && cache.maxColors >= 0)
+    {
+        if (cache.fits)
+        {
+            if (cache.colors.size () > maxColors) {
+                return false;
+            }
+
+            if (colors) {
+                *colors = cache.colors;
+            }
+            return true;
+        }
+        else if (maxColors <= cache.maxColors)
+        {
+            return false;
+        }
+    }
+
+    KP_TRACE_SCOPE ("imagelib", "kpColorCounter::distinctColors");
+
+    QVector <QRgb> foundColors;
+    const bool fits = ::FindDistinctColors (image, maxColors, &foundColors);
+
+    cache.imageKey = image.cacheKey ();
+    cache.maxColors = maxColors;
+    cache.fits = fits;
+    cache.colors = fits ? foundColors : QVector <QRgb> ();
+
+    if (fits && colors) {
+        *colors = foundColors;
+    }
+
+    return fits;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpColorCounter::fitsInColorTable (const QImage &image, int depth)
+{
+    if (depth != 1 && depth != 8) {
+        return false;
+    }
+
+    QVector <QRgb> colors;
+    if (!kpColorCounter::distinctColors (image, 1 << depth, &colors)) {
+        return false;
+    }
+
+    // Transparency is not reliably kept in low color depth files.
+    for (const QRgb color : colors)
+    {
+        if (qAlpha (color) != 255) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QImage kpColorCounter::toIndexed (const QImage &image, const QVector <QRgb> &colors,
+        int depth)
+{
+    Q_ASSERT (depth == 1 || depth == 8);
+    Q_ASSERT (!colors.isEmpty () && colors.size () <= (1 << depth));
+
+    QImage ret (image.size (),
+        depth == 1 ? QImage::Format_MonoLSB : QImage::Format_Indexed8);
+
+    QVector <QRgb> colorTable = colors;
+    if (depth == 1 && colorTable.size () < 2)
+    {
+        // (monochrome images always have 2 colors)
+        colorTable.append (colorTable [0] == qRgb (0, 0, 0) ?
+            qRgb (255, 255, 255) : qRgb (0, 0, 0));
+    }
+    ret.setColorTable (colorTable);
+
+    QHash <QRgb, int> indexForColor;
+    for (int i = 0; i < colors.size (); i++) {
+        indexForColor.insert (colors [i], i);
+    }
+
+    const QImage image32 = image.convertToFormat (QImage::Format_ARGB32);
+    for (int y = 0; y < image32.height (); y++)
+    {
+        const auto *line = reinterpret_cast <const QRgb *> (image32.constScanLine (y));
+        uchar *retLine = ret.scanLine (y);
+
+        QRgb lastPixel = 0;
+        int lastIndex = -1;
+        for (int x = 0; x < image32.width (); x++)
+        {
+            const QRgb pixel = qAlpha (line [x]) == 0 ? 0 : line [x];
+            if (lastIndex < 0 || pixel != lastPixel)
+            {
+                lastPixel = pixel;
+                lastIndex = indexForColor.value (pixel, 0);
+            }
+
+            if (ret.format () == QImage::Format_Indexed8) {
+                retLine [x] = uchar (lastIndex);
+            }
+            else {
+                ret.setPixel (x, y, uint (lastIndex));
+            }
+        }
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,75 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpColorCounter_H
+#define kpColorCounter_H
+
+
+#include <QImage>
+#include <QVector>
+
+
+//
+// Finds the distinct colors in an image, stopping as soon as there are too
+// many.
+//
+// This is used to tell whether an image can be stored at a low color depth
+// without losing anything (e.g. a 32-bit image that only has 12 colors).
+//
+class kpColorCounter
+{
+public:
+    // Returns whether <image> has at most <maxColors> distinct colors and, if
+    // so, sets <*colors> (if not null) to them, as unpremultiplied QRgb
+    // values in order of first appearance.  All fully transparent pixels
+    // count as the single color 0.
+    //
+    // This stops reading pixels as soon as more than <maxColors> colors have
+    // been found.
+    //
+    // The result for the last image is cached by QImage::cacheKey() so, for
+    // instance, checking whether saving is lossy and then saving the same,
+    // unmodified document image only reads its pixels once.
+    static bool distinctColors (const QImage &image, int maxColors,
+                                QVector <QRgb> *colors = nullptr);
+
+    // Returns whether <image> can be stored with a <depth>-bit (1 or 8) color
+    // table, without losing any colors or any transparency.
+    static bool fitsInColorTable (const QImage &image, int depth);
+
+    // Returns <image> as a QImage::Format_MonoLSB (<depth> 1) or
+    // QImage::Format_Indexed8 (<depth> 8) image, using <colors> as the color
+    // table.
+    //
+    // ASSUMPTION: <colors> is what distinctColors() returned for <image> and
+    //             fits in a <depth>-bit color table.
+    static QImage toIndexed (const QImage &image, const QVector <QRgb> &colors,
+                             int depth);
+};
+
+
+#endif  // kpColorCounter_H
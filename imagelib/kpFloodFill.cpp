@@ -31,15 +31,23 @@
 
 #include "kpFloodFill.h"
 
+#include <algorithm>
+#include <cstring>
+
 #include <QApplication>
+#include <QHash>
 #include <QImage>
 #include <QList>
+#include <QMutex>
+#include <QMutexLocker>
 #include <QPainter>
+#include <QtAlgorithms>
 
 #include "kpLogCategories.h"
 
 #include "kpColor.h"
 #include "kpDefs.h"
+#include "generic/kpParallel.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
 
@@ -70,6 +78,126 @@ static kpCommandSize::SizeType FillLinesListSize (const QList <kpFillLine> &fill
 
 //---------------------------------------------------------------------
 
+// Reads row <y> of <image> into <rgbaRow>, as kpPixmapFX::getColorAtPixel()
+// would for each pixel (i.e. with unpremultiplied alpha).
+//
+// <colorTable> must be the color table of <image>, with 256 entries.
+static void ReadRow (const QImage &image, int y, const QVector <QRgb> &colorTable,
+                     QRgb *rgbaRow)
+{
+    const int width = image.width ();
+
+    switch (image.format ())
+    {
+    case QImage::Format_RGB32:
+    case QImage::Format_ARGB32:
+        std::memcpy (rgbaRow, image.constScanLine (y), size_t (width) * sizeof (QRgb));
+        break;
+
+    case QImage::Format_ARGB32_Premultiplied:
+    {
+        const auto *line = reinterpret_cast <const QRgb *> (image.constScanLine (y));
+        for (int x = 0; x < width; x++)
+        {
+            const QRgb pixel = line [x];
+            rgbaRow [x] = (qAlpha (pixel) == 255) ? pixel : qUnpremultiply (pixel);
+        }
+        break;
+    }
+
+    case QImage::Format_Indexed8:
+    {
+        const uchar *line = image.constScanLine (y);
+        for (int x = 0; x < width; x++) {
+            rgbaRow [x] = colorTable [line [x]];
+        }
+        break;
+    }
+
+    default:
+        for (int x = 0; x < width; x++) {
+            rgbaRow [x] = image.pixel (x, y);
+        }
+        break;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Sets <matches [x]> to whether kpColor (<rgbaRow [x]>) is similar to
+// kpColor (<refRGBA>), like kpColor::isSimilarTo() with the given
+// processed similarity.
+//
+// This is written without branches so that the compiler can vectorize it.
+static void MatchRow (const QRgb *rgbaRow, int width,
+                      QRgb refRGBA, int processedColorSimilarity,
+                      uchar *matches)
+{
+    const int refRed = qRed (refRGBA),
+              refGreen = qGreen (refRGBA),
+              refBlue = qBlue (refRGBA);
+
+    // (kpColor::Exact only accepts identical colors, including alpha)
+    const int maxDistance = (processedColorSimilarity == kpColor::Exact) ?
+        -1 : processedColorSimilarity;
+
+    for (int x = 0; x < width; x++)
+    {
+        const QRgb pixel = rgbaRow [x];
+
+        const int dr = int ((pixel >> 16) & 0xFF) - refRed;
+        const int dg = int ((pixel >> 8) & 0xFF) - refGreen;
+        const int db = int (pixel & 0xFF) - refBlue;
+
+        matches [x] = uchar ((pixel == refRGBA) |
+                             (dr * dr + dg * dg + db * db <= maxDistance));
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Calls <func (x1, x2)> for each run of set bits in a row of a
+// kpFloodFillPrivate::changeMask.
+template <typename Func>
+static void ForEachRun (const quint32 *maskRow, int width, Func func)
+{
+    int runStart = -1;
+
+    for (int x = 0; x < width;)
+    {
+        // (<x> is at the start of a word here)
+        const quint32 word = maskRow [x / 32];
+
+        // Skip whole words that don't start or end a run.
+        if ((word == 0 && runStart < 0) ||
+            (word == 0xFFFFFFFFu && runStart >= 0))
+        {
+            x += 32;
+            continue;
+        }
+
+        const int wordEnd = qMin (x + 32, width);
+        for (; x < wordEnd; x++)
+        {
+            const bool isSet = (word >> (x % 32)) & 1;
+            if (isSet && runStart < 0) {
+                runStart = x;
+            }
+            else if (!isSet && runStart >= 0)
+            {
+                func (runStart, x - 1);
+                runStart = -1;
+            }
+        }
+    }
+
+    if (runStart >= 0) {
+        func (runStart, width - 1);
+    }
+}
+
+//---------------------------------------------------------------------
+
 struct kpFloodFillPrivate
 {
     //
@@ -99,6 +227,31 @@ struct kpFloodFillPrivate
     QRect boundingRect;
 
     bool prepared = false;
+
+
+    //
+    // Set by Step 2, if replaceAllSimilarColors.
+    //
+
+    bool replaceAllSimilarColors = false;
+
+    // 1 bit per pixel of <*imagePtr>, set for the pixels to change.  Each
+    // row starts at a new word.
+    QVector <quint32> changeMask;
+    int changeMaskRowWords = 0;
+
+    // The number of set bits in <changeMask> before each row (plus the
+    // total, at the end).
+    QVector <int> changeMaskRowOffsets;
+
+
+    //
+    // Running Step 2 in the background.
+    //
+
+    std::function <void (const QVector <QRect> &)> progressFunc;
+    const QAtomicInt *cancel = nullptr;
+    bool cancelled = false;
 };
 
 //---------------------------------------------------------------------
@@ -152,7 +305,27 @@ kpCommandSize::SizeType kpFloodFill::size () const
 
     return ::FillLinesListSize(d->fillLines) +
            kpCommandSize::QImageSize(d->imagePtr) +
-           fillLinesCacheSize;
+           fillLinesCacheSize +
+           d->changeMask.size () * sizeof (quint32) +
+           d->changeMaskRowOffsets.size () * sizeof (int);
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpFloodFill::replaceAllSimilarColors () const
+{
+    return d->replaceAllSimilarColors;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpFloodFill::setReplaceAllSimilarColors (bool yes)
+{
+    Q_ASSERT (!d->prepared);
+
+    d->replaceAllSimilarColors = yes;
 }
 
 //---------------------------------------------------------------------
@@ -334,6 +507,14 @@ void kpFloodFill::prepare ()
         return;
     }
 
+    if (d->replaceAllSimilarColors)
+    {
+        prepareAllSimilarColors ();
+
+        d->prepared = true;  // sync with all "return true"'s
+        return;
+    }
+
 #if DEBUG_KP_FLOOD_FILL && 1
     qCDebug(kpLogImagelib) << "\tcreating fillLinesCache";
 #endif
@@ -350,8 +531,22 @@ void kpFloodFill::prepare ()
     // draw initial line
     addLine (d->y, findMinX (d->y, d->x), findMaxX (d->y, d->x));
 
+    int numReportedLines = 0;
+
     for (int i = 0; i < d->fillLines.count(); i++)
     {
+      // Every so often, show our progress and see if we should give up.
+      if ((i % 1024) == 1023)
+      {
+        reportFillLines (&numReportedLines);
+
+        if (isCancelRequested ())
+        {
+          cancelPrepare ();
+          return;
+        }
+      }
+
       kpFillLine &fl = d->fillLines[i];
 
     #if DEBUG_KP_FLOOD_FILL && 0
@@ -369,6 +564,8 @@ void kpFloodFill::prepare ()
         findAndAddLines(fl, +1);
     }
 
+    reportFillLines (&numReportedLines);
+
 #if DEBUG_KP_FLOOD_FILL && 1
     qCDebug(kpLogImagelib) << "\tfinalising memory usage";
 #endif
@@ -389,14 +586,142 @@ QRect kpFloodFill::boundingRect ()
     return d->boundingRect;
 }
 
+//---------------------------------------------------------------------
+
+// private
+void kpFloodFill::reportFillLines (int *numReported) const
+{
+    if (!d->progressFunc || *numReported == d->fillLines.count ()) {
+        return;
+    }
+
+    QVector <QRect> lines;
+    lines.reserve (d->fillLines.count () - *numReported);
+
+    for (int i = *numReported; i < d->fillLines.count (); i++)
+    {
+        const kpFillLine &l = d->fillLines [i];
+        lines.append (QRect (l.m_x1, l.m_y, l.m_x2 - l.m_x1 + 1, 1));
+    }
+
+    *numReported = d->fillLines.count ();
+
+    d->progressFunc (lines);
+}
+
+//---------------------------------------------------------------------
+
+// private
+bool kpFloodFill::isCancelRequested () const
+{
+    return (d->cancel && d->cancel->loadAcquire () != 0);
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpFloodFill::cancelPrepare ()
+{
+#if DEBUG_KP_FLOOD_FILL && 1
+    qCDebug(kpLogImagelib) << "kpFloodFill::cancelPrepare()";
+#endif
+
+    d->fillLines.clear ();
+    d->fillLinesCache.clear ();
+
+    d->changeMask.clear ();
+    d->changeMaskRowOffsets.clear ();
+
+    d->boundingRect = QRect ();
+
+    d->cancelled = true;
+    d->prepared = true;  // sync with all "return true"'s
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpFloodFill::setProgressFunction (
+        const std::function <void (const QVector <QRect> &lines)> &func)
+{
+    d->progressFunc = func;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpFloodFill::setCancelFlag (const QAtomicInt *cancel)
+{
+    d->cancel = cancel;
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpFloodFill::wasCancelled () const
+{
+    return d->cancelled;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpFloodFill::copyPreparedFrom (const kpFloodFill &other)
+{
+    Q_ASSERT (other.d->prepared);
+    Q_ASSERT (other.d->x == d->x && other.d->y == d->y);
+    Q_ASSERT (other.d->color == d->color);
+    Q_ASSERT (other.d->processedColorSimilarity == d->processedColorSimilarity);
+    Q_ASSERT (other.d->replaceAllSimilarColors == d->replaceAllSimilarColors);
+
+    d->colorToChange = other.d->colorToChange;
+
+    d->fillLines = other.d->fillLines;
+    d->boundingRect = other.d->boundingRect;
+
+    d->changeMask = other.d->changeMask;
+    d->changeMaskRowWords = other.d->changeMaskRowWords;
+    d->changeMaskRowOffsets = other.d->changeMaskRowOffsets;
+
+    d->cancelled = other.d->cancelled;
+    d->prepared = true;
+}
+
 //---------------------------------------------------------------------
 // public
 void kpFloodFill::fill()
 {
     prepare();
 
+    if ( d->cancelled ) {
+      return;
+    }
+
+    if ( d->replaceAllSimilarColors )
+    {
+      fillAllSimilarColors();
+      return;
+    }
+
     QApplication::setOverrideCursor(Qt::WaitCursor);
 
+    // Keep indexed images (see kpDocument) indexed if we can.
+    if ( kpPixmapFX::isIndexed(*d->imagePtr) )
+    {
+      const int index = kpPixmapFX::colorTableIndex(*d->imagePtr, d->color);
+      if ( index >= 0 )
+      {
+        for (const auto &l : d->fillLines) {
+          kpPixmapFX::setIndexedPixels(d->imagePtr, l.m_x1, l.m_x2, l.m_y, index);
+        }
+
+        QApplication::restoreOverrideCursor();
+        return;
+      }
+
+      *d->imagePtr = d->imagePtr->convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    }
+
     QPainter painter(d->imagePtr);
 
     // by definition, flood fill with a fully transparent color erases the pixels
@@ -421,3 +746,366 @@ void kpFloodFill::fill()
 }
 
 //---------------------------------------------------------------------
+
+// Returns the color table of <image>, padded to 256 entries for ReadRow().
+static QVector <QRgb> ColorTable256 (const QImage &image)
+{
+    QVector <QRgb> colorTable = image.colorTable ();
+    colorTable.resize (256);
+    return colorTable;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpFloodFill::prepareAllSimilarColors ()
+{
+#if DEBUG_KP_FLOOD_FILL && 1
+    qCDebug(kpLogImagelib) << "kpFloodFill::prepareAllSimilarColors()";
+#endif
+
+    const kpImage &image = *d->imagePtr;
+    const int width = image.width (), height = image.height ();
+
+    const QRgb refRGBA = d->colorToChange.toQRgb ();
+    const int processedColorSimilarity = d->processedColorSimilarity;
+    const QVector <QRgb> colorTable = ::ColorTable256 (image);
+
+    const int rowWords = (width + 31) / 32;
+    d->changeMaskRowWords = rowWords;
+    d->changeMask = QVector <quint32> (rowWords * height, 0);
+
+    QVector <int> rowCounts (height, 0);
+
+    // (detach before sharing between threads)
+    quint32 *mask = d->changeMask.data ();
+    int *counts = rowCounts.data ();
+
+    QMutex boundingRectMutex;
+    QRect boundingRect;
+
+    kpParallel::forBands (height, 16/*rows*/, [&] (int begin, int end)
+    {
+        QVector <QRgb> rgbaRow (width);
+        QVector <uchar> matches (width);
+
+        QRect bandRect;
+        QVector <QRect> bandLines;
+
+        for (int y = begin; y < end; y++)
+        {
+            if (isCancelRequested ()) {
+                return;
+            }
+
+            ::ReadRow (image, y, colorTable, rgbaRow.data ());
+            ::MatchRow (rgbaRow.constData (), width,
+                        refRGBA, processedColorSimilarity,
+                        matches.data ());
+
+            quint32 *maskRow = mask + y * rowWords;
+            for (int x = 0; x < width; x++) {
+                maskRow [x / 32] |= quint32 (matches [x]) << (x % 32);
+            }
+
+            int count = 0, minX = -1, maxX = -1;
+            for (int w = 0; w < rowWords; w++)
+            {
+                if (maskRow [w] == 0) {
+                    continue;
+                }
+
+                count += int (qPopulationCount (maskRow [w]));
+
+                if (minX < 0) {
+                    minX = w * 32 + int (qCountTrailingZeroBits (maskRow [w]));
+                }
+                maxX = w * 32 + 31 - int (qCountLeadingZeroBits (maskRow [w]));
+            }
+
+            counts [y] = count;
+            if (count > 0) {
+                bandRect |= QRect (minX, y, maxX - minX + 1, 1);
+            }
+
+            if (d->progressFunc)
+            {
+                ::ForEachRun (maskRow, width, [&] (int x1, int x2) {
+                    bandLines.append (QRect (x1, y, x2 - x1 + 1, 1));
+                });
+            }
+        }
+
+        if (d->progressFunc && !bandLines.isEmpty ()) {
+            d->progressFunc (bandLines);
+        }
+
+        if (bandRect.isValid ())
+        {
+            QMutexLocker lock (&boundingRectMutex);
+            boundingRect |= bandRect;
+        }
+    });
+
+    if (isCancelRequested ())
+    {
+        cancelPrepare ();
+        return;
+    }
+
+    d->changeMaskRowOffsets.resize (height + 1);
+    d->changeMaskRowOffsets [0] = 0;
+    for (int y = 0; y < height; y++) {
+        d->changeMaskRowOffsets [y + 1] = d->changeMaskRowOffsets [y] + rowCounts [y];
+    }
+
+    d->boundingRect = boundingRect;
+
+#if DEBUG_KP_FLOOD_FILL && 1
+    qCDebug(kpLogImagelib) << "\tpixels=" << d->changeMaskRowOffsets [height]
+                           << " boundingRect=" << d->boundingRect;
+#endif
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpFloodFill::fillAllSimilarColors ()
+{
+    if (!d->boundingRect.isValid ()) {
+        return;
+    }
+
+    QApplication::setOverrideCursor (Qt::WaitCursor);
+
+    kpImage *image = d->imagePtr;
+    const int width = image->width ();
+    const int rowWords = d->changeMaskRowWords;
+    const quint32 *mask = d->changeMask.constData ();
+
+    // Keep indexed images (see kpDocument) indexed if we can.
+    if (kpPixmapFX::isIndexed (*image))
+    {
+        const int index = kpPixmapFX::colorTableIndex (*image, d->color);
+        if (index >= 0)
+        {
+            for (int y = d->boundingRect.top (); y <= d->boundingRect.bottom (); y++)
+            {
+                ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+                    kpPixmapFX::setIndexedPixels (image, x1, x2, y, index);
+                });
+            }
+
+            QApplication::restoreOverrideCursor ();
+            return;
+        }
+
+        *image = image->convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    }
+
+    const QRgb rgba = d->color.toQRgb ();
+    const QImage::Format format = image->format ();
+
+    // Fast path: write the pixels directly, from multiple threads.  Like
+    // fill(), a fully transparent color sets the pixels to transparent.
+    if ((d->color.isTransparent () || qAlpha (rgba) == 255) &&
+        (format == QImage::Format_ARGB32_Premultiplied ||
+         format == QImage::Format_ARGB32 ||
+         (format == QImage::Format_RGB32 && !d->color.isTransparent ())))
+    {
+        const QRgb pixel = d->color.isTransparent () ? 0 : rgba;
+
+        // (detach before sharing between threads -- scanLine() would
+        //  detach from each of them)
+        uchar *bits = image->bits ();
+        const int bytesPerLine = image->bytesPerLine ();
+
+        kpParallel::forBands (d->boundingRect.height (), 16/*rows*/,
+            [&] (int begin, int end)
+        {
+            for (int y = d->boundingRect.top () + begin;
+                 y < d->boundingRect.top () + end;
+                 y++)
+            {
+                auto *line = reinterpret_cast <QRgb *> (bits + qint64 (y) * bytesPerLine);
+                ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+                    std::fill (line + x1, line + x2 + 1, pixel);
+                });
+            }
+        });
+
+        QApplication::restoreOverrideCursor ();
+        return;
+    }
+
+    // Otherwise, paint the runs like fill().
+    QPainter painter (image);
+
+    if (d->color.isTransparent ()) {
+        painter.setCompositionMode (QPainter::CompositionMode_Clear);
+    }
+
+    painter.setPen (d->color.toQColor ());
+
+    for (int y = d->boundingRect.top (); y <= d->boundingRect.bottom (); y++)
+    {
+        ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+            if (x1 == x2) {
+                painter.drawPoint (x1, y);
+            }
+            else {
+                painter.drawLine (x1, y, x2, y);
+            }
+        });
+    }
+
+    QApplication::restoreOverrideCursor ();
+}
+
+//---------------------------------------------------------------------
+
+// public
+QVector <QRgb> kpFloodFill::colorsOfPixelsToChange ()
+{
+    Q_ASSERT (d->replaceAllSimilarColors);
+
+    prepare ();
+
+    if (d->processedColorSimilarity == kpColor::Exact ||
+        !d->boundingRect.isValid ())
+    {
+        return {};
+    }
+
+    const kpImage &image = *d->imagePtr;
+    const int width = image.width ();
+    const int rowWords = d->changeMaskRowWords;
+    const quint32 *mask = d->changeMask.constData ();
+    const QVector <QRgb> colorTable = ::ColorTable256 (image);
+
+    QVector <QRgb> colors (d->changeMaskRowOffsets.last ());
+    QRgb *out = colors.data ();
+
+    kpParallel::forBands (d->boundingRect.height (), 16/*rows*/,
+        [&] (int begin, int end)
+    {
+        QVector <QRgb> rgbaRow (width);
+
+        for (int y = d->boundingRect.top () + begin;
+             y < d->boundingRect.top () + end;
+             y++)
+        {
+            ::ReadRow (image, y, colorTable, rgbaRow.data ());
+
+            QRgb *rowOut = out + d->changeMaskRowOffsets [y];
+            ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+                rowOut = std::copy (rgbaRow.constData () + x1,
+                                    rgbaRow.constData () + x2 + 1,
+                                    rowOut);
+            });
+        }
+    });
+
+    return colors;
+}
+
+//---------------------------------------------------------------------
+
+// public
+void kpFloodFill::unfill (const QVector <QRgb> &colors)
+{
+    Q_ASSERT (d->replaceAllSimilarColors && d->prepared);
+
+    if (!d->boundingRect.isValid ()) {
+        return;
+    }
+
+    // (all pixels were colorToChange()?)
+    const bool singleColor = colors.isEmpty ();
+    Q_ASSERT (singleColor || colors.size () == d->changeMaskRowOffsets.last ());
+
+    const QRgb singleRGBA = d->colorToChange.toQRgb ();
+
+    kpImage *image = d->imagePtr;
+    const int width = image->width ();
+    const int rowWords = d->changeMaskRowWords;
+    const quint32 *mask = d->changeMask.constData ();
+    const QImage::Format format = image->format ();
+
+    if (format == QImage::Format_ARGB32_Premultiplied ||
+        format == QImage::Format_ARGB32 ||
+        format == QImage::Format_RGB32)
+    {
+        // (detach before sharing between threads -- scanLine() would
+        //  detach from each of them)
+        uchar *bits = image->bits ();
+        const int bytesPerLine = image->bytesPerLine ();
+
+        kpParallel::forBands (d->boundingRect.height (), 16/*rows*/,
+            [&] (int begin, int end)
+        {
+            for (int y = d->boundingRect.top () + begin;
+                 y < d->boundingRect.top () + end;
+                 y++)
+            {
+                auto *line = reinterpret_cast <QRgb *> (bits + qint64 (y) * bytesPerLine);
+                const QRgb *rowColors = singleColor ?
+                    nullptr : colors.constData () + d->changeMaskRowOffsets [y];
+
+                ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+                    for (int x = x1; x <= x2; x++)
+                    {
+                        const QRgb rgba = singleColor ? singleRGBA : *rowColors++;
+
+                        if (format == QImage::Format_ARGB32_Premultiplied) {
+                            line [x] = qPremultiply (rgba);
+                        }
+                        else if (format == QImage::Format_RGB32) {
+                            line [x] = rgba | 0xFF000000;
+                        }
+                        else {
+                            line [x] = rgba;
+                        }
+                    }
+                });
+            }
+        });
+
+        return;
+    }
+
+    // Indexed or unusual formats: slower but general.
+    const bool isIndexed = kpPixmapFX::isIndexed (*image);
+    QHash <QRgb, int> colorTableIndexes;
+
+    int i = 0;
+    for (int y = d->boundingRect.top (); y <= d->boundingRect.bottom (); y++)
+    {
+        ::ForEachRun (mask + y * rowWords, width, [&] (int x1, int x2) {
+            for (int x = x1; x <= x2; x++)
+            {
+                const QRgb rgba = singleColor ? singleRGBA : colors [i++];
+
+                if (isIndexed)
+                {
+                    auto it = colorTableIndexes.find (rgba);
+                    if (it == colorTableIndexes.end ())
+                    {
+                        it = colorTableIndexes.insert (rgba,
+                            kpPixmapFX::colorTableIndex (*image, kpColor (rgba)));
+                    }
+
+                    // (always there, since it was read from this table)
+                    Q_ASSERT (it.value () >= 0);
+                    image->setPixel (x, y, uint (it.value ()));
+                }
+                else
+                {
+                    image->setPixel (x, y, rgba);
+                }
+            }
+        });
+    }
+}
+
+//---------------------------------------------------------------------
@@ -30,6 +30,13 @@
 #define KP_FLOOD_FILL_H
 
 
+#include <functional>
+
+#include <QAtomicInt>
+#include <QRect>
+#include <QRgb>
+#include <QVector>
+
 #include "kpImage.h"
 #include "commands/kpCommandSize.h"
 
@@ -58,6 +65,18 @@ public:
     int processedColorSimilarity () const;
 
 
+    //
+    // Instead of the region of similar colors around (x, y), change every
+    // pixel of the image whose color is similar to colorToChange().
+    //
+    // Call this before any of the Step 2 or 3 functions.
+    //
+
+public:
+    bool replaceAllSimilarColors () const;
+    void setReplaceAllSimilarColors (bool yes = true);
+
+
 public:
     // Used for calculating the size of a command in the command history.
     kpCommandSize::SizeType size () const;
@@ -98,10 +117,38 @@ private:
     void addLine (int y, int x1, int x2);
     void findAndAddLines (const kpFillLine &fillLine, int dy);
 
+    // Step 2 for replaceAllSimilarColors().
+    void prepareAllSimilarColors ();
+
+    // Passes the lines from <*numReported> onwards to the progress function
+    // and updates <*numReported>.
+    void reportFillLines (int *numReported) const;
+    bool isCancelRequested () const;
+    void cancelPrepare ();
+
 public:
     // (may invoke Step 1's prepareColorToChange())
     void prepare ();
 
+    // Lets the slow prepare() run in another thread (on a copy of the image),
+    // while showing its progress and allowing it to be interrupted.
+    //
+    // While prepare() runs, <func> is passed the scanlines found since its
+    // last call, as rectangles 1 pixel high.  <func> is called in the thread
+    // running prepare(), possibly from several threads at once.
+    void setProgressFunction (const std::function <void (const QVector <QRect> &lines)> &func);
+
+    // prepare() stops early once <*cancel> becomes non-zero, after which
+    // wasCancelled() returns true and fill() does nothing.  <*cancel> must
+    // outlive prepare().
+    void setCancelFlag (const QAtomicInt *cancel);
+    bool wasCancelled () const;
+
+    // Takes on the results of Step 1 and 2 from <other>, which must have been
+    // constructed with the same arguments, apart from being given a copy of
+    // our image, and then prepared.
+    void copyPreparedFrom (const kpFloodFill &other);
+
     // (may invoke prepare())
     QRect boundingRect ();
 
@@ -115,11 +162,36 @@ public:
     //         call any of the functions in Step 1 or 2.
     //
 
+private:
+    // Step 3 for replaceAllSimilarColors().
+    void fillAllSimilarColors ();
+
 public:
     // (may invoke Step 2's prepare())
     void fill ();
 
 
+    //
+    // Undo support for replaceAllSimilarColors() that, unlike saving the
+    // image, only costs 1 bit per pixel (kept by Step 2) plus the old
+    // colors.
+    //
+
+public:
+    // Returns the current colors of the pixels that fill() changes, row
+    // by row.  If processedColorSimilarity() is kpColor::Exact, these
+    // would all be colorToChange() so an empty list is returned instead.
+    //
+    // Call this before fill().
+    //
+    // (may invoke Step 2's prepare())
+    QVector <QRgb> colorsOfPixelsToChange ();
+
+    // Sets the pixels changed by fill() back to <colors>, as returned by
+    // colorsOfPixelsToChange().
+    void unfill (const QVector <QRgb> &colors);
+
+
 private:
     kpFloodFillPrivate * const d;
 };
@@ -0,0 +1,482 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_PNG_WRITER 0
+
+
+#include "imagelib/kpPNGWriter.h"
+
+#include <cstdlib>
+#include <cstring>
+
+#include <QByteArray>
+#include <QIODevice>
+#include <QVector>
+#include <QtEndian>
+
+#include <zlib.h>
+
+#include "kpLogCategories.h"
+
+#include "generic/kpParallel.h"
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+// Aim for blocks of about this much filtered data (as pigz does).
+static const int BlockBytes = 128 * 1024;
+
+// Deflate can refer back this far, so each block is primed with this much
+// of the end of the previous block.
+static const int DictionaryBytes = 32 * 1024;
+
+// Maximum size of a single IDAT chunk.
+static const int MaxIDATBytes = 1024 * 1024;
+
+enum PNGFilter
+{
+    FilterNone = 0,
+    FilterSub = 1,
+    FilterUp = 2,
+    FilterAverage = 3,
+    FilterPaeth = 4
+};
+
+//---------------------------------------------------------------------
+
+static void AppendUInt32 (QByteArray *ba, quint32 value)
+{
+    const char bytes [4] = {char (value >> 24), char (value >> 16),
+                            char (value >> 8), char (value)};
+    ba->append (bytes, 4);
+}
+
+//---------------------------------------------------------------------
+
+static bool WriteChunk (QIODevice *device, const char *type, const QByteArray &data)
+{
+    QByteArray chunk;
+    chunk.reserve (data.size () + 12);
+
+    AppendUInt32 (&chunk, quint32 (data.size ()));
+    chunk.append (type, 4);
+    chunk.append (data);
+
+    const auto *crcStart = reinterpret_cast <const Bytef *> (chunk.constData () + 4);
+    AppendUInt32 (&chunk, quint32 (::crc32 (0, crcStart, uInt (data.size () + 4))));
+
+    return device->write (chunk) == chunk.size ();
+}
+
+//---------------------------------------------------------------------
+
+static inline uchar Paeth (int a, int b, int c)
+{
+    const int p = a + b - c;
+    const int pa = std::abs (p - a), pb = std::abs (p - b), pc = std::abs (p - c);
+    if (pa <= pb && pa <= pc) {
+        return uchar (a);
+    }
+    return uchar (pb <= pc ? b : c);
+}
+
+//---------------------------------------------------------------------
+
+// Converts row <y> of <image> (32-bit) to unpremultiplied RGB(A) bytes.
+static void GetRawRow (const QImage &image, int y, bool hasAlpha, uchar *raw)
+{
+    const auto *line = reinterpret_cast <const QRgb *> (image.constScanLine (y));
+    const bool isPremultiplied =
+        (image.format () == QImage::Format_ARGB32_Premultiplied);
+
+    for (int x = 0; x < image.width (); x++)
+    {
+        const QRgb pixel = isPremultiplied ? qUnpremultiply (line [x]) : line [x];
+        *raw++ = uchar (qRed (pixel));
+        *raw++ = uchar (qGreen (pixel));
+        *raw++ = uchar (qBlue (pixel));
+        if (hasAlpha) {
+            *raw++ = uchar (qAlpha (pixel));
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Filters <raw> (with <prev> being the previous raw row, or null for the
+// first row) into <out>, which starts with the filter type byte.  Like
+// libpng, this tries each filter and picks the one with the smallest sum
+// of absolute (signed) differences.
+static void FilterRow (const uchar *raw, const uchar *prev, int rowBytes, int bpp,
+        uchar *out, uchar *scratch)
+{
+    long bestSum = -1;
+    for (int filter = FilterNone; filter <= FilterPaeth; filter++)
+    {
+        // Without a previous row, Up is None and Paeth is Sub.
+        if (!prev && (filter == FilterUp || filter == FilterPaeth)) {
+            continue;
+        }
+
+        uchar *dest = (bestSum < 0) ? out + 1 : scratch + 1;
+        long sum = 0;
+        for (int i = 0; i < rowBytes; i++)
+        {
+            const int a = (i >= bpp) ? raw [i - bpp] : 0;
+            const int b = prev ? prev [i] : 0;
+            const int c = (prev && i >= bpp) ? prev [i - bpp] : 0;
+
+            uchar value;
+            switch (filter)
+            {
+            case FilterSub: value = uchar (raw [i] - a); break;
+            case FilterUp: value = uchar (raw [i] - b); break;
+            case FilterAverage: value = uchar (raw [i] - ((a + b) >> 1)); break;
+            case FilterPaeth: value = uchar (raw [i] - ::Paeth (a, b, c)); break;
+            default: value = raw [i]; break;
+            }
+
+            dest [i] = value;
+            sum += (value < 128) ? value : 256 - value;
+        }
+
+        if (bestSum < 0)
+        {
+            out [0] = uchar (filter);
+            bestSum = sum;
+        }
+        else if (sum < bestSum)
+        {
+            scratch [0] = uchar (filter);
+            std::memcpy (out, scratch, size_t (rowBytes) + 1);
+            bestSum = sum;
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Returns the filtered data (filter type byte + filtered row) for rows
+// [<beginRow>, <endRow>) of <image>.
+static QByteArray FilterRows (const QImage &image, bool hasAlpha,
+        int beginRow, int endRow)
+{
+    const int bpp = hasAlpha ? 4 : 3;
+    const int rowBytes = image.width () * bpp;
+
+    QByteArray filtered;
+    filtered.resize ((endRow - beginRow) * (rowBytes + 1));
+
+    QVector <uchar> rawRows (2 * rowBytes), scratch (rowBytes + 1);
+    uchar *raw = rawRows.data (), *prev = raw + rowBytes;
+
+    if (beginRow > 0) {
+        ::GetRawRow (image, beginRow - 1, hasAlpha, prev);
+    }
+
+    for (int y = beginRow; y < endRow; y++)
+    {
+        ::GetRawRow (image, y, hasAlpha, raw);
+        ::FilterRow (raw, y > 0 ? prev : nullptr, rowBytes, bpp,
+            reinterpret_cast <uchar *> (filtered.data ()) + (y - beginRow) * (rowBytes + 1),
+            scratch.data ());
+        std::swap (raw, prev);
+    }
+
+    return filtered;
+}
+
+//---------------------------------------------------------------------
+
+// A block of rows, compressed.
+struct kpPNGWriterBlock
+{
+    QByteArray deflated;
+    quint32 adler{1};
+    qint64 filteredSize{0};
+};
+
+// Deflates <filtered> as raw deflate data, primed with <dictionary>, ending
+// with a sync flush (or the end of the stream if <isLast>).
+static bool DeflateBlock (const QByteArray &filtered, const QByteArray &dictionary,
+        bool isLast, int compressionLevel, kpPNGWriterBlock *block)
+{
+    z_stream stream;
+    std::memset (&stream, 0, sizeof (stream));
+
+    // (-15 window bits for raw deflate data, without the zlib wrapper)
+    if (deflateInit2 (&stream, compressionLevel, Z_DEFLATED, -15, 8,
+                      Z_FILTERED) != Z_OK)
+    {
+        return false;
+    }
+
+    if (!dictionary.isEmpty () &&
+        deflateSetDictionary (&stream,
+            reinterpret_cast <const Bytef *> (dictionary.constData ()),
+            uInt (dictionary.size ())) != Z_OK)
+    {
+        deflateEnd (&stream);
+        return false;
+    }
+
+    block->deflated.resize (int (deflateBound (&stream, uLong (filtered.size ()))) + 16);
+    stream.next_in = reinterpret_cast <Bytef *> (const_cast <char *> (filtered.constData ()));
+    stream.avail_in = uInt (filtered.size ());
+    stream.next_out = reinterpret_cast <Bytef *> (block->deflated.data ());
+    stream.avail_out = uInt (block->deflated.size ());
+
+    const int ret = deflate (&stream, isLast ? Z_FINISH : Z_SYNC_FLUSH);
+    const bool ok = isLast ? (ret == Z_STREAM_END) :
+                             (ret == Z_OK && stream.avail_in == 0);
+
+    block->deflated.resize (int (stream.total_out));
+    block->adler = quint32 (::adler32 (1,
+        reinterpret_cast <const Bytef *> (filtered.constData ()), uInt (filtered.size ())));
+    block->filteredSize = filtered.size ();
+
+    deflateEnd (&stream);
+    return ok;
+}
+
+//---------------------------------------------------------------------
+
+// Returns the zlib stream of the filtered image data.
+static bool CompressImage (const QImage &image, bool hasAlpha, int compressionLevel,
+        QByteArray *zlibStream)
+{
+    const int bpp = hasAlpha ? 4 : 3;
+    const int filteredRowBytes = image.width () * bpp + 1;
+
+    const int rowsPerBlock = qMax (1, BlockBytes / filteredRowBytes);
+    const int numBlocks = (image.height () + rowsPerBlock - 1) / rowsPerBlock;
+    // (rows needed before a block to fill the dictionary)
+    const int dictionaryRows = (DictionaryBytes + filteredRowBytes - 1) / filteredRowBytes;
+
+    QVector <kpPNGWriterBlock> blocks (numBlocks);
+    QVector <char> blockOK (numBlocks, 0);
+
+    kpParallel::forBands (numBlocks, 1, [&] (int begin, int end)
+    {
+        for (int i = begin; i < end; i++)
+        {
+            const int beginRow = i * rowsPerBlock;
+            const int endRow = qMin (image.height (), beginRow + rowsPerBlock);
+
+            // Filtering is deterministic so re-filtering the end of the
+            // previous block gives exactly the data it compressed.
+            QByteArray dictionary;
+            if (beginRow > 0)
+            {
+                const QByteArray prevFiltered = ::FilterRows (image, hasAlpha,
+                    qMax (0, beginRow - dictionaryRows), beginRow);
+                dictionary = prevFiltered.right (DictionaryBytes);
+            }
+
+            const QByteArray filtered = ::FilterRows (image, hasAlpha,
+                beginRow, endRow);
+
+            blockOK [i] = ::DeflateBlock (filtered, dictionary,
+                i == numBlocks - 1, compressionLevel, &blocks [i]);
+        }
+    });
+
+    // zlib header: deflate with a 32K window, no preset dictionary.
+    zlibStream->clear ();
+    zlibStream->append (char (0x78));
+    zlibStream->append (char (0x9C));
+
+    quint32 adler = 1;
+    for (int i = 0; i < numBlocks; i++)
+    {
+        if (!blockOK [i]) {
+            return false;
+        }
+
+        zlibStream->append (blocks [i].deflated);
+        adler = quint32 (::adler32_combine (adler, blocks [i].adler,
+                                            z_off_t (blocks [i].filteredSize)));
+    }
+
+    ::AppendUInt32 (zlibStream, adler);
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// Returns whether any pixel of <image> (32-bit) is not fully opaque.
+static bool HasTransparentPixels (const QImage &image)
+{
+    if (image.format () == QImage::Format_RGB32) {
+        return false;
+    }
+
+    QVector <char> bandHasTransparency (image.height (), 0);
+    kpParallel::forBands (image.height (), 256, [&] (int begin, int end)
+    {
+        for (int y = begin; y < end; y++)
+        {
+            const auto *line = reinterpret_cast <const QRgb *> (image.constScanLine (y));
+            for (int x = 0; x < image.width (); x++)
+            {
+                if (qAlpha (line [x]) != 255)
+                {
+                    bandHasTransparency [y] = 1;
+                    break;
+                }
+            }
+        }
+    });
+
+    return bandHasTransparency.contains (1);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPNGWriter::canWrite (const QImage &image)
+{
+    return (!image.isNull () &&
+            (image.format () == QImage::Format_ARGB32_Premultiplied ||
+             image.format () == QImage::Format_ARGB32 ||
+             image.format () == QImage::Format_RGB32));
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPNGWriter::write (const QImage &image, QIODevice *device,
+        int compressionLevel)
+{
+    KP_TRACE_SCOPE ("imagelib", "kpPNGWriter::write");
+
+    Q_ASSERT (device);
+
+    if (!kpPNGWriter::canWrite (image)) {
+        return false;
+    }
+
+    const bool hasAlpha = ::HasTransparentPixels (image);
+
+#if DEBUG_KP_PNG_WRITER
+    qCDebug(kpLogImagelib) << "kpPNGWriter::write() w=" << image.width ()
+                           << "h=" << image.height ()
+                           << "hasAlpha=" << hasAlpha
+                           << "threads=" << kpParallel::maxThreadCount ();
+#endif
+
+    QByteArray zlibStream;
+    if (!::CompressImage (image, hasAlpha, compressionLevel, &zlibStream)) {
+        qCWarning(kpLogImagelib) << "kpPNGWriter::write() could not compress";
+        return false;
+    }
+
+
+    static const char signature [8] = {char (137), 'P', 'N', 'G', '\r', '\n', 26, '\n'};
+    if (device->write (signature, 8) != 8) {
+        return false;
+    }
+
+    QByteArray ihdr;
+    ::AppendUInt32 (&ihdr, quint32 (image.width ()));
+    ::AppendUInt32 (&ihdr, quint32 (image.height ()));
+    ihdr.append (char (8));  // bit depth
+    ihdr.append (char (hasAlpha ? 6 : 2));  // color type: RGBA or RGB
+    ihdr.append (char (0));  // compression: deflate
+    ihdr.append (char (0));  // filter method: adaptive
+    ihdr.append (char (0));  // no interlace
+    if (!::WriteChunk (device, "IHDR", ihdr)) {
+        return false;
+    }
+
+    // Dots per meter
+    if (image.dotsPerMeterX () > 0 && image.dotsPerMeterY () > 0)
+    {
+        QByteArray phys;
+        ::AppendUInt32 (&phys, quint32 (image.dotsPerMeterX ()));
+        ::AppendUInt32 (&phys, quint32 (image.dotsPerMeterY ()));
+        phys.append (char (1));  // unit: meter
+        if (!::WriteChunk (device, "pHYs", phys)) {
+            return false;
+        }
+    }
+
+    // Offset
+    if (!image.offset ().isNull ())
+    {
+        QByteArray offs;
+        ::AppendUInt32 (&offs, quint32 (image.offset ().x ()));
+        ::AppendUInt32 (&offs, quint32 (image.offset ().y ()));
+        offs.append (char (0));  // unit: pixel
+        if (!::WriteChunk (device, "oFFs", offs)) {
+            return false;
+        }
+    }
+
+    // Text
+    for (const auto &key : image.textKeys ())
+    {
+        const QString text = image.text (key);
+
+        // tEXt is Latin-1 only, otherwise use (uncompressed) iTXt.
+        const QByteArray keyLatin1 = key.left (79).toLatin1 ();
+        const bool isLatin1 = (QString::fromLatin1 (text.toLatin1 ()) == text);
+
+        QByteArray data = keyLatin1;
+        data.append (char (0));
+        if (isLatin1)
+        {
+            data.append (text.toLatin1 ());
+            if (!::WriteChunk (device, "tEXt", data)) {
+                return false;
+            }
+        }
+        else
+        {
+            data.append (char (0));  // not compressed
+            data.append (char (0));  // compression method
+            data.append (char (0));  // no language tag
+            data.append (char (0));  // no translated keyword
+            data.append (text.toUtf8 ());
+            if (!::WriteChunk (device, "iTXt", data)) {
+                return false;
+            }
+        }
+    }
+
+    // Image data
+    for (int i = 0; i < zlibStream.size (); i += MaxIDATBytes)
+    {
+        if (!::WriteChunk (device, "IDAT", zlibStream.mid (i, MaxIDATBytes))) {
+            return false;
+        }
+    }
+
+    return ::WriteChunk (device, "IEND", QByteArray ());
+}
+
+//---------------------------------------------------------------------
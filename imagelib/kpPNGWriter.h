@@ -0,0 +1,62 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpPNGWriter_H
+#define kpPNGWriter_H
+
+
+#include <QImage>
+
+
+class QIODevice;
+
+
+//
+// Writes 32-bit images as PNG, compressing on all cores.
+//
+// The rows are filtered and deflated in independent blocks, in parallel,
+// each primed with the end of the previous block and sync flushed, the
+// same way as pigz.  The blocks are then joined into a single valid zlib
+// stream.
+//
+// The image's text (QImage::textKeys()), dots per meter and offset are
+// written too, like QImageWriter does.
+//
+class kpPNGWriter
+{
+public:
+    // Returns whether write() can write <image>.  Only 32-bit images are
+    // supported -- use QImageWriter for the others.
+    static bool canWrite (const QImage &image);
+
+    // <compressionLevel> is a zlib level (0-9 or -1 for the default).
+    static bool write (const QImage &image, QIODevice *device,
+                       int compressionLevel = -1);
+};
+
+
+#endif  // kpPNGWriter_H
@@ -31,15 +31,18 @@
 
 #include "kpPainter.h"
 
+#include "generic/kpRandom.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "tools/kpTool.h"
 #include "tools/flow/kpToolFlowBase.h"
 
 #include <cstdio>
 
+#include <QHash>
 #include <QPainter>
 #include <QPolygon>
 #include <QRandomGenerator>
+#include <QVector>
 
 #include "kpLogCategories.h"
 
@@ -469,44 +472,138 @@ QRect kpPainter::washRect (kpImage *image,
 
 //---------------------------------------------------------------------
 
+// Returns the offsets from the centre of the squares, among the
+// <spraycanSize> x <spraycanSize> squares around it, that lie within the
+// spraycan's circle.
+//
+// The spraycan only has a few sizes, so these are only computed once per
+// size.  Only call this from the GUI thread.
+static const QVector <QPoint> &SprayDiscOffsets (int spraycanSize)
+{
+    static QHash <int, QVector <QPoint>> discOffsets;
+
+    auto it = discOffsets.find (spraycanSize);
+    if (it == discOffsets.end ())
+    {
+        const int radius = spraycanSize / 2;
+
+        QVector <QPoint> offsets;
+        for (int dy = -radius; dy < spraycanSize - radius; dy++)
+        {
+            for (int dx = -radius; dx < spraycanSize - radius; dx++)
+            {
+                if ((dx * dx) + (dy * dy) <= (radius * radius)) {
+                    offsets.append (QPoint (dx, dy));
+                }
+            }
+        }
+
+        it = discOffsets.insert (spraycanSize, offsets);
+    }
+
+    return *it;
+}
+
+//---------------------------------------------------------------------
+
 // public static
-void kpPainter::sprayPoints (kpImage *image,
+QRect kpPainter::sprayPoints (kpImage *image,
         const QList <QPoint> &points,
         const kpColor &color,
-        int spraycanSize)
+        int spraycanSize,
+        kpRandom *random)
 {
 #if DEBUG_KP_PAINTER
     qCDebug(kpLogImagelib) << "kpPainter::sprayPoints()";
 #endif
 
     Q_ASSERT (spraycanSize > 0);
+    Q_ASSERT (random);
 
-    QPainter painter(image);
-    const int radius = spraycanSize / 2;
+    // Spraying used to go through QPainter, where a transparent pen
+    // draws nothing.
+    if (color.isTransparent ()) {
+        return {};
+    }
 
-    // Set the drawing colors for the painters.
+    const QRgb rgb = color.toQRgb ();
 
-    painter.setPen(color.toQColor());
+    // Opaque dots are written to the pixels directly, since an opaque QRgb
+    // means the same in all of these formats.
+    //
+    // The color can also be translucent (QColorDialog::ShowAlphaChannel),
+    // in which case each dot must be blended with what is under it - and
+    // with the dots sprayed at the same place before it - so go through
+    // QPainter, like spraying always used to.
+    const bool writeDirectly = (qAlpha (rgb) == 255);
+
+    QPainter painter;
+    uchar *bits = nullptr;
+    int bytesPerLine = 0;
+
+    if (writeDirectly)
+    {
+        if (image->format () != QImage::Format_RGB32 &&
+            image->format () != QImage::Format_ARGB32 &&
+            image->format () != QImage::Format_ARGB32_Premultiplied)
+        {
+            *image = image->convertToFormat (QImage::Format_ARGB32_Premultiplied);
+        }
+
+        bits = image->bits ();
+        bytesPerLine = image->bytesPerLine ();
+    }
+    else
+    {
+        painter.begin (image);
+        painter.setPen (color.toQColor ());
+    }
+
+    const int width = image->width (), height = image->height ();
+
+    const QVector <QPoint> &disc = ::SprayDiscOffsets (spraycanSize);
+    const quint32 numSquares = quint32 (spraycanSize * spraycanSize);
+
+    int minX = width, minY = height, maxX = -1, maxY = -1;
 
     for (const auto &p : points)
     {
         for (int i = 0; i < 10; i++)
         {
-            const int dx = (QRandomGenerator::global()->generate() % spraycanSize) - radius;
-            const int dy = (QRandomGenerator::global()->generate() % spraycanSize) - radius;
+            // Pick one of the squares around <p> and, to make it look
+            // circular, only draw it if it's within the circle.  This has
+            // the same density as picking a random dx and dy and rejecting
+            // the ones outside the circle.
+            const quint32 square = random->bounded (numSquares);
+            if (square >= quint32 (disc.size ())) {
+                continue;
+            }
 
-            // Make it look circular.
-            // TODO: Can be done better by doing a random vector angle & length
-            //       but would sin and cos be too slow?
-            if ((dx * dx) + (dy * dy) > (radius * radius)) {
+            const int x = p.x () + disc [int (square)].x ();
+            const int y = p.y () + disc [int (square)].y ();
+            if (x < 0 || y < 0 || x >= width || y >= height) {
                 continue;
             }
 
-            const QPoint p2 (p.x () + dx, p.y () + dy);
+            if (writeDirectly) {
+                reinterpret_cast <QRgb *> (bits + qint64 (y) * bytesPerLine) [x] = rgb;
+            }
+            else {
+                painter.drawPoint (x, y);
+            }
 
-            painter.drawPoint(p2);
+            minX = qMin (minX, x);
+            minY = qMin (minY, y);
+            maxX = qMax (maxX, x);
+            maxY = qMax (maxY, y);
         }
     }
+
+    if (maxX < 0) {
+        return {};
+    }
+
+    return QRect (QPoint (minX, minY), QPoint (maxX, maxY));
 }
 
 //---------------------------------------------------------------------
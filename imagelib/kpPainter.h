@@ -34,6 +34,7 @@
 #include "kpImage.h"
 
 
+class kpRandom;
 
 
 //
@@ -122,15 +123,19 @@ public:
         const kpColor &colorToReplace,
         int processedColorSimilarity);
 
-    // For each point in <points>, sprays a random pattern of 10 dots of <color>,
-    // each within a circle of diameter <spraycanSize>, onto <image>.
+    // For each point in <points>, sprays a random pattern of up to 10 dots
+    // of <color>, each within a circle of diameter <spraycanSize>, onto
+    // <image>.  The pattern is picked using <random>.
+    //
+    // Returns the dirty rectangle.
     //
     // ASSUMPTION: spraycanSize > 0.
     // TODO: I think this diameter is 1 or 2 off.
-    static void sprayPoints (kpImage *image,
+    static QRect sprayPoints (kpImage *image,
         const QList <QPoint> &points,
         const kpColor &color,
-        int spraycanSize);
+        int spraycanSize,
+        kpRandom *random);
 };
 
 
@@ -0,0 +1,142 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpPixelReplicator.h"
+
+#include <QColor>
+
+#include <algorithm>
+#include <vector>
+
+#include "generic/kpParallel.h"
+
+//---------------------------------------------------------------------
+
+// Don't bother splitting the replication of less than this many view
+// pixels between threads.
+static const int MinPixelsPerBand = 64 * 1024;
+
+// Returns <a> / <b> rounded towards negative infinity, for <b> > 0.
+static int FloorDiv (int a, int b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QImage kpPixelReplicator::replicate (const QImage &docImage, const QRect &docRect,
+        const QRect &viewRect, const QPoint &origin,
+        int hzoom, int vzoom, bool withGridLines)
+{
+    const QImage src = docImage.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    QImage dest (viewRect.size (), QImage::Format_ARGB32_Premultiplied);
+
+    // (detach before sharing between threads -- scanLine() would detach
+    //  from each of them)
+    uchar *destBits = dest.bits ();
+    const int destBytesPerLine = dest.bytesPerLine ();
+
+    const int width = viewRect.width ();
+    const QRgb gridRgb = QColor (Qt::gray).rgb ();
+
+    // The first view column of a vertical grid line, relative to <viewRect>.
+    int firstGridX = viewRect.x ();
+    if (firstGridX % hzoom) {
+        firstGridX = (firstGridX + hzoom) / hzoom * hzoom;
+    }
+    firstGridX -= viewRect.x ();
+
+    // Builds the view row showing row <srcY> of <src> into <destLine>.
+    const auto buildRow = [&] (int srcY, QRgb *destLine)
+    {
+        const auto *srcLine = reinterpret_cast <const QRgb *> (src.constScanLine (srcY));
+
+        for (int x = 0; x < width; /*x is advanced below*/)
+        {
+            const int docX = ::FloorDiv (viewRect.x () + x - origin.x (), hzoom);
+            const int srcX = docX - docRect.x ();
+
+            // All view columns up to the next document column.
+            const int runEnd = qMin (width,
+                (docX + 1) * hzoom + origin.x () - viewRect.x ());
+
+            std::fill (destLine + x, destLine + runEnd,
+                       (srcX >= 0 && srcX < src.width ()) ? srcLine [srcX] : 0);
+            x = runEnd;
+        }
+    };
+
+    kpParallel::forBands (viewRect.height (), qMax (1, MinPixelsPerBand / qMax (1, width)),
+        [&] (int begin, int end)
+    {
+        std::vector <QRgb> row (width);
+        int rowSrcY = -1;
+
+        for (int y = begin; y < end; y++)
+        {
+            auto *destLine = reinterpret_cast <QRgb *> (
+                destBits + qint64 (y) * destBytesPerLine);
+            const int viewY = viewRect.y () + y;
+
+            if (withGridLines && viewY % vzoom == 0)
+            {
+                std::fill (destLine, destLine + width, gridRgb);
+                continue;
+            }
+
+            const int srcY = ::FloorDiv (viewY - origin.y (), vzoom) - docRect.y ();
+            if (srcY < 0 || srcY >= src.height ())
+            {
+                std::fill (destLine, destLine + width, 0);
+            }
+            else
+            {
+                if (srcY != rowSrcY)
+                {
+                    buildRow (srcY, row.data ());
+                    rowSrcY = srcY;
+                }
+
+                std::copy (row.begin (), row.end (), destLine);
+            }
+
+            // (the vertical grid lines go all the way down <viewRect>, even
+            //  outside the document)
+            if (withGridLines)
+            {
+                for (int x = firstGridX; x < width; x += hzoom) {
+                    destLine [x] = gridRgb;
+                }
+            }
+        }
+    });
+
+    return dest;
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,63 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpPixelReplicator_H
+#define kpPixelReplicator_H
+
+
+#include <QImage>
+#include <QPoint>
+#include <QRect>
+
+
+//
+// Zooms images in by integer factors, as the view does at 200%, 300%, ...
+//
+class kpPixelReplicator
+{
+public:
+    // Returns the part of the view given by <viewRect>, showing <docImage>
+    // (the part of the document given by <docRect>) zoomed in by the integer
+    // factors <hzoom> x <vzoom>, with document pixel (0, 0) at the view
+    // position <origin>.  View pixels outside <docRect> are transparent.
+    //
+    // This replicates pixels just like QPainter::scale() + drawImage() would
+    // at these zoom levels, but without going through the transformed
+    // drawing path: each view row is built once, as runs of identical
+    // pixels, and then copied to all the other view rows showing the same
+    // document row.
+    //
+    // If <withGridLines>, the grid lines that
+    // kpView::paintEventDrawGridLines() would draw inside <viewRect> are
+    // written as well, whether or not they are over the document.
+    static QImage replicate (const QImage &docImage, const QRect &docRect,
+                             const QRect &viewRect, const QPoint &origin,
+                             int hzoom, int vzoom, bool withGridLines);
+};
+
+
+#endif  // kpPixelReplicator_H
@@ -51,25 +51,25 @@ void kpTransformCrop (kpMainWindow *mainWindow)
     Q_ASSERT (sel);
 
 
-    kpCommand *resizeDocCommand =
-        new kpTransformResizeScaleCommand (
-            false/*act on doc, not sel*/,
-            sel->width (), sel->height (),
-            kpTransformResizeScaleCommand::Resize,
-            mainWindow->commandEnvironment ());
-
-
     auto *textSel = dynamic_cast <kpTextSelection *> (sel);
     auto *imageSel = dynamic_cast <kpAbstractImageSelection *> (sel);
     // It's either a text selection or an image selection, but cannot be
     // neither or both.
     Q_ASSERT (!!textSel != !!imageSel);
 
-    if (textSel) {
+    if (textSel)
+    {
+        kpCommand *resizeDocCommand =
+            new kpTransformResizeScaleCommand (
+                false/*act on doc, not sel*/,
+                sel->width (), sel->height (),
+                kpTransformResizeScaleCommand::Resize,
+                mainWindow->commandEnvironment ());
+
         ::kpTransformCrop_TextSelection (mainWindow, i18n ("Set as Image"), resizeDocCommand);
     }
     else if (imageSel) {
-        ::kpTransformCrop_ImageSelection (mainWindow, i18n ("Set as Image"), resizeDocCommand);
+        ::kpTransformCrop_ImageSelection (mainWindow, i18n ("Set as Image"));
     }
     else {
         Q_ASSERT (!"unreachable");
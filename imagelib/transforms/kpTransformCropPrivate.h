@@ -42,8 +42,13 @@ class kpMainWindow;
 // which resizes the document to the size of the selection.
 void kpTransformCrop_TextSelection (kpMainWindow *mainWindow,
         const QString &commandName, kpCommand *resizeDocCommand);
+
+// Adds a kpMacroCommand, with name <commandName>, to the command history.
+//
+// The document is resized to the size of the selection as part of setting
+// it to the selection image.
 void kpTransformCrop_ImageSelection (kpMainWindow *mainWindow,
-        const QString &commandName, kpCommand *resizeDocCommand);
+        const QString &commandName);
 
 
 #endif  // kpTransformCropPrivate_H
@@ -39,10 +39,14 @@
 #include "imagelib/kpImage.h"
 #include "commands/kpMacroCommand.h"
 #include "mainWindow/kpMainWindow.h"
+#include "imagelib/transforms/kpTransformEdgeDelta.h"
 #include "pixmapfx/kpPixmapFX.h"
 #include "commands/tools/selection/kpToolSelectionCreateCommand.h"
 #include "views/manager/kpViewManager.h"
 
+#include <QRegion>
+#include <QVector>
+
 
 // See the "image selection" part of the kpTransformCrop() API Doc.
 //
@@ -58,21 +62,27 @@ public:
 
     kpCommandSize::SizeType size () const override
     {
-        return ImageSize (m_oldImage) +
-               SelectionSize (m_fromSelectionPtr) +
-               ImageSize (m_imageIfFromSelectionDoesntHaveOne);
+        kpCommandSize::SizeType s = m_oldEdges.size () +
+                                    SelectionSize (m_fromSelectionPtr);
+        for (const auto &tile : m_oldTiles) {
+            s += ImageSize (tile);
+        }
+        return s;
     }
 
-    // ASSUMPTION: Document has been resized to be the same size as the
-    //             selection.
     void execute () override;
     void unexecute () override;
 
 protected:
     kpColor m_backgroundColor;
-    kpImage m_oldImage;
     kpAbstractImageSelection *m_fromSelectionPtr;
-    kpImage m_imageIfFromSelectionDoesntHaveOne;
+
+    // The document outside of the selection's bounding rectangle...
+    kpTransformEdgeDelta m_oldEdges;
+    // ...and the tiles inside it that the selection image replaced
+    // (relative to m_oldEdges.keptRect()).
+    QVector <QRect> m_oldRects;
+    QVector <kpImage> m_oldTiles;
 };
 
 
@@ -84,14 +94,6 @@ SetDocumentToSelectionImageCommand::SetDocumentToSelectionImageCommand (kpComman
             environ->document ()->selection ()->clone ()))
 {
     Q_ASSERT (m_fromSelectionPtr);
-
-    if ( m_fromSelectionPtr )  // make coverity happy
-    {
-      m_imageIfFromSelectionDoesntHaveOne =
-        m_fromSelectionPtr->hasContent () ?
-            kpImage () :
-            document ()->getSelectedBaseImage ();
-    }
 }
 
 //---------------------------------------------------------------------
@@ -112,12 +114,8 @@ void SetDocumentToSelectionImageCommand::execute ()
 
     viewManager ()->setQueueUpdates ();
     {
-        // kpTransformCrop_ImageSelection's <resizeDocCommand> has
-        // executed, resizing the document to be the size of the selection
-        // bounding rectangle.
-        Q_ASSERT (document ()->width () == m_fromSelectionPtr->width ());
-        Q_ASSERT (document ()->height () == m_fromSelectionPtr->height ());
-        m_oldImage = document ()->image ();
+        const kpImage oldImage = document ()->image ();
+        const QRect selRect = m_fromSelectionPtr->boundingRect ();
 
 
         //
@@ -139,11 +137,11 @@ void SetDocumentToSelectionImageCommand::execute ()
         //       any transparent pixels.
         //
 
-        QImage newDocImage(document()->width(), document()->height(), QImage::Format_ARGB32_Premultiplied);
+        QImage newDocImage(selRect.width(), selRect.height(), QImage::Format_ARGB32_Premultiplied);
         newDocImage.fill(m_backgroundColor.toQRgb());
 
     #if DEBUG_KP_TOOL_CROP
-        qCDebug(kpLogImagelib) << "\tsel: rect=" << m_fromSelectionPtr->boundingRect ()
+        qCDebug(kpLogImagelib) << "\tsel: rect=" << selRect
                    << " pm=" << m_fromSelectionPtr->hasContent ();
     #endif
         QImage setTransparentImage;
@@ -159,7 +157,10 @@ void SetDocumentToSelectionImageCommand::execute ()
         }
         else
         {
-            setTransparentImage = m_imageIfFromSelectionDoesntHaveOne;
+            // (the document still has the pixels under the selection, so
+            //  there is no need to keep a copy of them around for redo)
+            setTransparentImage = m_fromSelectionPtr->givenImageMaskedByShape (
+                document ()->getImageAt (selRect));
         #if DEBUG_KP_TOOL_CROP
             qCDebug(kpLogImagelib) << "\tno pixmap in sel - get it; rect="
                        << setTransparentImage.rect ();
@@ -171,7 +172,41 @@ void SetDocumentToSelectionImageCommand::execute ()
             setTransparentImage);
 
 
-        document ()->setImageAt (newDocImage, QPoint (0, 0));
+        //
+        // Save for undo, only what the crop actually loses: the document
+        // around the selection, and the tiles under the selection that
+        // are no longer the same (e.g. outside of an elliptical selection
+        // or under a selection with content).
+        //
+
+        m_oldEdges = kpTransformEdgeDelta (oldImage, selRect);
+
+        m_oldRects.clear ();
+        m_oldTiles.clear ();
+
+        const QRect keptRect = m_oldEdges.keptRect ();
+        if (!keptRect.isEmpty ())
+        {
+            const kpImage oldKeptImage = kpPixmapFX::getPixmapAt (oldImage, keptRect);
+            const kpImage newKeptImage = kpPixmapFX::getPixmapAt (newDocImage,
+                keptRect.translated (-selRect.topLeft ()));
+
+            const QRegion changed = kpPixmapFX::changedRegion (oldKeptImage,
+                                                               newKeptImage);
+            for (const auto &rect : changed)
+            {
+                m_oldRects.append (rect);
+                m_oldTiles.append (kpPixmapFX::getPixmapAt (oldKeptImage, rect));
+            }
+        }
+
+    #if DEBUG_KP_TOOL_CROP
+        qCDebug(kpLogImagelib) << "\tundo size=" << size ()
+                   << " instead of " << ImageSize (oldImage);
+    #endif
+
+
+        document ()->setImage (newDocImage);
         document ()->selectionDelete ();
 
 
@@ -191,11 +226,28 @@ void SetDocumentToSelectionImageCommand::unexecute ()
 
     viewManager ()->setQueueUpdates ();
     {
-        document ()->setImageAt (m_oldImage, QPoint (0, 0));
-        m_oldImage = kpImage ();
+        const QRect selRect = m_fromSelectionPtr->boundingRect ();
+        const QRect keptRect = m_oldEdges.keptRect ();
+
+        kpImage keptImage;
+        if (!keptRect.isEmpty ())
+        {
+            keptImage = kpPixmapFX::getPixmapAt (document ()->image (),
+                keptRect.translated (-selRect.topLeft ()));
+
+            for (int i = 0; i < m_oldRects.count (); i++) {
+                kpPixmapFX::setPixmapAt (&keptImage, m_oldRects [i], m_oldTiles [i]);
+            }
+        }
+
+        document ()->setImage (m_oldEdges.restore (keptImage));
+
+        m_oldEdges = kpTransformEdgeDelta ();
+        m_oldRects.clear ();
+        m_oldTiles.clear ();
 
     #if DEBUG_KP_TOOL_CROP
-        qCDebug(kpLogImagelib) << "\tsel: rect=" << m_fromSelectionPtr->boundingRect ()
+        qCDebug(kpLogImagelib) << "\tsel: rect=" << selRect
                    << " pm=" << m_fromSelectionPtr->hasContent ();
     #endif
         document ()->setSelection (*m_fromSelectionPtr);
@@ -209,7 +261,7 @@ void SetDocumentToSelectionImageCommand::unexecute ()
 
 
 void kpTransformCrop_ImageSelection (kpMainWindow *mainWindow,
-        const QString &commandName, kpCommand *resizeDocCommand)
+        const QString &commandName)
 {
     // Save starting selection, minus the border.
     auto *borderImageSel = dynamic_cast <kpAbstractImageSelection *> (
@@ -228,10 +280,8 @@ void kpTransformCrop_ImageSelection (kpMainWindow *mainWindow,
     auto *environ = mainWindow->commandEnvironment ();
     auto *macroCmd = new kpMacroCommand (commandName, environ);
 
-    // (must resize doc _before_ SetDocumentToSelectionImageCommand in case
-    //  doc needs to gets bigger - else selection image may not fit)
-    macroCmd->addCommand (resizeDocCommand);
-
+    // (SetDocumentToSelectionImageCommand resizes the document itself, so
+    //  that it only has to save the edges that are cropped off for undo)
 #if DEBUG_KP_TOOL_CROP
     qCDebug(kpLogImagelib) << "\tis pixmap sel";
     qCDebug(kpLogImagelib) << "\tcreating SetImage cmd";
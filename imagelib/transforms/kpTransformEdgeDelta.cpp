@@ -0,0 +1,167 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_TRANSFORM_EDGE_DELTA 0
+
+
+#include "kpTransformEdgeDelta.h"
+
+#include "kpLogCategories.h"
+
+#include "pixmapfx/kpPixmapFX.h"
+
+//---------------------------------------------------------------------
+
+kpTransformEdgeDelta::kpTransformEdgeDelta () = default;
+
+//---------------------------------------------------------------------
+
+kpTransformEdgeDelta::kpTransformEdgeDelta (const kpImage &oldImage,
+                                            const QRect &keptRect)
+    : m_oldSize (oldImage.size ()),
+      m_keptRect (keptRect & oldImage.rect ())
+{
+    const QRect oldRect = oldImage.rect ();
+
+    // Nothing kept?  Then it's all "edge".
+    if (m_keptRect.isEmpty ())
+    {
+        m_keptRect = QRect ();
+        m_topImage = oldImage;
+        return;
+    }
+
+    if (m_keptRect.top () > oldRect.top ())
+    {
+        m_topImage = kpPixmapFX::getPixmapAt (oldImage,
+            QRect (0, 0, oldRect.width (), m_keptRect.top ()));
+    }
+
+    if (m_keptRect.bottom () < oldRect.bottom ())
+    {
+        m_bottomImage = kpPixmapFX::getPixmapAt (oldImage,
+            QRect (0, m_keptRect.bottom () + 1,
+                   oldRect.width (), oldRect.bottom () - m_keptRect.bottom ()));
+    }
+
+    if (m_keptRect.left () > oldRect.left ())
+    {
+        m_leftImage = kpPixmapFX::getPixmapAt (oldImage,
+            QRect (0, m_keptRect.top (),
+                   m_keptRect.left (), m_keptRect.height ()));
+    }
+
+    if (m_keptRect.right () < oldRect.right ())
+    {
+        m_rightImage = kpPixmapFX::getPixmapAt (oldImage,
+            QRect (m_keptRect.right () + 1, m_keptRect.top (),
+                   oldRect.right () - m_keptRect.right (), m_keptRect.height ()));
+    }
+
+#if DEBUG_KP_TRANSFORM_EDGE_DELTA
+    qCDebug(kpLogImagelib) << "kpTransformEdgeDelta::<ctor>() oldSize=" << m_oldSize
+                           << " keptRect=" << m_keptRect
+                           << " size=" << size ();
+#endif
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpTransformEdgeDelta::isNull () const
+{
+    return m_oldSize.isEmpty ();
+}
+
+//---------------------------------------------------------------------
+
+// public
+QSize kpTransformEdgeDelta::oldSize () const
+{
+    return m_oldSize;
+}
+
+//---------------------------------------------------------------------
+
+// public
+QRect kpTransformEdgeDelta::keptRect () const
+{
+    return m_keptRect;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpCommandSize::SizeType kpTransformEdgeDelta::size () const
+{
+    return kpCommandSize::ImageSize (m_topImage) +
+           kpCommandSize::ImageSize (m_bottomImage) +
+           kpCommandSize::ImageSize (m_leftImage) +
+           kpCommandSize::ImageSize (m_rightImage);
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpImage kpTransformEdgeDelta::restore (const kpImage &keptImage) const
+{
+    Q_ASSERT (!isNull ());
+
+    kpImage image (m_oldSize, QImage::Format_ARGB32_Premultiplied);
+
+    if (!m_keptRect.isEmpty ())
+    {
+        Q_ASSERT (keptImage.width () >= m_keptRect.width () &&
+                  keptImage.height () >= m_keptRect.height ());
+
+        kpPixmapFX::setPixmapAt (&image, m_keptRect, keptImage);
+    }
+
+    if (!m_topImage.isNull ()) {
+        kpPixmapFX::setPixmapAt (&image, QPoint (0, 0), m_topImage);
+    }
+
+    if (!m_bottomImage.isNull ()) {
+        kpPixmapFX::setPixmapAt (&image, QPoint (0, m_keptRect.bottom () + 1),
+                                 m_bottomImage);
+    }
+
+    if (!m_leftImage.isNull ()) {
+        kpPixmapFX::setPixmapAt (&image, QPoint (0, m_keptRect.top ()),
+                                 m_leftImage);
+    }
+
+    if (!m_rightImage.isNull ()) {
+        kpPixmapFX::setPixmapAt (&image,
+                                 QPoint (m_keptRect.right () + 1, m_keptRect.top ()),
+                                 m_rightImage);
+    }
+
+    return image;
+}
+
+//---------------------------------------------------------------------
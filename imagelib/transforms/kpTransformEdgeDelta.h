@@ -0,0 +1,87 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpTransformEdgeDelta_H
+#define kpTransformEdgeDelta_H
+
+
+#include <QRect>
+#include <QSize>
+
+#include "commands/kpCommandSize.h"
+#include "imagelib/kpImage.h"
+
+
+//
+// Undo data for resizing or cropping an image, when the result still
+// contains some rectangle of the original pixels unchanged.
+//
+// Only the parts of the original image outside of that "kept" rectangle
+// are saved, as up to 4 strips:
+//
+//     +---------------+
+//     |      top      |
+//     +----+-----+----+
+//     |left| kept|rght|
+//     +----+-----+----+
+//     |     bottom    |
+//     +---------------+
+//
+// So trimming a few pixels off the edges of a huge image only costs those
+// few pixels (kpTransformAutoCropCommand does the same for its borders).
+//
+class kpTransformEdgeDelta
+{
+public:
+    kpTransformEdgeDelta ();
+
+    // Saves the parts of <oldImage> outside <keptRect>, which is clipped
+    // to the rectangle of <oldImage>.
+    kpTransformEdgeDelta (const kpImage &oldImage, const QRect &keptRect);
+
+    bool isNull () const;
+
+    QSize oldSize () const;
+    QRect keptRect () const;
+
+    kpCommandSize::SizeType size () const;
+
+    // Returns the original image, given <keptImage>, whose top-left
+    // keptRect().size() pixels must be what was at keptRect() originally.
+    //
+    // The result is in QImage::Format_ARGB32_Premultiplied.
+    kpImage restore (const kpImage &keptImage) const;
+
+private:
+    QSize m_oldSize;
+    QRect m_keptRect;
+
+    kpImage m_topImage, m_bottomImage, m_leftImage, m_rightImage;
+};
+
+
+#endif  // kpTransformEdgeDelta_H
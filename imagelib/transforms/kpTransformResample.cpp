@@ -0,0 +1,419 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_TRANSFORM_RESAMPLE 0
+
+
+#include "imagelib/transforms/kpTransformResample.h"
+
+#include <cmath>
+#include <cstring>
+
+#include <QtMath>
+#include <QSize>
+#include <QVector>
+
+#include "kpLogCategories.h"
+
+#include "generic/kpParallel.h"
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+namespace
+{
+
+// Filter weights are fixed point with this many fractional bits.
+// 255 * (1 << 14) * (sum of positive lobes) comfortably fits in 32 bits.
+const int WeightBits = 14;
+const qint32 WeightOne = 1 << WeightBits;
+
+// Don't bother giving a thread less work than this (in source pixel reads).
+const int MinReadsPerBand = 256 * 1024;
+
+//---------------------------------------------------------------------
+
+double FilterSupport (kpTransformResample::Filter filter)
+{
+    switch (filter)
+    {
+    case kpTransformResample::Box:
+        return 0.5;
+    case kpTransformResample::Bilinear:
+        return 1.0;
+    case kpTransformResample::Bicubic:
+        return 2.0;
+    case kpTransformResample::Lanczos3:
+        return 3.0;
+    }
+
+    return 1.0;
+}
+
+double Sinc (double x)
+{
+    if (x == 0) {
+        return 1.0;
+    }
+
+    x *= M_PI;
+    return std::sin (x) / x;
+}
+
+double FilterValue (kpTransformResample::Filter filter, double x)
+{
+    x = std::fabs (x);
+
+    switch (filter)
+    {
+    case kpTransformResample::Box:
+        return (x <= 0.5) ? 1.0 : 0.0;
+
+    case kpTransformResample::Bilinear:
+        return (x < 1.0) ? 1.0 - x : 0.0;
+
+    case kpTransformResample::Bicubic:
+    {
+        // Catmull-Rom (Keys' cubic with a = -0.5).
+        const double a = -0.5;
+        if (x < 1.0) {
+            return ((a + 2.0) * x - (a + 3.0)) * x * x + 1.0;
+        }
+        if (x < 2.0) {
+            return ((a * x - 5.0 * a) * x + 8.0 * a) * x - 4.0 * a;
+        }
+        return 0.0;
+    }
+
+    case kpTransformResample::Lanczos3:
+        return (x < 3.0) ? ::Sinc (x) * ::Sinc (x / 3.0) : 0.0;
+    }
+
+    return 0.0;
+}
+
+//---------------------------------------------------------------------
+
+// The source pixels, and their weights, that make up each destination pixel
+// along 1 axis.
+struct Contributions
+{
+    // Destination pixel <i> is the sum of source pixels
+    // [first [i], first [i] + count [i]) multiplied by
+    // weights [i * maxCount], weights [i * maxCount + 1], ...
+    QVector <int> first;
+    QVector <int> count;
+    int maxCount;
+    QVector <qint32> weights;
+};
+
+Contributions ComputeContributions (int srcSize, int dstSize,
+                                    kpTransformResample::Filter filter)
+{
+    const double scale = double (dstSize) / double (srcSize);
+    // Widen the filter when shrinking, so that every source pixel counts.
+    const double filterScale = qMax (1.0, 1.0 / scale);
+    const double support = ::FilterSupport (filter) * filterScale;
+
+    Contributions c;
+    c.first.resize (dstSize);
+    c.count.resize (dstSize);
+    c.maxCount = int (std::ceil (support * 2)) + 2;
+    c.weights.fill (0, dstSize * c.maxCount);
+
+    QVector <double> w (c.maxCount);
+
+    for (int i = 0; i < dstSize; i++)
+    {
+        const double center = (i + 0.5) / scale;
+
+        int left = qMax (0, int (std::floor (center - support)));
+        int right = qMin (srcSize, int (std::ceil (center + support)));
+        right = qMax (right, left + 1);
+        Q_ASSERT (right - left <= c.maxCount);
+
+        double sum = 0;
+        for (int j = left; j < right; j++)
+        {
+            w [j - left] = ::FilterValue (filter, (j + 0.5 - center) / filterScale);
+            sum += w [j - left];
+        }
+
+        // Can only happen with Box at awkward scales -- use the nearest pixel.
+        if (sum == 0)
+        {
+            left = qBound (0, int (center), srcSize - 1);
+            right = left + 1;
+            w [0] = sum = 1.0;
+        }
+
+        qint32 *out = c.weights.data () + i * c.maxCount;
+        const int n = right - left;
+
+        // Normalize, making sure that the weights sum to exactly 1.0 so that
+        // flat areas stay flat.
+        qint32 total = 0;
+        int biggest = 0;
+        for (int k = 0; k < n; k++)
+        {
+            out [k] = qRound (w [k] / sum * WeightOne);
+            total += out [k];
+
+            if (out [k] > out [biggest]) {
+                biggest = k;
+            }
+        }
+        out [biggest] += WeightOne - total;
+
+        // Trim zero weights off both ends.
+        int lo = 0, hi = n;
+        while (hi - lo > 1 && out [lo] == 0) {
+            lo++;
+        }
+        while (hi - lo > 1 && out [hi - 1] == 0) {
+            hi--;
+        }
+        if (lo > 0)
+        {
+            std::memmove (out, out + lo, (hi - lo) * sizeof (qint32));
+            std::memset (out + (hi - lo), 0, lo * sizeof (qint32));
+        }
+
+        c.first [i] = left + lo;
+        c.count [i] = hi - lo;
+    }
+
+    return c;
+}
+
+//---------------------------------------------------------------------
+
+inline int ClampChannel (qint32 sum, int max)
+{
+    const int val = (sum + WeightOne / 2) >> WeightBits;
+    return (val < 0) ? 0 : (val > max ? max : val);
+}
+
+// Packs channel sums into a premultiplied pixel.  Negative filter lobes can
+// push a color channel above alpha, which is invalid when premultiplied.
+inline QRgb PackPremultiplied (qint32 a, qint32 r, qint32 g, qint32 b)
+{
+    const int alpha = ::ClampChannel (a, 255);
+    return qRgba (::ClampChannel (r, alpha),
+                  ::ClampChannel (g, alpha),
+                  ::ClampChannel (b, alpha),
+                  alpha);
+}
+
+//---------------------------------------------------------------------
+
+QImage HorizontalPass (const QImage &src, int dstWidth,
+                       kpTransformResample::Filter filter)
+{
+    KP_TRACE_SCOPE ("imagelib", "kpTransformResample HorizontalPass");
+
+    const Contributions c = ::ComputeContributions (src.width (), dstWidth, filter);
+
+    QImage dst (dstWidth, src.height (), src.format ());
+    if (dst.isNull ()) {
+        return {};
+    }
+
+    const uchar * const srcBits = src.constBits ();
+    const int srcBytesPerLine = src.bytesPerLine ();
+    uchar * const dstBits = dst.bits ();
+    const int dstBytesPerLine = dst.bytesPerLine ();
+
+    const int readsPerRow = qMax (1, dstWidth * c.maxCount);
+
+    kpParallel::forBands (src.height (), MinReadsPerBand / readsPerRow,
+        [&] (int begin, int end)
+    {
+        for (int y = begin; y < end; y++)
+        {
+            const auto *srcLine = reinterpret_cast <const QRgb *> (
+                srcBits + qint64 (y) * srcBytesPerLine);
+            auto *dstLine = reinterpret_cast <QRgb *> (
+                dstBits + qint64 (y) * dstBytesPerLine);
+
+            for (int x = 0; x < dstWidth; x++)
+            {
+                const QRgb *s = srcLine + c.first [x];
+                const qint32 *w = c.weights.constData () + x * c.maxCount;
+                const int n = c.count [x];
+
+                qint32 a = 0, r = 0, g = 0, b = 0;
+                for (int k = 0; k < n; k++)
+                {
+                    const QRgb pixel = s [k];
+                    const qint32 weight = w [k];
+
+                    a += qAlpha (pixel) * weight;
+                    r += qRed (pixel) * weight;
+                    g += qGreen (pixel) * weight;
+                    b += qBlue (pixel) * weight;
+                }
+
+                dstLine [x] = ::PackPremultiplied (a, r, g, b);
+            }
+        }
+    });
+
+    return dst;
+}
+
+//---------------------------------------------------------------------
+
+QImage VerticalPass (const QImage &src, int dstHeight,
+                     kpTransformResample::Filter filter)
+{
+    KP_TRACE_SCOPE ("imagelib", "kpTransformResample VerticalPass");
+
+    const Contributions c = ::ComputeContributions (src.height (), dstHeight, filter);
+
+    const int width = src.width ();
+
+    QImage dst (width, dstHeight, src.format ());
+    if (dst.isNull ()) {
+        return {};
+    }
+
+    const uchar * const srcBits = src.constBits ();
+    const int srcBytesPerLine = src.bytesPerLine ();
+    uchar * const dstBits = dst.bits ();
+    const int dstBytesPerLine = dst.bytesPerLine ();
+
+    const int readsPerRow = qMax (1, width * c.maxCount);
+
+    kpParallel::forBands (dstHeight, MinReadsPerBand / readsPerRow,
+        [&] (int begin, int end)
+    {
+        // Accumulate whole source rows at a time: contiguous reads and a
+        // simple inner loop that the compiler can vectorize.
+        QVector <qint32> sums (width * 4);
+
+        for (int y = begin; y < end; y++)
+        {
+            sums.fill (0);
+            qint32 * const acc = sums.data ();
+
+            const qint32 *w = c.weights.constData () + y * c.maxCount;
+            for (int k = 0; k < c.count [y]; k++)
+            {
+                const auto *srcLine = reinterpret_cast <const QRgb *> (
+                    srcBits + qint64 (c.first [y] + k) * srcBytesPerLine);
+                const qint32 weight = w [k];
+
+                for (int x = 0; x < width; x++)
+                {
+                    const QRgb pixel = srcLine [x];
+
+                    acc [x * 4 + 0] += qAlpha (pixel) * weight;
+                    acc [x * 4 + 1] += qRed (pixel) * weight;
+                    acc [x * 4 + 2] += qGreen (pixel) * weight;
+                    acc [x * 4 + 3] += qBlue (pixel) * weight;
+                }
+            }
+
+            auto *dstLine = reinterpret_cast <QRgb *> (
+                dstBits + qint64 (y) * dstBytesPerLine);
+            for (int x = 0; x < width; x++)
+            {
+                dstLine [x] = ::PackPremultiplied (acc [x * 4 + 0],
+                    acc [x * 4 + 1], acc [x * 4 + 2], acc [x * 4 + 3]);
+            }
+        }
+    });
+
+    return dst;
+}
+
+}  // namespace
+
+//---------------------------------------------------------------------
+
+// public static
+kpImage kpTransformResample::scale (const kpImage &image, int width, int height,
+                                    Filter filter)
+{
+#if DEBUG_KP_TRANSFORM_RESAMPLE
+    qCDebug(kpLogImagelib) << "kpTransformResample::scale(" << image.size ()
+                           << "->" << width << "x" << height
+                           << ",filter=" << filter << ")";
+#endif
+
+    if (image.isNull () || width <= 0 || height <= 0) {
+        return {};
+    }
+
+    KP_TRACE_SCOPE ("imagelib", "kpTransformResample::scale");
+
+    // (RGB32 is kept as is, so that opaque images stay without an alpha channel)
+    QImage ret = image.convertToFormat (image.hasAlphaChannel () ?
+        QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+
+    const bool scaleHorizontally = (width != ret.width ());
+    const bool scaleVertically = (height != ret.height ());
+
+    // Do whichever pass leaves the smaller intermediate image first.
+    const bool horizontalFirst =
+        (qint64 (width) * ret.height () <= qint64 (ret.width ()) * height);
+
+    if (scaleHorizontally && horizontalFirst) {
+        ret = ::HorizontalPass (ret, width, filter);
+    }
+
+    if (scaleVertically && !ret.isNull ()) {
+        ret = ::VerticalPass (ret, height, filter);
+    }
+
+    if (scaleHorizontally && !horizontalFirst && !ret.isNull ()) {
+        ret = ::HorizontalPass (ret, width, filter);
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+kpTransformResample::Filter kpTransformResample::smoothScaleFilter (
+        const QSize &fromSize, const QSize &toSize)
+{
+    // Shrinking by half or more: area averaging is as good as anything and
+    // much cheaper than a cubic widened to cover that many source pixels.
+    if (toSize.width () * 2 <= fromSize.width () &&
+        toSize.height () * 2 <= fromSize.height ())
+    {
+        return kpTransformResample::Box;
+    }
+
+    return kpTransformResample::Bicubic;
+}
+
+//---------------------------------------------------------------------
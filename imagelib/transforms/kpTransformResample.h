@@ -0,0 +1,81 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpTransformResample_H
+#define kpTransformResample_H
+
+
+#include "imagelib/kpImage.h"
+
+
+class QSize;
+
+
+//
+// High quality, multi-threaded image scaling.
+//
+// Scaling is done as 2 separable passes (horizontal then vertical, or the
+// other way around, whichever is cheaper) over premultiplied ARGB32 with
+// filter weights precomputed in fixed point, once per destination row and
+// column.  Each pass is split into row bands across threads (kpParallel).
+//
+// When downscaling, the filter is widened by the scale factor so that every
+// source pixel contributes (i.e. area averaging for Box).
+//
+class kpTransformResample
+{
+public:
+    enum Filter
+    {
+        // Area average.  Cheapest; no ringing but blurry when upscaling.
+        Box,
+        // Linear interpolation (triangle filter).
+        Bilinear,
+        // Catmull-Rom cubic.  Sharper than Bilinear, slight ringing.
+        Bicubic,
+        // 3-lobed Lanczos.  Sharpest; most expensive.
+        Lanczos3
+    };
+
+    // Returns <image> scaled to <width>x<height> using <filter>.
+    //
+    // The result is in QImage::Format_ARGB32_Premultiplied if <image> has
+    // an alpha channel, else in QImage::Format_RGB32.
+    static kpImage scale (const kpImage &image, int width, int height,
+                          Filter filter);
+
+    // Returns the filter that kpPixmapFX::scale() uses for a smooth scale
+    // from <fromSize> to <toSize>.
+    //
+    // The user can't pick a filter: the Resize / Scale dialog only offers
+    // "Scale" and "Smooth Scale", so the latter always uses this.
+    static Filter smoothScaleFilter (const QSize &fromSize, const QSize &toSize);
+};
+
+
+#endif  // kpTransformResample_H
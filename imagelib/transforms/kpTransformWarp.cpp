@@ -0,0 +1,146 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_TRANSFORM_WARP 0
+
+
+#include "imagelib/transforms/kpTransformWarp.h"
+
+#include <QRect>
+#include <QRectF>
+#include <QTransform>
+
+#include "kpLogCategories.h"
+
+#include "generic/kpParallel.h"
+#include "generic/kpTrace.h"
+
+//---------------------------------------------------------------------
+
+static const int TileSize = 64;
+
+//---------------------------------------------------------------------
+
+// public static
+void kpTransformWarp::warp (kpImage *dest, const kpImage &src,
+                            const QTransform &matrix)
+{
+#if DEBUG_KP_TRANSFORM_WARP
+    qCDebug(kpLogImagelib) << "kpTransformWarp::warp(dest.size=" << dest->size ()
+                           << ",src.size=" << src.size ()
+                           << ",matrix=" << matrix << ")";
+#endif
+
+    Q_ASSERT (dest);
+    Q_ASSERT (dest->format () == QImage::Format_ARGB32_Premultiplied);
+
+    if (src.isNull () || dest->isNull ()) {
+        return;
+    }
+
+    bool invertible = false;
+    const QTransform inverse = matrix.inverted (&invertible);
+    if (!invertible) {
+        return;
+    }
+
+    KP_TRACE_SCOPE ("imagelib", "kpTransformWarp::warp");
+
+    const QImage source = src.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+    const int srcWidth = source.width (), srcHeight = source.height ();
+    const uchar * const srcBits = source.constBits ();
+    const int srcBytesPerLine = source.bytesPerLine ();
+    const QRectF srcRectF (source.rect ());
+
+    uchar * const destBits = dest->bits ();
+    const int destBytesPerLine = dest->bytesPerLine ();
+
+    // Only the part of <dest> that <src> maps onto can change.
+    const QRect coverRect =
+        matrix.mapRect (srcRectF).toAlignedRect ().intersected (dest->rect ());
+    if (coverRect.isEmpty ()) {
+        return;
+    }
+
+    const bool isAffine = matrix.isAffine ();
+
+    const int tilesAcross = (coverRect.width () + TileSize - 1) / TileSize;
+    const int tilesDown = (coverRect.height () + TileSize - 1) / TileSize;
+
+    kpParallel::forBands (tilesAcross * tilesDown, 4/*tiles*/,
+        [&] (int begin, int end)
+    {
+        for (int t = begin; t < end; t++)
+        {
+            const QRect tile = QRect (
+                coverRect.x () + (t % tilesAcross) * TileSize,
+                coverRect.y () + (t / tilesAcross) * TileSize,
+                TileSize, TileSize).intersected (coverRect);
+
+            // e.g. the corners of a rotated image.
+            if (!inverse.mapRect (QRectF (tile)).intersects (srcRectF)) {
+                continue;
+            }
+
+            for (int y = tile.top (); y <= tile.bottom (); y++)
+            {
+                auto *destLine = reinterpret_cast <QRgb *> (
+                    destBits + qint64 (y) * destBytesPerLine);
+
+                // Map the centre of the first pixel in this tile row and step
+                // along the row -- for an affine transform, that is exact up
+                // to floating point error, which restarting every tile row
+                // keeps from accumulating.
+                const double cx = tile.left () + 0.5, cy = y + 0.5;
+                double sx = inverse.m11 () * cx + inverse.m21 () * cy + inverse.dx ();
+                double sy = inverse.m12 () * cx + inverse.m22 () * cy + inverse.dy ();
+
+                for (int x = tile.left (); x <= tile.right ();
+                     x++, sx += inverse.m11 (), sy += inverse.m12 ())
+                {
+                    if (!isAffine)
+                    {
+                        const QPointF srcPoint = inverse.map (QPointF (x + 0.5, cy));
+                        sx = srcPoint.x ();
+                        sy = srcPoint.y ();
+                    }
+
+                    // (the comparisons also reject NaN)
+                    if (!(sx >= 0 && sx < srcWidth && sy >= 0 && sy < srcHeight)) {
+                        continue;
+                    }
+
+                    destLine [x] = reinterpret_cast <const QRgb *> (
+                        srcBits + qint64 (sy) * srcBytesPerLine) [int (sx)];
+                }
+            }
+        }
+    });
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,67 @@
+
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpTransformWarp_H
+#define kpTransformWarp_H
+
+
+#include "imagelib/kpImage.h"
+
+
+class QTransform;
+
+
+//
+// Tiled, multi-threaded affine image warping, for rotate and skew.
+//
+// For every destination pixel, the centre is mapped back through the
+// inverse of the transform and the source is sampled there.  This gives
+// the same geometry as QPainter::drawImage() with that world transform
+// and without QPainter::SmoothPixmapTransform.  The nearest source pixel
+// is used, preserving RGB values -- what the user wants for the document
+// (see the comments in kpPixmapFX_Transforms.cpp).
+//
+// The destination is split into square tiles that are processed in
+// parallel (kpParallel).  Tiles that map entirely outside of the source
+// are skipped.
+//
+class kpTransformWarp
+{
+public:
+    // Draws <src> transformed by <matrix> onto <*dest>, replacing (not
+    // blending with) the destination pixels that <src> covers.  Pixels
+    // not covered are left alone, so fill <*dest> with the background
+    // color beforehand.
+    //
+    // <*dest> must be in QImage::Format_ARGB32_Premultiplied.
+    static void warp (kpImage *dest, const kpImage &src,
+                      const QTransform &matrix);
+};
+
+
+#endif  // kpTransformWarp_H
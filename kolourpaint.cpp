@@ -29,7 +29,11 @@
 #include <KAboutData>
 
 #include "kpVersion.h"
+#include "document/kpDocumentJournal.h"
+#include "generic/kpStartupProfile.h"
+#include "generic/kpTrace.h"
 #include "mainWindow/kpMainWindow.h"
+#include "tools/kpToolInputRecorder.h"
 #include <kolourpaintlicense.h>
 
 #include <QApplication>
@@ -37,12 +41,20 @@
 #include <QImageReader>
 #include <QDir>
 #include <KLocalizedString>
+#include <KMessageBox>
 
 int main(int argc, char *argv [])
 {
+  kpStartupProfile::start();
+
   QApplication app(argc, argv);
   QApplication::setAttribute(Qt::AA_UseHighDpiPixmaps);
 
+  // honor KOLOURPAINT_TRACE (see generic/kpTrace.h)
+  kpTrace::initialize();
+
+  kpStartupProfile::mark("application");
+
   KLocalizedString::setApplicationDomain("kolourpaint");
 
   KAboutData aboutData
@@ -91,9 +103,23 @@ int main(int argc, char *argv [])
 
   aboutData.setupCommandLine(&cmdLine);
   cmdLine.addOption(QCommandLineOption("mimetypes", i18n("List all readable image MIME types")));
+  cmdLine.addOption(QCommandLineOption("record-input",
+      i18n("Record the input to the tools, for replaying with --replay-input"),
+      QStringLiteral("file")));
+  cmdLine.addOption(QCommandLineOption("replay-input",
+      i18n("Replay recorded input against the image to open (or a new image) "
+           "without showing a window, print the time taken and exit"),
+      QStringLiteral("file")));
+  cmdLine.addOption(QCommandLineOption("startup-profile",
+      i18n("Print how long each phase of startup took, up to the first paint of the image")));
   cmdLine.process(app);
   aboutData.processCommandLine(&cmdLine);
 
+  if ( cmdLine.isSet("startup-profile") )
+    kpStartupProfile::enable();
+
+  kpStartupProfile::mark("command line");
+
   // produce a list of MimeTypes which kolourpaint can handle (can be used inside the .desktop file)
   if ( cmdLine.isSet("mimetypes") )
   {
@@ -108,6 +134,22 @@ int main(int argc, char *argv [])
     return 0;
   }
 
+  if ( cmdLine.isSet("replay-input") )
+  {
+    const QStringList args = cmdLine.positionalArguments();
+
+    kpMainWindow *mainWindow = args.isEmpty() ?
+        new kpMainWindow() :
+        new kpMainWindow(QUrl::fromUserInput(args[0], QDir::currentPath(), QUrl::AssumeLocalFile));
+    const bool replayed = mainWindow->replayToolInput(cmdLine.value("replay-input"));
+    delete mainWindow;
+
+    return replayed ? 0 : 1;
+  }
+
+  if ( cmdLine.isSet("record-input") )
+    kpToolInputRecorder::start(cmdLine.value("record-input"));
+
   if ( app.isSessionRestored() )
   {
     // Creates a kpMainWindow using the default constructor and then
@@ -119,18 +161,62 @@ int main(int argc, char *argv [])
     kpMainWindow *mainWindow;
     QStringList args = cmdLine.positionalArguments();
 
+    // Offer to recover the unsaved changes of KolourPaint instances
+    // that crashed (see document/kpDocumentJournal.h).
+    //
+    // Not when opening files from the command line (e.g. from a file
+    // manager), where the user wants those files, not a prompt about
+    // others.  The journals are kept for the next plain start instead.
+    bool recoveredDocument = false;
+    const QStringList journals = args.isEmpty() ?
+        kpDocumentJournal::orphanedJournals() : QStringList();
+    if ( !journals.isEmpty() )
+    {
+      const int result = KMessageBox::questionYesNo(nullptr,
+          i18np("KolourPaint did not close properly. "
+                "Do you want to recover the unsaved changes to an image?",
+                "KolourPaint did not close properly. "
+                "Do you want to recover the unsaved changes to %1 images?",
+                journals.count()),
+          i18nc("@title:window", "Recover Unsaved Changes"),
+          KGuiItem(i18n("&Recover")),
+          KStandardGuiItem::discard());
+
+      foreach (const QString &journal, journals)
+      {
+        if ( result == KMessageBox::Yes )
+        {
+          mainWindow = new kpMainWindow();
+          if ( mainWindow->recoverDocument(journal) )
+          {
+            mainWindow->show();
+            recoveredDocument = true;
+            continue;
+          }
+
+          delete mainWindow;
+        }
+
+        kpDocumentJournal::discard(journal);
+      }
+    }
+
+    kpStartupProfile::mark("crash recovery check");
+
     if ( args.count() >= 1 )
     {
       for (int i = 0; i < args.count(); i++)
       {
         mainWindow = new kpMainWindow(QUrl::fromUserInput(args[i], QDir::currentPath(), QUrl::AssumeLocalFile));
         mainWindow->show();
+        kpStartupProfile::mark("show window");
       }
     }
-    else
+    else if ( !recoveredDocument )
     {
       mainWindow = new kpMainWindow();
       mainWindow->show();
+      kpStartupProfile::mark("show window");
     }
   }
 
@@ -383,6 +383,14 @@ kpViewScrollableContainer::kpViewScrollableContainer(QWidget *parent)
     // the base widget holding the documents view plus the resize grips
     setWidget(new QWidget(viewport()));
 
+    // Let Qt know that the base widget is fully opaque.  Otherwise, moving
+    // it on every scroll step invalidates all of it and the kpView has to
+    // render the whole visible area again, rescaling document pixels that
+    // were already on the screen.  Now, Qt blits the already-rendered
+    // contents inside its backing store and only asks us to paint the
+    // newly exposed strips.
+    widget()->setAutoFillBackground(true);
+
     m_bottomGrip = new kpGrip(kpGrip::Bottom, widget());
     m_rightGrip = new kpGrip(kpGrip::Right, widget());
     m_bottomRightGrip = new kpGrip(kpGrip::BottomRight, widget());
@@ -1150,7 +1158,9 @@ bool kpViewScrollableContainer::slotDragScroll (bool *didSomething)
                              viewport()->width(), viewport()->height());
 
             // Repaint newly exposed region immediately to reduce tearing
-            // of scrollView.
+            // of scrollView.  The rest of the view was just shifted by
+            // Qt's backing store (see the constructor), so this is all
+            // that gets rendered for this scroll step.
             m_view->repaint (region);
         }
     }
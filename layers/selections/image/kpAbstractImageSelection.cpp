@@ -269,7 +269,7 @@ QBitmap kpAbstractImageSelection::shapeBitmap (bool nullForRectangular) const
 
 //---------------------------------------------------------------------
 
-// public
+// public virtual
 kpImage kpAbstractImageSelection::givenImageMaskedByShape (const kpImage &image) const
 {
 #if DEBUG_KP_SELECTION
@@ -190,7 +190,9 @@ public:
     // Very slow.
     //
     // ASSUMPTION: The image has the same dimensions as the selection.
-    kpImage givenImageMaskedByShape (const kpImage &image) const;
+    //
+    // You should override this if you can implement it more efficiently.
+    virtual kpImage givenImageMaskedByShape (const kpImage &image) const;
 
 
 //
@@ -35,6 +35,21 @@
 
 #include "imagelib/kpPainter.h"
 
+#include <algorithm>
+
+#include <QBitmap>
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QVector>
+
+
+// A run of pixels, on a single row of the span mask, that is inside the
+// selection's shape.  <left> and <right> are inclusive.
+struct kpFreeFormImageSelectionSpan
+{
+    int left, right;
+};
 
 struct kpFreeFormImageSelectionPrivate
 {
@@ -63,6 +78,21 @@ struct kpFreeFormImageSelectionPrivate
     // These interpolated points are stored in <cardPointsCache>.  Regarding
     // <cardPointsLoopCache>, see the APIDoc for cardinallyAdjacentPointsLoop().
     QPolygon cardPointsCache, cardPointsLoopCache;
+
+    // The shape is drawn from <cardPointsLoopCache>, which is too slow to do
+    // on every mouse move over the selection (by contains()).  So we draw it
+    // once per shape and keep it as rows of sorted pixel runs, relative to
+    // <spanMaskOrigin> so that moveBy() only needs to move the origin.
+    //
+    // The runs for row "y" are <spanMaskSpans>[<spanMaskRowStart>[y]] up to,
+    // but not including, <spanMaskSpans>[<spanMaskRowStart>[y + 1]].
+    //
+    // <spanMaskRegion> is the same shape as a QRegion, for shapeRegion().
+    mutable bool spanMaskValid{false};
+    mutable QPoint spanMaskOrigin;
+    mutable QVector <int> spanMaskRowStart;
+    mutable QVector <kpFreeFormImageSelectionSpan> spanMaskSpans;
+    mutable QRegion spanMaskRegion;
 };
 
 
@@ -107,6 +137,12 @@ kpFreeFormImageSelection &kpFreeFormImageSelection::operator= (const kpFreeFormI
     d->cardPointsCache = rhs.d->cardPointsCache;
     d->cardPointsLoopCache = rhs.d->cardPointsLoopCache;
 
+    d->spanMaskValid = rhs.d->spanMaskValid;
+    d->spanMaskOrigin = rhs.d->spanMaskOrigin;
+    d->spanMaskRowStart = rhs.d->spanMaskRowStart;
+    d->spanMaskSpans = rhs.d->spanMaskSpans;
+    d->spanMaskRegion = rhs.d->spanMaskRegion;
+
     return *this;
 }
 
@@ -158,7 +194,9 @@ kpCommandSize::SizeType kpFreeFormImageSelection::size () const
     return kpAbstractImageSelection::size () +
         (kpCommandSize::PolygonSize (d->orgPoints) +
          kpCommandSize::PolygonSize (d->cardPointsCache) +
-         kpCommandSize::PolygonSize (d->cardPointsLoopCache));
+         kpCommandSize::PolygonSize (d->cardPointsLoopCache) +
+         d->spanMaskRowStart.size () * sizeof (int) +
+         d->spanMaskSpans.size () * sizeof (kpFreeFormImageSelectionSpan));
 }
 
 // public virtual [kpAbstractSelection]
@@ -246,6 +284,8 @@ void kpFreeFormImageSelection::recalculateCardinallyAdjacentPoints ()
     //      "pointLoop", since the previous points are definitely cardinally
     //      adjacent.
     d->cardPointsLoopCache = ::RecalculateCardinallyAdjacentPoints (pointsLoop);
+
+    d->spanMaskValid = false;
 }
 
 // public
@@ -268,38 +308,209 @@ QPolygon kpFreeFormImageSelection::calculatePoints () const
 }
 
 
+// Returns bit <x> of a QImage::Format_MonoLSB <line>.
+static uint MonoLSBBit (const uchar *line, int x)
+{
+    return (line [x >> 3] >> (x & 7)) & 1;
+}
+
+// private
+void kpFreeFormImageSelection::recalculateSpanMaskCache () const
+{
+    const QRect rect = d->cardPointsLoopCache.boundingRect ();
+    const int rows = rect.isEmpty () ? 0 : rect.height ();
+
+#if DEBUG_KP_SELECTION
+    qCDebug(kpLogLayers) << "kpFreeFormImageSelection::recalculateSpanMaskCache()"
+              << " rect=" << rect;
+#endif
+
+    // Draw the shape exactly like kpAbstractImageSelection::shapeBitmap(),
+    // so that contains() and shapeRegion() agree with the pixels that are
+    // actually selected.
+    QImage maskImage;
+    if (rows > 0)
+    {
+        QBitmap maskBitmap (rect.width (), rect.height ());
+        maskBitmap.fill (Qt::color0/*transparent*/);
+        {
+            QPainter painter (&maskBitmap);
+
+            painter.setPen (Qt::color1/*opaque*/);
+            painter.setBrush (Qt::color1/*opaque*/);
+
+            // (see kpAbstractImageSelection::shapeBitmap() regarding the pen)
+            painter.drawPolygon (d->cardPointsLoopCache.translated (-rect.topLeft ()),
+                Qt::OddEvenFill);
+        }
+
+        maskImage = maskBitmap.toImage ().convertToFormat (QImage::Format_MonoLSB);
+    }
+    const uint opaqueIndex =
+        (maskImage.colorCount () > 1 &&
+         maskImage.color (1) == QColor (Qt::color1).rgb ()) ? 1 : 0;
+
+    // Store the runs of opaque pixels, row by row, sorted by x.
+    d->spanMaskOrigin = rect.topLeft ();
+    d->spanMaskRowStart.fill (0, rows + 1);
+    d->spanMaskSpans.clear ();
+
+    QVector <QRect> regionRects;
+    for (int y = 0; y < rows; y++)
+    {
+        const uchar *line = maskImage.constScanLine (y);
+        int x = 0;
+        while (x < rect.width ())
+        {
+            while (x < rect.width () && ::MonoLSBBit (line, x) != opaqueIndex) {
+                x++;
+            }
+            if (x == rect.width ()) {
+                break;
+            }
+
+            const int left = x;
+            while (x < rect.width () && ::MonoLSBBit (line, x) == opaqueIndex) {
+                x++;
+            }
+
+            d->spanMaskSpans.append ({left, x - 1});
+            regionRects.append (QRect (left, y, x - left, 1));
+        }
+
+        d->spanMaskRowStart [y + 1] = d->spanMaskSpans.size ();
+    }
+
+    // (the runs are sorted and never touch, as QRegion::setRects() requires)
+    d->spanMaskRegion = QRegion ();
+    d->spanMaskRegion.setRects (regionRects.constData (), regionRects.size ());
+
+    d->spanMaskValid = true;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpFreeFormImageSelection::spanMaskRow (int y,
+        const kpFreeFormImageSelectionSpan **begin,
+        const kpFreeFormImageSelectionSpan **end) const
+{
+    if (!d->spanMaskValid) {
+        recalculateSpanMaskCache ();
+    }
+
+    const int row = y - d->spanMaskOrigin.y ();
+    if (row < 0 || row >= d->spanMaskRowStart.size () - 1)
+    {
+        *begin = *end = nullptr;
+        return;
+    }
+
+    const kpFreeFormImageSelectionSpan *spans = d->spanMaskSpans.constData ();
+    *begin = spans + d->spanMaskRowStart [row];
+    *end = spans + d->spanMaskRowStart [row + 1];
+}
+
+//---------------------------------------------------------------------
+
 // protected virtual [kpAbstractSelection]
 QRegion kpFreeFormImageSelection::shapeRegion () const
 {
-    const QRegion region = QRegion (d->cardPointsLoopCache, Qt::OddEvenFill);
+    if (!d->spanMaskValid) {
+        recalculateSpanMaskCache ();
+    }
 
-    // In Qt4, while QPainter::drawRect() gives you rectangles 1 pixel
-    // wider and higher, QRegion(QPolygon) gives you regions 1 pixel
-    // narrower and shorter!  Compensate for this by merging shifted
-    // versions of the region.  This seems to be consistent with shapeBitmap()
-    // but I am a bit worried.
-    //
-    // Regarding alternative solutions:
-    // 1. Instead of doing this region shifting and merging, if we were to
-    //    construct a QRegion simply from a point array with 4 points for
-    //    every point in "d->cardPointsLoopCache" (4 points = original point + 3
-    //    translations below), it probably wouldn't work because the order of
-    //    the points in any point array matter for the odd-even fill
-    //    algorithm.  This would probably manifest as problems with
-    //    self-intersecting borders.
-    // 2. Constructing a QRegion from QBitmap (from shapeBitmap()) is probably
-    //    very slow since it would have to read each pixel of the QBitmap.
-    //    Having said that, this is probably the safest option as region shifting
-    //    is dodgy.  Also, this would guarantee that shapeBitmap() and shapeRegion()
-    //    are consistent and we wouldn't need cardinally adjacent points either
-    //    (d->cardPointsCache and d->cardPointsLoopCache).
-    const QRegion regionX = region.translated (1, 0);
-    const QRegion regionY = region.translated (0, 1);
-    const QRegion regionXY = region.translated (1, 1);
-
-    return region.united (regionX).united (regionY).united (regionXY);
+    return d->spanMaskRegion.translated (d->spanMaskOrigin);
+}
+
+//---------------------------------------------------------------------
+
+// Sets bits <left> to <right> inclusive, of a QImage::Format_MonoLSB <line>.
+static void SetMonoLSBBits (uchar *line, int left, int right)
+{
+    for (; left <= right && (left & 7); left++) {
+        line [left >> 3] |= (1 << (left & 7));
+    }
+
+    for (; left + 7 <= right; left += 8) {
+        line [left >> 3] = 0xFF;
+    }
+
+    for (; left <= right; left++) {
+        line [left >> 3] |= (1 << (left & 7));
+    }
 }
 
+// public virtual [base kpAbstractImageSelection]
+QBitmap kpFreeFormImageSelection::shapeBitmap (bool nullForRectangular) const
+{
+    (void) nullForRectangular;
+
+    Q_ASSERT (boundingRect ().isValid ());
+
+    QImage maskImage (width (), height (), QImage::Format_MonoLSB);
+    // See QBitmap::fromImage().
+    maskImage.setColor (0, QColor (Qt::white).rgb ()/*Qt::color0*/);
+    maskImage.setColor (1, QColor (Qt::black).rgb ()/*Qt::color1*/);
+    maskImage.fill (0);
+
+    for (int y = 0; y < maskImage.height (); y++)
+    {
+        const kpFreeFormImageSelectionSpan *span, *spanEnd;
+        spanMaskRow (this->y () + y, &span, &spanEnd);
+
+        uchar *line = maskImage.scanLine (y);
+        const int dx = d->spanMaskOrigin.x () - x ();
+        for (; span != spanEnd; span++)
+        {
+            const int left = qMax (0, span->left + dx);
+            const int right = qMin (maskImage.width () - 1, span->right + dx);
+            ::SetMonoLSBBits (line, left, right);
+        }
+    }
+
+    return QBitmap::fromImage (maskImage);
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [base kpAbstractImageSelection]
+kpImage kpFreeFormImageSelection::givenImageMaskedByShape (const kpImage &image) const
+{
+    Q_ASSERT (image.width () == width () && image.height () == height ());
+
+    kpImage retImage = image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+
+    for (int y = 0; y < retImage.height (); y++)
+    {
+        const kpFreeFormImageSelectionSpan *span, *spanEnd;
+        spanMaskRow (this->y () + y, &span, &spanEnd);
+
+        auto *line = reinterpret_cast <QRgb *> (retImage.scanLine (y));
+        const int dx = d->spanMaskOrigin.x () - x ();
+
+        // Clear everything between the runs.
+        int clearFrom = 0;
+        for (; span != spanEnd; span++)
+        {
+            const int left = qMax (0, span->left + dx);
+            const int right = qMin (retImage.width () - 1, span->right + dx);
+            if (left > right) {
+                continue;
+            }
+
+            std::fill (line + clearFrom, line + left, QRgb (0)/*transparent*/);
+            clearFrom = right + 1;
+        }
+
+        std::fill (line + clearFrom, line + retImage.width (), QRgb (0)/*transparent*/);
+    }
+
+    return retImage;
+}
+
+//---------------------------------------------------------------------
+
 
 // public virtual [kpAbstractSelection]
 bool kpFreeFormImageSelection::contains (const QPoint &point) const
@@ -311,7 +522,18 @@ bool kpFreeFormImageSelection::contains (const QPoint &point) const
     // We can't use the baseImage() (when non-null) and get the transparency of
     // the pixel at <point>, instead of this region test, as the pixel may be
     // transparent but still within the border.
-    return shapeRegion ().contains (point);
+    const kpFreeFormImageSelectionSpan *begin, *end;
+    spanMaskRow (point.y (), &begin, &end);
+
+    // Find the last run starting at or before <point>.
+    const int x = point.x () - d->spanMaskOrigin.x ();
+    const kpFreeFormImageSelectionSpan *span = std::upper_bound (begin, end, x,
+        [] (int value, const kpFreeFormImageSelectionSpan &s)
+        {
+            return value < s.left;
+        });
+
+    return (span != begin && x <= (span - 1)->right);
 }
 
 
@@ -323,6 +545,9 @@ void kpFreeFormImageSelection::moveBy (int dx, int dy)
     d->cardPointsCache.translate (dx, dy);
     d->cardPointsLoopCache.translate (dx, dy);
 
+    // The span mask is relative to its origin so this is all it needs.
+    d->spanMaskOrigin += QPoint (dx, dy);
+
     // Call base last since it fires the changed() signal and we only
     // want that to fire at the very end of this method, after all
     // the selection state has been changed.
@@ -368,6 +593,8 @@ void kpFreeFormImageSelection::flip (bool horiz, bool vert)
     ::FlipPoints (&d->cardPointsCache, horiz, vert, boundingRect ());
     ::FlipPoints (&d->cardPointsLoopCache, horiz, vert, boundingRect ());
 
+    d->spanMaskValid = false;
+
 
     // Call base last since it fires the changed() signal and we only
     // want that to fire at the very end of this method, after all
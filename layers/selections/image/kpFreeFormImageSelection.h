@@ -121,8 +121,32 @@ public:
 //
 
 public:
+    // Generated directly from the span mask cache, which is consistent with
+    // shapeRegion().
+    QBitmap shapeBitmap (bool nullForRectangular = false) const override;
+
+    // Cached.  Fast after the first call for a given shape.
     QRegion shapeRegion () const override;
 
+    // Masks <image> one run of pixels at a time using the span mask cache,
+    // instead of painting with a clip region.
+    kpImage givenImageMaskedByShape (const kpImage &image) const override;
+
+private:
+    // Draws the shape, from cardinallyAdjacentPointsLoop(), and stores it
+    // as rows of runs of pixels.
+    //
+    // Called lazily since the cardinally adjacent points can be
+    // recalculated many times while the user is still drawing the shape.
+    void recalculateSpanMaskCache () const;
+
+    // Sets <*begin> and <*end> to the runs of pixels of the span mask, for
+    // document row <y>.  The x-coordinates of the runs are relative to the
+    // x-coordinate of the span mask origin.
+    void spanMaskRow (int y,
+        const struct kpFreeFormImageSelectionSpan **begin,
+        const struct kpFreeFormImageSelectionSpan **end) const;
+
 
 //
 // Point Testing
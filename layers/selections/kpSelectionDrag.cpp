@@ -31,8 +31,13 @@
 
 #include "kpSelectionDrag.h"
 
+#include <QBuffer>
 #include <QDataStream>
+#include <QEventLoop>
 #include <QImage>
+#include <QImageReader>
+#include <QImageWriter>
+#include <QThread>
 #include <QUrl>
 
 #include "kpLogCategories.h"
@@ -49,7 +54,16 @@ const char * const kpSelectionDrag::SelectionMimeType =
 
 //---------------------------------------------------------------------
 
+// The formats we offer, in order of preference.  The image ones are only
+// offered if the selection has an image.
+static const char * const ImageMimeType = "application/x-qt-image";
+static const char * const PNGMimeType = "image/png";
+static const char * const BMPMimeType = "image/bmp";
+
+//---------------------------------------------------------------------
+
 kpSelectionDrag::kpSelectionDrag (const kpAbstractImageSelection &sel)
+    : m_selection (sel.clone ())
 {
 #if DEBUG_KP_SELECTION_DRAG && 1
     qCDebug(kpLogLayers) << "kpSelectionDrag() w=" << sel.width ()
@@ -57,30 +71,192 @@ kpSelectionDrag::kpSelectionDrag (const kpAbstractImageSelection &sel)
 #endif
 
     Q_ASSERT (sel.hasContent ());
+    Q_ASSERT (m_selection);
+
+    // We used to serialize the selection and store it as a QImage
+    // (so that QMimeData::hasImage() works) here but that made copying a
+    // big selection slow, even if it was never pasted.  Now retrieveData()
+    // does it on demand.
+    if (m_selection->baseImage ().isNull ())
+    {
+        // TODO: proper error handling.
+        qCCritical(kpLogLayers) << "kpSelectionDrag::setSelection() could not convert to image";
+    }
+}
+
+//---------------------------------------------------------------------
+
+kpSelectionDrag::~kpSelectionDrag ()
+{
+    delete m_selection;
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [base QMimeData]
+QStringList kpSelectionDrag::formats () const
+{
+    QStringList ret;
+    ret << QLatin1String (kpSelectionDrag::SelectionMimeType);
+
+    if (!m_selection->baseImage ().isNull ())
+    {
+        ret << QLatin1String (::ImageMimeType)
+            << QLatin1String (::PNGMimeType)
+            << QLatin1String (::BMPMimeType);
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [base QMimeData]
+bool kpSelectionDrag::hasFormat (const QString &mimeType) const
+{
+    return formats ().contains (mimeType);
+}
+
+//---------------------------------------------------------------------
+
+// private
+QByteArray kpSelectionDrag::encodedData (const QString &mimeType) const
+{
+    auto it = m_encodedData.constFind (mimeType);
+    if (it != m_encodedData.constEnd ()) {
+        return *it;
+    }
+
+#if DEBUG_KP_SELECTION_DRAG
+    qCDebug(kpLogLayers) << "kpSelectionDrag::encodedData(" << mimeType << ") encoding";
+#endif
 
-    // Store as selection.
     QByteArray ba;
+    if (mimeType == QLatin1String (kpSelectionDrag::SelectionMimeType))
     {
         QDataStream stream (&ba, QIODevice::WriteOnly);
-        stream << sel;
+        stream << *m_selection;
+    }
+    else if (mimeType == QLatin1String (::PNGMimeType) ||
+             mimeType == QLatin1String (::BMPMimeType))
+    {
+        QBuffer buffer (&ba);
+        buffer.open (QIODevice::WriteOnly);
+
+        QImageWriter writer (&buffer,
+            mimeType == QLatin1String (::PNGMimeType) ? "PNG" : "BMP");
+        if (!writer.write (m_selection->baseImage ()))
+        {
+            qCCritical(kpLogLayers) << "kpSelectionDrag::encodedData() could not encode to"
+                                    << mimeType << ":" << writer.errorString ();
+            ba.clear ();
+        }
     }
-    setData (kpSelectionDrag::SelectionMimeType, ba);
 
-    // Store as image (so that QMimeData::hasImage()) works).
-    // OPT: an awful waste of memory storing image in both selection and QImage
-    const QImage image = sel.baseImage ();
-#if DEBUG_KP_SELECTION_DRAG && 1
-    qCDebug(kpLogLayers) << "\timage: w=" << image.width ()
-               << " h=" << image.height ();
+    m_encodedData.insert (mimeType, ba);
+    return ba;
+}
+
+//---------------------------------------------------------------------
+
+// protected virtual [base QMimeData]
+QVariant kpSelectionDrag::retrieveData (const QString &mimeType,
+        QVariant::Type type) const
+{
+#if DEBUG_KP_SELECTION_DRAG
+    qCDebug(kpLogLayers) << "kpSelectionDrag::retrieveData(" << mimeType
+               << "," << type << ")";
 #endif
-    if (image.isNull ())
+
+    if (!hasFormat (mimeType)) {
+        return QMimeData::retrieveData (mimeType, type);
+    }
+
+    // QMimeData::imageData() and the platform clipboard integration, which
+    // does its own conversions, want the image itself.
+    if (mimeType == QLatin1String (::ImageMimeType)) {
+        return m_selection->baseImage ();
+    }
+
+    return encodedData (mimeType);
+}
+
+//---------------------------------------------------------------------
+
+// Returns the encoded image formats offered by <mimeData> that we can read,
+// most preferred first.
+static QStringList ReadableImageMimeTypes (const QMimeData *mimeData)
+{
+    static QStringList readableMimeTypes;
+    if (readableMimeTypes.isEmpty ())
     {
-        // TODO: proper error handling.
-        qCCritical(kpLogLayers) << "kpSelectionDrag::setSelection() could not convert to image";
+        // Prefer lossless formats that are quick to decode.
+        readableMimeTypes << QLatin1String (::PNGMimeType)
+                          << QLatin1String (::BMPMimeType);
+
+        for (const auto &mimeType : QImageReader::supportedMimeTypes ())
+        {
+            const QString mimeTypeString = QString::fromLatin1 (mimeType);
+            if (!readableMimeTypes.contains (mimeTypeString)) {
+                readableMimeTypes << mimeTypeString;
+            }
+        }
     }
-    else {
-        setImageData (image);
+
+    QStringList ret;
+    const QStringList offeredMimeTypes = mimeData->formats ();
+    for (const auto &mimeType : readableMimeTypes)
+    {
+        if (offeredMimeTypes.contains (mimeType)) {
+            ret << mimeType;
+        }
     }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+// Returns whether <data> starts with the header of an image format we can
+// read.  This does not decode the image.
+static bool CanReadImageHeader (const QByteArray &data)
+{
+    QBuffer buffer;
+    buffer.setData (data);
+    buffer.open (QIODevice::ReadOnly);
+
+    QImageReader reader (&buffer);
+    return reader.canRead ();
+}
+
+//---------------------------------------------------------------------
+
+// Decodes <data> in a worker thread, keeping the UI painting (but not
+// accepting user input) in the meantime, as decoding a big image can take
+// a while.
+static QImage DecodeImageInWorkerThread (const QByteArray &data)
+{
+    QImage image;
+
+    QThread *thread = QThread::create ([&data, &image] ()
+    {
+        QBuffer buffer;
+        buffer.setData (data);
+        buffer.open (QIODevice::ReadOnly);
+
+        QImageReader reader (&buffer);
+        image = reader.read ();
+    });
+
+    QEventLoop eventLoop;
+    QObject::connect (thread, &QThread::finished, &eventLoop, &QEventLoop::quit);
+    thread->start ();
+    eventLoop.exec (QEventLoop::ExcludeUserInputEvents);
+
+    thread->wait ();
+    delete thread;
+
+    return image;
 }
 
 //---------------------------------------------------------------------
@@ -96,9 +272,19 @@ bool kpSelectionDrag::canDecode(const QMimeData *mimeData)
              << "hasImage=" << mimeData->hasImage();
 #endif
 
-    // mimeData->hasImage() would not check if the data is a valid image
-    return mimeData->hasFormat(kpSelectionDrag::SelectionMimeType) ||
-           !qvariant_cast<QImage>(mimeData->imageData()).isNull();
+    if (mimeData->hasFormat(kpSelectionDrag::SelectionMimeType)) {
+        return true;
+    }
+
+    // This is called whenever the clipboard changes so it must be cheap.
+    // Decoding e.g. a big screenshot that someone has just copied in another
+    // application, only to enable the Paste action, is not -- and neither
+    // is QMimeData::data(), which on X11 makes the other application encode
+    // and send us the whole image.  So only look at the offered formats.
+    //
+    // Some platforms only offer images as a QImage.
+    return !::ReadableImageMimeTypes(mimeData).isEmpty() ||
+           mimeData->hasImage();
 }
 
 //---------------------------------------------------------------------
@@ -127,7 +313,32 @@ kpAbstractImageSelection *kpSelectionDrag::decode(const QMimeData *mimeData)
     qCDebug(kpLogLayers) << "\tmimeSource doesn't provide selection - try image";
 #endif
 
-    QImage image = qvariant_cast <QImage> (mimeData->imageData ());
+    // Take everything that we might need from <mimeData> now: decoding runs
+    // an event loop, during which the clipboard or drag that owns
+    // <mimeData> may go away.
+    QByteArray encodedImage;
+    for (const auto &mimeType : ::ReadableImageMimeTypes (mimeData))
+    {
+        encodedImage = mimeData->data (mimeType);
+        if (::CanReadImageHeader (encodedImage)) {
+            break;
+        }
+
+        encodedImage.clear ();
+    }
+
+    QImage image;
+    if (encodedImage.isEmpty ()) {
+        image = qvariant_cast <QImage> (mimeData->imageData ());
+    }
+
+    const QList <QUrl> urls = mimeData->urls ();
+    mimeData = nullptr;
+
+    if (!encodedImage.isEmpty ()) {
+        image = ::DecodeImageInWorkerThread (encodedImage);
+    }
+
     if (!image.isNull ())
     {
 #if DEBUG_KP_SELECTION_DRAG
@@ -138,11 +349,9 @@ kpAbstractImageSelection *kpSelectionDrag::decode(const QMimeData *mimeData)
                     QRect (0, 0, image.width (), image.height ()), image);
     }
 
-    if ( mimeData->hasUrls() )  // no image, check for path to local image file
+    if ( !urls.isEmpty() )  // no image, check for path to local image file
     {
-        QList<QUrl> urls = mimeData->urls();
-
-        if ( urls.count() && urls[0].isLocalFile() )
+        if ( urls[0].isLocalFile() )
         {
             image.load(urls[0].toLocalFile());
 
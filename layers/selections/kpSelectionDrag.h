@@ -28,7 +28,9 @@
 #ifndef KP_SELECTION_DRAG_H
 #define KP_SELECTION_DRAG_H
 
+#include <QHash>
 #include <QMimeData>
+#include <QStringList>
 
 class kpAbstractImageSelection;
 
@@ -41,11 +43,42 @@ class kpSelectionDrag : public QMimeData
     static const char * const SelectionMimeType;
 
     // ASSUMPTION: <sel> has content (is not just a border).
+    //
+    // This is fast since it only takes a (copy-on-write) copy of <sel>.
+    // Each format is only encoded when something asks for it, and then
+    // only once.
     kpSelectionDrag(const kpAbstractImageSelection &sel);
+    ~kpSelectionDrag() override;
 
   public:
+    QStringList formats() const override;
+    bool hasFormat(const QString &mimeType) const override;
+
+  protected:
+    QVariant retrieveData(const QString &mimeType, QVariant::Type type) const override;
+
+  private:
+    // Returns <mimeType> encoded from m_selection, or an empty array if it
+    // can't be encoded to that type.
+    QByteArray encodedData(const QString &mimeType) const;
+
+  public:
+    // Returns whether decode() will probably succeed.  This is cheap: it
+    // only looks at the offered formats, without fetching or decoding any
+    // image.
     static bool canDecode(const QMimeData *mimeData);
+
+    // Encoded images are decoded in a worker thread, while the UI keeps
+    // painting.  As events are processed in the meantime, <mimeData> may
+    // be deleted before this returns (e.g. if the clipboard changes), so
+    // callers must take anything else they need from <mimeData>
+    // beforehand, and must not assume that they still exist afterwards
+    // (use a QPointer).
     static kpAbstractImageSelection *decode(const QMimeData *mimeData);
+
+  private:
+    kpAbstractImageSelection *m_selection;
+    mutable QHash <QString, QByteArray> m_encodedData;
 };
 
 
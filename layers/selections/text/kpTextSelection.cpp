@@ -79,6 +79,12 @@ kpTextSelection &kpTextSelection::operator= (const kpTextSelection &rhs)
     d->textStyle = rhs.d->textStyle;
     d->preeditText = rhs.d->preeditText;
 
+    // (QImage is implicitly shared so this is cheap)
+    d->renderCache = rhs.d->renderCache;
+    d->renderCacheTextLines = rhs.d->renderCacheTextLines;
+    d->renderCacheTextStyle = rhs.d->renderCacheTextStyle;
+    d->renderCacheValid = rhs.d->renderCacheValid;
+
     return *this;
 }
 
@@ -286,8 +292,30 @@ QList <QString> kpTextSelection::textLines () const
 // public
 void kpTextSelection::setTextLines (const QList <QString> &textLines_)
 {
+    const QList <QString> oldTextLines = d->textLines;
     d->textLines = textLines_;
 
+    // Typing usually changes just 1 line so only ask for that line to be
+    // repainted.
+    if (oldTextLines.count () == d->textLines.count ())
+    {
+        QRect changedRect;
+        for (int row = 0; row < d->textLines.count (); row++)
+        {
+            if (d->textLines [row] != oldTextLines [row]) {
+                changedRect |= textLineUpdateRect (row);
+            }
+        }
+
+        if (changedRect.isEmpty ()) {
+            return;
+        }
+
+        emit changed (changedRect.translated (boundingRect ().topLeft ())
+                          .intersected (boundingRect ()));
+        return;
+    }
+
     emit changed (boundingRect ());
 }
 
@@ -341,6 +369,7 @@ kpPreeditText kpTextSelection::preeditText () const
 void kpTextSelection::setPreeditText (const kpPreeditText &preeditText)
 {
     d->preeditText = preeditText;
+    d->renderCacheValid = false;
     emit changed (boundingRect ());
 }
 
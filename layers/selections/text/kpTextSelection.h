@@ -265,6 +265,22 @@ public:
 private:
     void drawPreeditString(QPainter &painter, int &x, int y, const kpPreeditText &preeditText) const;
 
+    // Renders the text box into <*image>, which is the size of
+    // boundingRect() and relative to its top-left.  Only the pixels inside
+    // <updateRect> are replaced and only the lines that might touch
+    // <updateRect> are drawn.
+    void drawTextBox (QImage *image, const QRect &updateRect) const;
+
+    // Brings the cached rendering of the text box, that paint() composites
+    // from, up to date.  If only some lines have changed since the last
+    // time, only those lines are redrawn.
+    void updateRenderCache () const;
+
+    // Returns the rectangle, relative to boundingRect(), covering line
+    // <row> plus one line of slack above and below, for glyphs that
+    // overhang their line.
+    QRect textLineUpdateRect (int row) const;
+
 public:
     void paint(QImage *destPixmap, const QRect &docRect) const override;
 
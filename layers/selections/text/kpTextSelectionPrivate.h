@@ -41,6 +41,18 @@ struct kpTextSelectionPrivate
     QList <QString> textLines;
     kpTextStyle textStyle;
     kpPreeditText preeditText;
+
+    // The whole text box, as last rendered by kpTextSelection::paint(),
+    // and what it was rendered from.  Lines that differ from
+    // <renderCacheTextLines> are redrawn before the next paint.
+    //
+    // <renderCacheValid> is cleared when anything else that affects
+    // rendering, that we do not keep a copy of, changes (e.g. the preedit
+    // text).
+    mutable kpImage renderCache;
+    mutable QList <QString> renderCacheTextLines;
+    mutable kpTextStyle renderCacheTextStyle;
+    mutable bool renderCacheValid{false};
 };
 
 
@@ -113,45 +113,20 @@ void kpTextSelection::drawPreeditString(QPainter &painter, int &x, int y, const
 
 //---------------------------------------------------------------------
 
-// public virtual [kpAbstractSelection]
-void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
+// private
+void kpTextSelection::drawTextBox (QImage *image, const QRect &updateRect) const
 {
-#if DEBUG_KP_SELECTION
-    qCDebug(kpLogLayers) << "kpTextSelection::paint() textStyle: fcol="
-            << (int *) d->textStyle.foregroundColor ().toQRgb ()
-            << " bcol="
-            << (int *) d->textStyle.backgroundColor ().toQRgb ();
-#endif
+    const QRect theWholeAreaRect = image->rect ();
+    const QRect theTextAreaRect =
+        textAreaRect ().translated (-boundingRect ().topLeft ());
 
-    // Drawing text is slow so if the text box will be rendered completely
-    // outside of <destRect>, don't bother rendering it at all.
-    const QRect modifyingRect = docRect.intersected (boundingRect ());
-    if (modifyingRect.isEmpty ()) {
-        return;
-    }
-
-
-    // Is the text box completely invisible?
-    if (textStyle ().foregroundColor ().isTransparent () &&
-        textStyle ().backgroundColor ().isTransparent ())
-    {
-        return;
-    }
-
-    kpImage floatImage(modifyingRect.size(), QImage::Format_ARGB32_Premultiplied);
-    floatImage.fill(0);
-
-    QRect theWholeAreaRect, theTextAreaRect;
-    theWholeAreaRect = boundingRect ().translated (-modifyingRect.topLeft ());
-    theTextAreaRect = textAreaRect ().translated (-modifyingRect.topLeft ());
-
-    QList <QString> theTextLines = textLines();
-    kpTextStyle theTextStyle = textStyle();
+    const QList <QString> &theTextLines = d->textLines;
+    const kpTextStyle &theTextStyle = d->textStyle;
 
     const QFontMetrics fontMetrics (theTextStyle.font ());
 
 #if DEBUG_KP_SELECTION
-    qCDebug(kpLogLayers) << "kpTextSelection_Paint.cpp:DrawTextHelper";
+    qCDebug(kpLogLayers) << "kpTextSelection::drawTextBox(updateRect=" << updateRect << ")";
     qCDebug(kpLogLayers) << "\theight=" << fontMetrics.height ()
                << " leading=" << fontMetrics.leading ()
                << " ascent=" << fontMetrics.ascent ()
@@ -159,17 +134,28 @@ void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
                << " lineSpacing=" << fontMetrics.lineSpacing ();
 #endif
 
-    QPainter painter(&floatImage);
+    // Could the line with baseline <baseLine> draw inside <updateRect>?
+    // Allow a line's worth of slack for glyphs that overhang their line.
+    const auto lineTouchesUpdateRect = [&] (int baseLine)
+    {
+        return (baseLine + fontMetrics.descent () + fontMetrics.lineSpacing () >= updateRect.top () &&
+                baseLine - fontMetrics.ascent () - fontMetrics.lineSpacing () <= updateRect.bottom ());
+    };
+
+    QPainter painter(image);
+    painter.setClipRect(updateRect.intersected (theWholeAreaRect));
 
-    // Fill in the background using the transparent/opaque tool setting
+    // Fill in the background using the transparent/opaque tool setting,
+    // replacing whatever was previously rendered there.
+    painter.setCompositionMode(QPainter::CompositionMode_Source);
     if ( theTextStyle.isBackgroundTransparent() ) {
       painter.fillRect(theWholeAreaRect, Qt::transparent);
     }
     else {
       painter.fillRect(theWholeAreaRect, theTextStyle.backgroundColor().toQColor());
     }
+    painter.setCompositionMode(QPainter::CompositionMode_SourceOver);
 
-    painter.setClipRect(theWholeAreaRect);
     painter.setPen(theTextStyle.foregroundColor().toQColor());
     painter.setFont(theTextStyle.font());
 
@@ -183,7 +169,9 @@ void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
       int baseLine = theTextAreaRect.y () + fontMetrics.ascent ();
       for (const auto &str : theTextLines)
       {
-          painter.drawText (theTextAreaRect.x (), baseLine, str);
+          if (lineTouchesUpdateRect (baseLine)) {
+              painter.drawText (theTextAreaRect.x (), baseLine, str);
+          }
           baseLine += fontMetrics.lineSpacing ();
 
           // if the next textline would already be below the visible text area, stop drawing
@@ -201,7 +189,7 @@ void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
     // characters (!) and then the cursor gets out of sync.
     int baseLine = theTextAreaRect.y () + fontMetrics.ascent ();
 
-    kpPreeditText thePreeditText = preeditText();
+    const kpPreeditText &thePreeditText = d->preeditText;
 
     if ( theTextLines.isEmpty() )
     {
@@ -218,7 +206,11 @@ void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
         int col = thePreeditText.position().x();
         for (const auto &str : theTextLines)
         {
-            if (row == i && !thePreeditText.isEmpty())
+            if (!lineTouchesUpdateRect (baseLine))
+            {
+                // skip
+            }
+            else if (row == i && !thePreeditText.isEmpty())
             {
                 QString left = str.left(col);
                 QString right = str.mid(col);
@@ -242,12 +234,97 @@ void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
             }
         }
     }
+}
+
+//---------------------------------------------------------------------
+
+// private
+QRect kpTextSelection::textLineUpdateRect (int row) const
+{
+    const QFontMetrics fontMetrics (d->textStyle.font ());
+
+    const int lineTop = kpTextSelection::TextBorderSize () +
+        row * fontMetrics.lineSpacing ();
+
+    return  {0, lineTop - fontMetrics.lineSpacing (),
+             width (), fontMetrics.lineSpacing () * 3};
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTextSelection::updateRenderCache () const
+{
+    const bool canRedrawJustChangedLines =
+        d->renderCacheValid &&
+        d->renderCache.size () == boundingRect ().size () &&
+        d->renderCacheTextStyle == d->textStyle &&
+        d->renderCacheTextLines.count () == d->textLines.count ();
+
+    if (canRedrawJustChangedLines)
+    {
+        for (int row = 0; row < d->textLines.count (); row++)
+        {
+            if (d->textLines [row] != d->renderCacheTextLines [row]) {
+                drawTextBox (&d->renderCache, textLineUpdateRect (row));
+            }
+        }
+    }
+    else
+    {
+    #if DEBUG_KP_SELECTION
+        qCDebug(kpLogLayers) << "kpTextSelection::updateRenderCache() redrawing everything";
+    #endif
+        d->renderCache = kpImage (boundingRect ().size (),
+                                  QImage::Format_ARGB32_Premultiplied);
+        d->renderCache.fill (0);
+        drawTextBox (&d->renderCache, d->renderCache.rect ());
+    }
+
+    d->renderCacheTextLines = d->textLines;
+    d->renderCacheTextStyle = d->textStyle;
+    // The preedit text is drawn on top of the lines, so don't bother working
+    // out what to redraw when it goes away.
+    d->renderCacheValid = d->preeditText.isEmpty ();
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [kpAbstractSelection]
+void kpTextSelection::paint(QImage *destPixmap, const QRect &docRect) const
+{
+#if DEBUG_KP_SELECTION
+    qCDebug(kpLogLayers) << "kpTextSelection::paint() textStyle: fcol="
+            << (int *) d->textStyle.foregroundColor ().toQRgb ()
+            << " bcol="
+            << (int *) d->textStyle.backgroundColor ().toQRgb ();
+#endif
+
+    // Drawing text is slow so if the text box will be rendered completely
+    // outside of <destRect>, don't bother rendering it at all.
+    const QRect modifyingRect = docRect.intersected (boundingRect ());
+    if (modifyingRect.isEmpty ()) {
+        return;
+    }
+
+
+    // Is the text box completely invisible?
+    if (textStyle ().foregroundColor ().isTransparent () &&
+        textStyle ().backgroundColor ().isTransparent ())
+    {
+        return;
+    }
+
+    // Drawing text is slow so we keep the whole rendered text box around,
+    // which saves redrawing every line on every keystroke and cursor blink.
+    updateRenderCache ();
 
     // ... convert that into "painting" transparent pixels on top of
     // the document.
     kpPixmapFX::paintPixmapAt (destPixmap,
         modifyingRect.topLeft () - docRect.topLeft (),
-        floatImage);
+        d->renderCache.copy (
+            modifyingRect.translated (-boundingRect ().topLeft ())));
 }
 
 //---------------------------------------------------------------------
@@ -36,6 +36,7 @@
 #include "widgets/toolbars/kpColorToolBar.h"
 #include "commands/kpCommandHistory.h"
 #include "document/kpDocument.h"
+#include "document/kpDocumentJournal.h"
 #include "environments/document/kpDocumentEnvironment.h"
 #include "layers/selections/kpSelectionDrag.h"
 #include "kpThumbnail.h"
@@ -43,6 +44,7 @@
 #include "widgets/toolbars/kpToolToolBar.h"
 #include "views/manager/kpViewManager.h"
 #include "kpViewScrollableContainer.h"
+#include "generic/kpStartupProfile.h"
 #include "generic/kpWidgetMapper.h"
 #include "views/kpZoomedThumbnailView.h"
 #include "views/kpZoomedView.h"
@@ -53,6 +55,7 @@
 
 #include <QEvent>
 #include <QMenu>
+#include <QPointer>
 #include <QTimer>
 #include <QDropEvent>
 
@@ -66,6 +69,7 @@ kpMainWindow::kpMainWindow ()
 {
     init ();
     open (QUrl (), true/*create an empty doc*/);
+    kpStartupProfile::mark ("open document");
 
     d->isFullyConstructed = true;
 }
@@ -77,6 +81,7 @@ kpMainWindow::kpMainWindow (const QUrl &url)
 {
     init ();
     open (url, true/*create an empty doc with the same url if url !exist*/);
+    kpStartupProfile::mark ("open document");
 
     d->isFullyConstructed = true;
 }
@@ -211,16 +216,21 @@ void kpMainWindow::init ()
 
     readGeneralSettings ();
     readThumbnailSettings ();
+    kpStartupProfile::mark ("read settings");
 
     //
     // create GUI
     //
     setupActions ();
+    kpStartupProfile::mark ("actions");
     createStatusBar ();
     createGUI ();
+    kpStartupProfile::mark ("menus and toolbars");
 
     createColorBox ();
+    kpStartupProfile::mark ("color box");
     createToolBox ();
+    kpStartupProfile::mark ("tool box");
 
 
     // Let the Tool Box take all the vertical space, since it can be quite
@@ -276,6 +286,7 @@ void kpMainWindow::init ()
       cfg.sync();
     }
 
+    kpStartupProfile::mark ("main window");
 
 #if DEBUG_KP_MAIN_WINDOW
     qCDebug(kpLogMainWindow) << "\tall done in " << totalTime.elapsed () << "msec";
@@ -581,6 +592,9 @@ void kpMainWindow::setDocument (kpDocument *newDoc)
     qCDebug(kpLogMainWindow) << "\tdestroying document";
     qCDebug(kpLogMainWindow) << "\t\td->document=" << d->document;
 #endif
+    // (deletes its crash recovery journal)
+    delete d->documentJournal; d->documentJournal = nullptr;
+
     // destroy current document
     delete d->document;
     d->document = newDoc;
@@ -691,6 +705,9 @@ void kpMainWindow::setDocument (kpDocument *newDoc)
         connect (d->document, &kpDocument::documentSaved,
                  d->commandHistory, &kpCommandHistory::documentSaved);
 
+        // Crash recovery
+        d->documentJournal = new kpDocumentJournal (d->document, this);
+
         // Sync document -> views
         connect (d->document, &kpDocument::contentsChanged,
                  d->viewManager, &kpViewManager::updateViews);
@@ -760,9 +777,20 @@ void kpMainWindow::dropEvent (QDropEvent *e)
     qCDebug(kpLogMainWindow) << "kpMainWindow::dropEvent" << e->pos ();
 #endif
 
-    QList<QUrl> urls;
+    // decode() may process events, during which the drag can end (deleting
+    // e->mimeData()) and we can be closed.
+    const QList<QUrl> urls = e->mimeData ()->urls ();
+    const bool hasText = e->mimeData ()->hasText ();
+    const QString text = hasText ? e->mimeData ()->text () : QString ();
+    QPointer <kpMainWindow> thisWindow (this);
 
     kpAbstractImageSelection *sel = kpSelectionDrag::decode (e->mimeData ());
+    if (!thisWindow)
+    {
+        delete sel;
+        return;
+    }
+
     if (sel)
     {
         // TODO: How do you actually drop a selection or ordinary images on
@@ -772,7 +800,7 @@ void kpMainWindow::dropEvent (QDropEvent *e)
         paste (*sel);
         delete sel;
     }
-    else if (!(urls = e->mimeData ()->urls ()).isEmpty ())
+    else if (!urls.isEmpty ())
     {
         // LOTODO: kpSetOverrideCursorSaver cursorSaver (Qt::waitCursor);
         //
@@ -782,10 +810,8 @@ void kpMainWindow::dropEvent (QDropEvent *e)
         for (const auto &u : urls)
             open (u);
     }
-    else if (e->mimeData ()->hasText ())
+    else if (hasText)
     {
-        const QString text = e->mimeData ()->text ();
-
         QPoint selTopLeft = KP_INVALID_POINT;
         const QPoint globalPos = QWidget::mapToGlobal (e->pos ());
     #if DEBUG_KP_MAIN_WINDOW
@@ -164,6 +164,12 @@ public:
     bool toolIsASelectionTool (bool includingTextTool = true) const;
     bool toolIsTextTool () const;
 
+    // Replays the input events recorded by kpToolInputRecorder at <path>
+    // against the current document and prints the time taken by the tools
+    // to handle them, and a hash of the resulting image, to stdout.
+    // The window need not be shown.
+    bool replayToolInput (const QString &path);
+
 private:
     // Ends the current shape.  If there is no shape currently being drawn,
     // it does nothing.
@@ -323,6 +329,13 @@ private:
     // make sense to bubble the Recent Files list.
     bool open (const QUrl &url, bool newDocSameNameIfNotExist = false);
 
+public:
+    // Replaces the document with the one recovered from the crash recovery
+    // journal at <journalPath> (see kpDocumentJournal::orphanedJournals()),
+    // deleting the journal.  Returns false if nothing could be recovered.
+    bool recoverDocument (const QString &journalPath);
+
+private:
     QList<QUrl> askForOpenURLs(const QString &caption,
                               bool allowMultipleURLs = true);
 
@@ -369,7 +382,10 @@ private slots:
 private:
     void sendDocumentNameToPrinter (QPrinter *printer);
     void setPrinterPageOrientation(QPrinter *printer);
-    void sendImageToPrinter(QPrinter *printer, bool showPrinterSetupDialog);
+    // If <isPreview>, the image is sent at a lower resolution if it is
+    // big, as it is only going to be shown on the screen.
+    void sendImageToPrinter(QPrinter *printer, bool showPrinterSetupDialog,
+                            bool isPreview = false);
 
 private slots:
     void slotPrint ();
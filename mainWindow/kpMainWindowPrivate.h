@@ -56,6 +56,7 @@ class kpZoomedView;
 class kpThumbnail;
 class kpThumbnailView;
 class kpDocument;
+class kpDocumentJournal;
 class kpViewManager;
 class kpColorToolBar;
 class kpToolToolBar;
@@ -78,6 +79,7 @@ struct kpMainWindowPrivate
       colorToolBar(nullptr),
       toolToolBar(nullptr),
       commandHistory(nullptr),
+      documentJournal(nullptr),
 
       configFirstTime(false),
       configShowGrid(false),
@@ -266,6 +268,7 @@ struct kpMainWindowPrivate
   kpColorToolBar *colorToolBar;
   kpToolToolBar *toolToolBar;
   kpCommandHistory *commandHistory;
+  kpDocumentJournal *documentJournal;
 
   bool configFirstTime;
   bool configShowGrid;
@@ -35,6 +35,7 @@
 #include <QImage>
 #include <QList>
 #include <QMenu>
+#include <QPointer>
 #include <QDesktopWidget>
 #include <QScrollBar>
 
@@ -591,16 +592,28 @@ void kpMainWindow::slotPaste()
 
     const QMimeData *mimeData = QApplication::clipboard()->mimeData(QClipboard::Clipboard);
 
+    // decode() may process events, during which the clipboard can change
+    // (deleting <mimeData>) and we can be closed.
+    const bool hasText = mimeData->hasText();
+    const QString text = hasText ? mimeData->text() : QString();
+    QPointer<kpMainWindow> thisWindow(this);
+
     kpAbstractImageSelection *sel = kpSelectionDrag::decode(mimeData);
+    if ( !thisWindow )
+    {
+        delete sel;
+        return;
+    }
+
     if ( sel )
     {
         sel->setTransparency(imageSelectionTransparency());
         paste(*sel);
         delete sel;
     }
-    else if ( mimeData->hasText() )
+    else if ( hasText )
     {
-        pasteText(mimeData->text());
+        pasteText(text);
     }
     else
     {
@@ -633,7 +646,8 @@ void kpMainWindow::slotPasteInNewWindow ()
     // Requirement 2. transparent pixels in the image must remain as transparent.
     //
 
-    auto *win = new kpMainWindow (nullptr/*no document*/);
+    // (slotPaste() may process events, during which <win> can be closed)
+    QPointer<kpMainWindow> win = new kpMainWindow (nullptr/*no document*/);
     win->show ();
 
     // Make "Edit / Paste in New Window" always paste white pixels as white.
@@ -655,6 +669,8 @@ void kpMainWindow::slotPasteInNewWindow ()
 
     // (this handles Requirement 1. above)
     win->slotPaste ();
+    if ( !win )
+      return;
 
     // if slotPaste could not decode clipboard data, no document was created
     if ( win->document() )
@@ -51,6 +51,7 @@
 #include <QImageWriter>
 #include <QMimeDatabase>
 #include <QPrintPreviewDialog>
+#include <QVector>
 
 #include <KActionCollection>
 #include <KEMailClientLauncherJob>
@@ -68,10 +69,12 @@
 #include "commands/kpCommandHistory.h"
 #include "kpDefs.h"
 #include "document/kpDocument.h"
+#include "document/kpDocumentJournal.h"
 #include "commands/imagelib/kpDocumentMetaInfoCommand.h"
 #include "dialogs/imagelib/kpDocumentMetaInfoDialog.h"
 #include "widgets/kpDocumentSaveOptionsWidget.h"
 #include "pixmapfx/kpPixmapFX.h"
+#include "generic/kpTrace.h"
 #include "widgets/kpPrintDialogPage.h"
 #include "views/kpView.h"
 #include "views/manager/kpViewManager.h"
@@ -429,6 +432,38 @@ bool kpMainWindow::open (const QUrl &url, bool newDocSameNameIfNotExist)
 
 //---------------------------------------------------------------------
 
+// public
+bool kpMainWindow::recoverDocument (const QString &journalPath)
+{
+    QImage image;
+    QUrl url;
+    kpDocumentSaveOptions saveOptions;
+    if (!kpDocumentJournal::recover (journalPath, &image, &url, &saveOptions)) {
+        return false;
+    }
+
+    auto *newDoc = new kpDocument (image.width (), image.height (),
+                                   documentEnvironment ());
+    newDoc->setImage (image);
+    newDoc->setSaveOptions (saveOptions);
+    // The file at <url> does not have the recovered changes so don't
+    // pretend that the document was opened from it.
+    newDoc->setURL (url, false/*not from existing URL*/);
+
+    setDocument (newDoc);
+    newDoc->setModified (true);
+
+    // Don't lose the recovered document if we crash again before it is
+    // changed.
+    Q_ASSERT (d->documentJournal);
+    d->documentJournal->checkpoint ();
+
+    kpDocumentJournal::discard (journalPath);
+    return true;
+}
+
+//---------------------------------------------------------------------
+
 // private
 QList<QUrl> kpMainWindow::askForOpenURLs(const QString &caption, bool allowMultipleURLs)
 {
@@ -1169,16 +1204,104 @@ void kpMainWindow::setPrinterPageOrientation(QPrinter *printer)
 
 void kpMainWindow::sendPreviewToPrinter(QPrinter *printer)
 {
-  sendImageToPrinter(printer, false);
+  sendImageToPrinter(printer, false, true/*preview*/);
+}
+
+//--------------------------------------------------------------------------------
+
+// The most memory a band of the printed image may take.
+static const int MaxPrintBandBytes = 16 * 1024 * 1024;
+
+// The longest side of the image sent to the print preview.
+static const int MaxPrintPreviewDimension = 2048;
+
+// Draws <document>, with its selection, stretched without antialiasing to
+// <targetRect> of <painter>.
+//
+// This is done a horizontal band at a time, so that a whole (possibly
+// stretched) copy of a big image never needs to be in memory at once.
+//
+// If <resolutionScale> is less than 1, the bands are rendered at that
+// fraction of the size of <targetRect> and <painter> scales them up.
+static void DrawDocumentInBands (QPainter *painter, const kpDocument *document,
+        const QRect &targetRect, double resolutionScale)
+{
+    const int srcWidth = document->width (), srcHeight = document->height ();
+    const int outWidth = qMax (1, qRound (targetRect.width () * resolutionScale));
+    const int outHeight = qMax (1, qRound (targetRect.height () * resolutionScale));
+    const bool isStretched = (outWidth != srcWidth || outHeight != srcHeight);
+
+    QVector <int> srcXForOutX (outWidth);
+    for (int x = 0; x < outWidth; x++) {
+        srcXForOutX [x] = int (qint64 (x) * srcWidth / outWidth);
+    }
+
+    // Both the source band and its stretched copy must fit in
+    // MaxPrintBandBytes.  When shrinking (e.g. for the preview), the source
+    // band is the bigger of the two.
+    const int outBandRows = qMax (1, MaxPrintBandBytes / (outWidth * 4));
+    const int srcBandRows = qMax (1, MaxPrintBandBytes / (srcWidth * 4));
+    const int outRowsForSrcBand = int (qMax (qint64 (1),
+        qint64 (srcBandRows) * outHeight / srcHeight));
+    const int bandHeight = qMin (outBandRows, outRowsForSrcBand);
+    for (int outY0 = 0; outY0 < outHeight; outY0 += bandHeight)
+    {
+        const int outY1 = qMin (outHeight, outY0 + bandHeight);
+
+        const int srcY0 = int (qint64 (outY0) * srcHeight / outHeight);
+        const int srcY1 = int (qint64 (outY1 - 1) * srcHeight / outHeight) + 1;
+
+        kpImage band = document->imageWithSelection (
+            QRect (0, srcY0, srcWidth, srcY1 - srcY0));
+
+        // Nearest neighbour, like kpPixmapFX::scale() without antialiasing.
+        if (isStretched)
+        {
+            band = band.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+
+            kpImage outBand (outWidth, outY1 - outY0, QImage::Format_ARGB32_Premultiplied);
+            for (int y = outY0; y < outY1; y++)
+            {
+                const int srcY = int (qint64 (y) * srcHeight / outHeight);
+                const auto *srcLine = reinterpret_cast <const QRgb *> (
+                    band.constScanLine (srcY - srcY0));
+                auto *outLine = reinterpret_cast <QRgb *> (outBand.scanLine (y - outY0));
+
+                for (int x = 0; x < outWidth; x++) {
+                    outLine [x] = srcLine [srcXForOutX [x]];
+                }
+            }
+
+            band = outBand;
+        }
+
+    #if DEBUG_KP_MAIN_WINDOW
+        qCDebug(kpLogMainWindow) << "\tband: outY=[" << outY0 << "," << outY1
+                   << ") srcY=[" << srcY0 << "," << srcY1 << ")";
+    #endif
+
+        const double targetY0 = double (outY0) * targetRect.height () / outHeight;
+        const double targetY1 = double (outY1) * targetRect.height () / outHeight;
+        painter->drawImage (
+            QRectF (targetRect.x (), targetRect.y () + targetY0,
+                    targetRect.width (), targetY1 - targetY0),
+            band);
+    }
 }
 
 //--------------------------------------------------------------------------------
 // private
 void kpMainWindow::sendImageToPrinter (QPrinter *printer,
-        bool showPrinterSetupDialog)
+        bool showPrinterSetupDialog, bool isPreview)
 {
-    // Get image to be printed.
-    kpImage image = d->document->imageWithSelection ();
+    KP_TRACE_SCOPE ("mainWindow", "kpMainWindow::sendImageToPrinter");
+
+    // Size of the image to be printed.  We don't get the image itself
+    // (kpDocument::imageWithSelection()) here as, for big images, the
+    // copy -- never mind the stretched copy below -- is a lot of memory.
+    // Instead, DrawDocumentInBands() fetches it a band at a time.
+    int imageWidth = d->document->width ();
+    int imageHeight = d->document->height ();
 
 
     // Get image DPI.
@@ -1186,8 +1309,8 @@ void kpMainWindow::sendImageToPrinter (QPrinter *printer,
     auto imageDotsPerMeterY = double (d->document->metaInfo ()->dotsPerMeterY ());
 #if DEBUG_KP_MAIN_WINDOW
     qCDebug(kpLogMainWindow) << "kpMainWindow::sendImageToPrinter() image:"
-               << " width=" << image.width ()
-               << " height=" << image.height ()
+               << " width=" << imageWidth
+               << " height=" << imageHeight
                << " dotsPerMeterX=" << imageDotsPerMeterX
                << " dotsPerMeterY=" << imageDotsPerMeterY;
 #endif
@@ -1256,9 +1379,9 @@ void kpMainWindow::sendImageToPrinter (QPrinter *printer,
     //
 
     const auto scaleDpiX =
-        (image.width () / (printerWidthMM / KP_MILLIMETERS_PER_INCH)) / dpiX;
+        (imageWidth / (printerWidthMM / KP_MILLIMETERS_PER_INCH)) / dpiX;
     const auto scaleDpiY =
-        (image.height () / (printerHeightMM / KP_MILLIMETERS_PER_INCH)) / dpiY;
+        (imageHeight / (printerHeightMM / KP_MILLIMETERS_PER_INCH)) / dpiY;
     const auto scaleDpi = qMax (scaleDpiX, scaleDpiY);
 
 #if DEBUG_KP_MAIN_WINDOW
@@ -1289,10 +1412,7 @@ void kpMainWindow::sendImageToPrinter (QPrinter *printer,
         qCDebug(kpLogMainWindow) << "\tdpiX > dpiY; stretching image height to equalise DPIs to dpiX="
                    << dpiX;
     #endif
-        kpPixmapFX::scale (&image,
-             image.width (),
-             qMax (1, qRound (image.height () * dpiX / dpiY)),
-             false/*don't antialias*/);
+        imageHeight = qMax (1, qRound (imageHeight * dpiX / dpiY));
 
         dpiY = dpiX;
     }
@@ -1302,10 +1422,7 @@ void kpMainWindow::sendImageToPrinter (QPrinter *printer,
         qCDebug(kpLogMainWindow) << "\tdpiY > dpiX; stretching image width to equalise DPIs to dpiY="
                    << dpiY;
     #endif
-        kpPixmapFX::scale (&image,
-             qMax (1, qRound (image.width () * dpiY / dpiX)),
-             image.height (),
-             false/*don't antialias*/);
+        imageWidth = qMax (1, qRound (imageWidth * dpiY / dpiX));
 
         dpiX = dpiY;
     }
@@ -1359,11 +1476,22 @@ void kpMainWindow::sendImageToPrinter (QPrinter *printer,
     // Center image on page?
     if (d->configPrintImageCenteredOnPage)
     {
-        originX = (printer->width() - image.width ()) / 2;
-        originY = (printer->height() - image.height ()) / 2;
+        originX = (printer->width() - imageWidth) / 2;
+        originY = (printer->height() - imageHeight) / 2;
+    }
+
+    // The preview is only shown on the screen so don't bother sending
+    // more pixels than it can show.
+    double resolutionScale = 1.0;
+    if (isPreview)
+    {
+        resolutionScale = qMin (1.0,
+            double (MaxPrintPreviewDimension) / qMax (imageWidth, imageHeight));
     }
 
-    painter.drawImage(qRound(originX), qRound(originY), image);
+    ::DrawDocumentInBands (&painter, d->document,
+        QRect (qRound(originX), qRound(originY), imageWidth, imageHeight),
+        resolutionScale);
     painter.end();
 }
 
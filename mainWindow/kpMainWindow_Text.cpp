@@ -323,15 +323,8 @@ KToolBar *kpMainWindow::textToolBar ()
 
 bool kpMainWindow::isTextStyleBackgroundOpaque () const
 {
-    if (d->toolToolBar)
-    {
-        kpToolWidgetOpaqueOrTransparent *oot =
-            d->toolToolBar->toolWidgetOpaqueOrTransparent ();
-
-        if (oot)
-        {
-            return oot->isOpaque ();
-        }
+    if (d->toolToolBar) {
+        return d->toolToolBar->drawOpaque ();
     }
 
     return true;
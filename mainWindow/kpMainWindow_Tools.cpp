@@ -29,8 +29,20 @@
 #include "mainWindow/kpMainWindow.h"
 #include "kpMainWindowPrivate.h"
 
+#include <algorithm>
+#include <cstdio>
+
 #include <QActionGroup>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QInputMethodEvent>
+#include <QKeyEvent>
 #include <QList>
+#include <QMap>
+#include <QMouseEvent>
+#include <QScopedPointer>
+#include <QVector>
+#include <QWheelEvent>
 
 #include <KActionCollection>
 #include <KSharedConfig>
@@ -52,6 +64,7 @@
 #include "tools/rectangular/kpToolEllipse.h"
 #include "tools/flow/kpToolEraser.h"
 #include "tools/kpToolFloodFill.h"
+#include "tools/kpToolInputRecorder.h"
 #include "tools/selection/image/kpToolFreeFormSelection.h"
 #include "tools/polygonal/kpToolLine.h"
 #include "tools/flow/kpToolPen.h"
@@ -64,11 +77,13 @@
 #include "tools/flow/kpToolSpraycan.h"
 #include "tools/selection/text/kpToolText.h"
 #include "widgets/toolbars/kpToolToolBar.h"
+#include "widgets/toolbars/options/kpToolWidgetBase.h"
 #include "widgets/toolbars/options/kpToolWidgetOpaqueOrTransparent.h"
 #include "tools/kpToolZoom.h"
 #include "commands/imagelib/transforms/kpTransformResizeScaleCommand.h"
 #include "kpViewScrollableContainer.h"
 #include "views/kpZoomedView.h"
+#include "views/manager/kpViewManager.h"
 
 //---------------------------------------------------------------------
 
@@ -99,6 +114,10 @@ void kpMainWindow::setupToolActions ()
     kpToolSelectionEnvironment *toolSelEnv = toolSelectionEnvironment ();
     kpToolEnvironment *toolEnv = toolEnvironment ();
 
+    // The tools are created up front, unlike their option widgets (see
+    // kpToolToolBar).  Each is little more than its kpToolAction, which the
+    // menus, shortcuts and Tool Box need at startup anyway, so creating
+    // them on demand would only save a few small allocations.
     d->tools.append (d->toolFreeFormSelection = new kpToolFreeFormSelection (toolSelEnv, this));
     d->tools.append (d->toolRectSelection = new kpToolRectSelection (toolSelEnv, this));
 
@@ -186,8 +205,9 @@ void kpMainWindow::createToolBox ()
     connect (d->toolToolBar, &kpToolToolBar::toolWidgetOptionSelected,
              this, &kpMainWindow::updateToolOptionPrevNextActionsEnabled);
 
-    connect (d->toolToolBar->toolWidgetOpaqueOrTransparent(),
-             &kpToolWidgetOpaqueOrTransparent::isOpaqueChanged,
+    // (doesn't create the Opaque/Transparent tool widget, which is left
+    //  until a selection tool needs it)
+    connect (d->toolToolBar, &kpToolToolBar::drawOpaqueChanged,
              this, &kpMainWindow::updateActionDrawOpaqueChecked);
 
     updateActionDrawOpaqueChecked ();
@@ -287,8 +307,7 @@ void kpMainWindow::updateActionDrawOpaqueChecked ()
     qCDebug(kpLogMainWindow) << "kpMainWindow::updateActionDrawOpaqueChecked()";
 #endif
 
-    const bool drawOpaque =
-        (d->toolToolBar->toolWidgetOpaqueOrTransparent ()->selectedRow () == 0);
+    const bool drawOpaque = d->toolToolBar->drawOpaque ();
 #if DEBUG_KP_MAIN_WINDOW
     qCDebug(kpLogMainWindow) << "\tdrawOpaque=" << drawOpaque;
 #endif
@@ -368,6 +387,188 @@ bool kpMainWindow::toolIsTextTool () const
 
 //---------------------------------------------------------------------
 
+static const char *ReplayEventTypeName (QEvent::Type type)
+{
+    switch (type)
+    {
+    case QEvent::MouseButtonPress: return "mouse press";
+    case QEvent::MouseMove: return "mouse move";
+    case QEvent::MouseButtonRelease: return "mouse release";
+    case QEvent::Wheel: return "wheel";
+    case QEvent::KeyPress: return "key press";
+    case QEvent::KeyRelease: return "key release";
+    case QEvent::InputMethod: return "input method";
+    default: return "other";
+    }
+}
+
+// <sortedNS> must be sorted.
+static double ReplayPercentileUS (const QVector <qint64> &sortedNS, int percentile)
+{
+    const int i = int ((sortedNS.size () - 1) * qint64 (percentile) / 100);
+    return sortedNS [i] / 1000.0;
+}
+
+// public
+bool kpMainWindow::replayToolInput (const QString &path)
+{
+    QList <kpToolInputRecord> records;
+    if (!kpToolInputRecorder::read (path, &records))
+    {
+        qCWarning(kpLogMainWindow) << "Could not read input recording" << path;
+        return false;
+    }
+
+    Q_ASSERT (d->document && d->mainView && d->viewManager);
+
+    QMap <int/*QEvent::Type*/, QVector <qint64> > latenciesNS;
+    QElapsedTimer totalTimer;
+    totalTimer.start ();
+
+    for (const auto &record : records)
+    {
+        switch (record.kind)
+        {
+        case kpToolInputRecord::Start:
+            if (record.documentSize != d->document->rect ().size () ||
+                record.documentHash !=
+                    kpToolInputRecorder::imageHash (d->document->imageWithSelection ()))
+            {
+                qCWarning(kpLogMainWindow) << "The document is not the one that"
+                                              " the input was recorded with";
+            }
+            break;
+
+        case kpToolInputRecord::State:
+        {
+            for (auto *t : d->tools)
+            {
+                if (t->objectName () == record.toolName)
+                {
+                    if (t != tool ()) {
+                        d->toolToolBar->selectTool (t);
+                    }
+                    break;
+                }
+            }
+
+            d->colorToolBar->setForegroundColor (kpColor (record.foregroundColor));
+            d->colorToolBar->setBackgroundColor (kpColor (record.backgroundColor));
+            d->colorToolBar->setColorSimilarity (record.colorSimilarity);
+
+            if (d->mainView->zoomLevelX () != record.zoomLevelX) {
+                zoomTo (record.zoomLevelX);
+            }
+
+            for (int i = 0; kpToolWidgetBase *w = d->toolToolBar->shownToolWidget (i); i++)
+            {
+                for (const auto &selection : record.toolWidgetSelections)
+                {
+                    if (selection.first == w->objectName ())
+                    {
+                        w->setSelected (selection.second.y (), selection.second.x (),
+                                        false/*don't save as default*/);
+                        break;
+                    }
+                }
+            }
+            break;
+        }
+
+        case kpToolInputRecord::Event:
+        {
+            kpTool *currentTool = tool ();
+            QScopedPointer <QEvent> e (record.createEvent ());
+            if (!currentTool || !e) {
+                break;
+            }
+
+            // (normally set by kpView as the mouse enters it)
+            d->viewManager->setViewUnderCursor (d->mainView);
+
+            QElapsedTimer timer;
+            timer.start ();
+
+            switch (record.type)
+            {
+            case QEvent::MouseButtonPress:
+                currentTool->mousePressEvent (static_cast <QMouseEvent *> (e.data ()));
+                break;
+            case QEvent::MouseMove:
+                currentTool->mouseMoveEvent (static_cast <QMouseEvent *> (e.data ()));
+                break;
+            case QEvent::MouseButtonRelease:
+                currentTool->mouseReleaseEvent (static_cast <QMouseEvent *> (e.data ()));
+                break;
+            case QEvent::Wheel:
+                currentTool->wheelEvent (static_cast <QWheelEvent *> (e.data ()));
+                break;
+            case QEvent::KeyPress:
+                currentTool->keyPressEvent (static_cast <QKeyEvent *> (e.data ()));
+                break;
+            case QEvent::KeyRelease:
+                currentTool->keyReleaseEvent (static_cast <QKeyEvent *> (e.data ()));
+                break;
+            case QEvent::InputMethod:
+                currentTool->inputMethodEvent (static_cast <QInputMethodEvent *> (e.data ()));
+                break;
+            default:
+                break;
+            }
+
+            // Flow tools only queue the points of mouse moves, to draw them
+            // on the next display frame.  Draw them now, so that they are
+            // timed with the event rather than from the timer in
+            // processEvents() below.
+            kpToolInputRecorder::drawQueuedPoints (currentTool);
+
+            latenciesNS [record.type].append (timer.nsecsElapsed ());
+
+            // Let the deferred work (e.g. view updates) happen, as it would
+            // between real events.
+            QCoreApplication::processEvents (QEventLoop::ExcludeUserInputEvents);
+            break;
+        }
+        }
+    }
+
+    // Finish any shape still being drawn, so that it is in the image.
+    toolEndShape ();
+
+    //
+    // Report
+    //
+
+    int numEvents = 0;
+    for (const auto &latencies : latenciesNS) {
+        numEvents += latencies.size ();
+    }
+
+    printf ("%d events replayed in %.1f ms\n",
+            numEvents, totalTimer.nsecsElapsed () / 1e6);
+
+    for (auto it = latenciesNS.constBegin (); it != latenciesNS.constEnd (); ++it)
+    {
+        QVector <qint64> sortedNS = it.value ();
+        std::sort (sortedNS.begin (), sortedNS.end ());
+
+        printf ("%-14s n=%-7d p50=%.1fus p90=%.1fus p99=%.1fus max=%.1fus\n",
+                ::ReplayEventTypeName (QEvent::Type (it.key ())),
+                sortedNS.size (),
+                ::ReplayPercentileUS (sortedNS, 50),
+                ::ReplayPercentileUS (sortedNS, 90),
+                ::ReplayPercentileUS (sortedNS, 99),
+                sortedNS.last () / 1000.0);
+    }
+
+    printf ("image %dx%d sha1=%s\n",
+            d->document->width (), d->document->height (),
+            kpToolInputRecorder::imageHash (d->document->imageWithSelection ()).constData ());
+
+    return true;
+}
+
+//---------------------------------------------------------------------
 
 // private
 void kpMainWindow::toolEndShape ()
@@ -382,10 +583,8 @@ void kpMainWindow::toolEndShape ()
 // public
 kpImageSelectionTransparency kpMainWindow::imageSelectionTransparency () const
 {
-    kpToolWidgetOpaqueOrTransparent *oot = d->toolToolBar->toolWidgetOpaqueOrTransparent ();
-    Q_ASSERT (oot);
-
-    return kpImageSelectionTransparency (oot->isOpaque (), backgroundColor (), d->colorToolBar->colorSimilarity ());
+    return kpImageSelectionTransparency (d->toolToolBar->drawOpaque (),
+        backgroundColor (), d->colorToolBar->colorSimilarity ());
 }
 
 //---------------------------------------------------------------------
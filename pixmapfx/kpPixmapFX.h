@@ -49,6 +49,7 @@ class QImage;
 class QPoint;
 class QPolygon;
 class QRect;
+class QRegion;
 
 
 
@@ -113,6 +114,46 @@ public:
     static kpColor getColorAtPixel (const QImage &pm, const QPoint &at);
     static kpColor getColorAtPixel (const QImage &pm, int x, int y);
 
+    //
+    // Returns the area in which the pixels of <newImage> differ from
+    // those of <oldImage>, in tiles of ChangedRegionTileSize x
+    // ChangedRegionTileSize pixels.
+    //
+    // If the images have different sizes, formats or color tables,
+    // the whole of both images is returned.
+    //
+    static const int ChangedRegionTileSize = 64;
+    static QRegion changedRegion (const QImage &oldImage, const QImage &newImage);
+
+//
+// Indexed Images
+//
+// kpDocument keeps 1-bit and 8-bit images in their original indexed
+// format, to save memory.  QPainter cannot draw onto these so these
+// methods write the color table indices directly.
+//
+
+public:
+    // Returns whether <image> stores indices into a color table
+    // (QImage::Format_Mono, QImage::Format_MonoLSB or QImage::Format_Indexed8).
+    static bool isIndexed (const QImage &image);
+
+    // Returns the index of <color> in the color table of <image>, or -1 if
+    // it is not there.  All fully transparent colors are considered equal.
+    static int colorTableIndex (const QImage &image, const kpColor &color);
+
+    // Same as setPixmapAt() but for an indexed <*destPixmapPtr>.
+    //
+    // Returns false, without changing <*destPixmapPtr>, if <srcPixmap> has a
+    // color that is not in the color table of <*destPixmapPtr>.
+    static bool setIndexedPixmapAt (QImage *destPixmapPtr, const QPoint &destAt,
+                                    const QImage &srcPixmap);
+
+    // Sets the pixels from (<x1>, <y>) to (<x2>, <y>) inclusive, of the
+    // indexed <*destPixmapPtr>, to color table index <index>.
+    static void setIndexedPixels (QImage *destPixmapPtr, int x1, int x2, int y,
+                                  int index);
+
 //
 // Transforms
 //
@@ -130,7 +171,8 @@ public:
 
     //
     // Scales an image to the given width and height.
-    // If <pretty> is true, a smooth scale will be used.
+    // If <pretty> is true, a smooth scale will be used (see
+    // kpTransformResample::smoothScaleFilter()).
     //
     static void scale (QImage *destPtr, int w, int h, bool pretty = false);
     static QImage scale (const QImage &pm, int w, int h, bool pretty = false);
@@ -32,13 +32,19 @@
 #include "kpPixmapFX.h"
 
 
+#include <cstring>
+
+#include <QHash>
 #include <QImage>
 #include <QPainter>
 #include <QPoint>
 #include <QRect>
+#include <QRegion>
+#include <QVector>
 
 #include "kpLogCategories.h"
 
+#include "generic/kpParallel.h"
 #include "imagelib/kpColor.h"
 
 //---------------------------------------------------------------------
@@ -140,3 +146,242 @@ kpColor kpPixmapFX::getColorAtPixel (const QImage &img, int x, int y)
 }
 
 //---------------------------------------------------------------------
+
+// Returns <rgba> with all fully transparent colors mapped to the same value.
+static QRgb NormalizeTransparent (QRgb rgba)
+{
+    return qAlpha (rgba) == 0 ? 0 : rgba;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QRegion kpPixmapFX::changedRegion (const QImage &oldImage, const QImage &newImage)
+{
+    if (oldImage.size () != newImage.size () ||
+        oldImage.format () != newImage.format () ||
+        oldImage.colorTable () != newImage.colorTable ())
+    {
+        return QRegion (oldImage.rect ()) + newImage.rect ();
+    }
+
+    // Still sharing the same pixels?
+    if (oldImage.cacheKey () == newImage.cacheKey ()) {
+        return {};
+    }
+
+    const int width = newImage.width (), height = newImage.height ();
+    const int depth = newImage.depth ();
+    const int T = ChangedRegionTileSize;
+
+    const int tilesAcross = (width + T - 1) / T;
+    const int tileRows = (height + T - 1) / T;
+    const size_t lineBytes = (size_t (width) * depth + 7) / 8;
+
+    // The changed tiles of each row of tiles, with runs of adjacent tiles
+    // merged.
+    QVector <QVector <QRect> > rowRects (tileRows);
+
+    kpParallel::forBands (tileRows, 1, [&] (int begin, int end)
+    {
+        QVector <char> tileChanged (tilesAcross);
+
+        for (int tileY = begin; tileY < end; tileY++)
+        {
+            const int y0 = tileY * T, y1 = qMin (height, y0 + T);
+
+            tileChanged.fill (0);
+            int numUnchangedTiles = tilesAcross;
+
+            for (int y = y0; y < y1 && numUnchangedTiles > 0; y++)
+            {
+                const uchar *oldLine = oldImage.constScanLine (y);
+                const uchar *newLine = newImage.constScanLine (y);
+
+                // (memcmp() is vectorized by the C library)
+                if (std::memcmp (oldLine, newLine, lineBytes) == 0) {
+                    continue;
+                }
+
+                for (int tileX = 0; tileX < tilesAcross; tileX++)
+                {
+                    if (tileChanged [tileX]) {
+                        continue;
+                    }
+
+                    const size_t byte0 = size_t (tileX) * T * depth / 8;
+                    const size_t byte1 = qMin (lineBytes,
+                        (size_t (tileX + 1) * T * depth + 7) / 8);
+                    if (std::memcmp (oldLine + byte0, newLine + byte0, byte1 - byte0) != 0)
+                    {
+                        tileChanged [tileX] = 1;
+                        numUnchangedTiles--;
+                    }
+                }
+            }
+
+            for (int tileX = 0; tileX < tilesAcross;)
+            {
+                if (!tileChanged [tileX])
+                {
+                    tileX++;
+                    continue;
+                }
+
+                const int startTileX = tileX;
+                while (tileX < tilesAcross && tileChanged [tileX]) {
+                    tileX++;
+                }
+
+                const int x0 = startTileX * T, x1 = qMin (width, tileX * T);
+                rowRects [tileY].append (QRect (x0, y0, x1 - x0, y1 - y0));
+            }
+        }
+    });
+
+    QRegion region;
+    for (const auto &rects : rowRects)
+    {
+        for (const auto &rect : rects) {
+            region += rect;
+        }
+    }
+
+    return region;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPixmapFX::isIndexed (const QImage &image)
+{
+    return (image.format () == QImage::Format_Mono ||
+            image.format () == QImage::Format_MonoLSB ||
+            image.format () == QImage::Format_Indexed8);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+int kpPixmapFX::colorTableIndex (const QImage &image, const kpColor &color)
+{
+    Q_ASSERT (kpPixmapFX::isIndexed (image));
+
+    if (!color.isValid ()) {
+        return -1;
+    }
+
+    const QRgb rgba = ::NormalizeTransparent (color.toQRgb ());
+    for (int i = 0; i < image.colorCount (); i++)
+    {
+        if (::NormalizeTransparent (image.color (i)) == rgba) {
+            return i;
+        }
+    }
+
+    return -1;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpPixmapFX::setIndexedPixmapAt (QImage *destPtr, const QPoint &destAt,
+                                     const QImage &src)
+{
+    Q_ASSERT (destPtr && kpPixmapFX::isIndexed (*destPtr));
+
+    const QRect destRect =
+        QRect (destAt, src.size ()).intersected (destPtr->rect ());
+    if (destRect.isEmpty ()) {
+        return true;
+    }
+
+    // (iterate backwards so that the first of any duplicate colors wins)
+    QHash <QRgb, uchar> indexForColor;
+    for (int i = destPtr->colorCount () - 1; i >= 0; i--) {
+        indexForColor.insert (::NormalizeTransparent (destPtr->color (i)), uchar (i));
+    }
+
+    // Look up every pixel before writing any, so that we can give up
+    // without having changed anything.
+    const QImage srcARGB = src.convertToFormat (QImage::Format_ARGB32);
+    QVector <uchar> indices (destRect.width () * destRect.height ());
+    uchar *index = indices.data ();
+
+    QRgb lastRGBA = 0;
+    uchar lastIndex = 0;
+    bool haveLast = false;
+    for (int y = destRect.top (); y <= destRect.bottom (); y++)
+    {
+        const auto *srcLine = reinterpret_cast <const QRgb *> (
+            srcARGB.constScanLine (y - destAt.y ()));
+        for (int x = destRect.left (); x <= destRect.right (); x++)
+        {
+            const QRgb rgba = ::NormalizeTransparent (srcLine [x - destAt.x ()]);
+            if (!haveLast || rgba != lastRGBA)
+            {
+                auto it = indexForColor.constFind (rgba);
+                if (it == indexForColor.constEnd ())
+                {
+                #if DEBUG_KP_PIXMAP_FX
+                    qCDebug(kpLogPixmapfx) << "kpPixmapFX::setIndexedPixmapAt() color"
+                               << (int *) rgba << "not in color table";
+                #endif
+                    return false;
+                }
+
+                lastRGBA = rgba;
+                lastIndex = *it;
+                haveLast = true;
+            }
+
+            *index++ = lastIndex;
+        }
+    }
+
+    index = indices.data ();
+    for (int y = destRect.top (); y <= destRect.bottom (); y++)
+    {
+        if (destPtr->format () == QImage::Format_Indexed8)
+        {
+            uchar *destLine = destPtr->scanLine (y);
+            for (int x = destRect.left (); x <= destRect.right (); x++) {
+                destLine [x] = *index++;
+            }
+        }
+        else
+        {
+            for (int x = destRect.left (); x <= destRect.right (); x++) {
+                destPtr->setPixel (x, y, *index++);
+            }
+        }
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpPixmapFX::setIndexedPixels (QImage *destPtr, int x1, int x2, int y,
+                                  int index)
+{
+    Q_ASSERT (destPtr && kpPixmapFX::isIndexed (*destPtr));
+    Q_ASSERT (index >= 0 && index < destPtr->colorCount ());
+
+    if (destPtr->format () == QImage::Format_Indexed8)
+    {
+        uchar *destLine = destPtr->scanLine (y);
+        for (int x = x1; x <= x2; x++) {
+            destLine [x] = uchar (index);
+        }
+    }
+    else
+    {
+        for (int x = x1; x <= x2; x++) {
+            destPtr->setPixel (x, y, uint (index));
+        }
+    }
+}
+
+//---------------------------------------------------------------------
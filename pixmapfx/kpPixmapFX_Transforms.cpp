@@ -42,6 +42,8 @@
 
 #include "layers/selections/kpAbstractSelection.h"
 #include "imagelib/kpColor.h"
+#include "imagelib/transforms/kpTransformResample.h"
+#include "imagelib/transforms/kpTransformWarp.h"
 #include "kpDefs.h"
 
 //---------------------------------------------------------------------
@@ -122,8 +124,13 @@ QImage kpPixmapFX::scale (const QImage &image, int w, int h, bool pretty)
         return image;
     }
 
-    return image.scaled(w, h, Qt::IgnoreAspectRatio,
-                        pretty ? Qt::SmoothTransformation : Qt::FastTransformation);
+    if (pretty)
+    {
+        return kpTransformResample::scale (image, w, h,
+            kpTransformResample::smoothScaleFilter (image.size (), QSize (w, h)));
+    }
+
+    return image.scaled(w, h, Qt::IgnoreAspectRatio, Qt::FastTransformation);
 }
 
 //---------------------------------------------------------------------
@@ -418,40 +425,22 @@ static QImage TransformPixmap (const QImage &pm, const QTransform &transformMatr
     }
 
 
-#if DEBUG_KP_PIXMAP_FX && 0
-    qCDebug(kpLogPixmapfx) << "\ttranslate top=" << painter.xForm (QPoint (0, 0));
-    qCDebug(kpLogPixmapfx) << "\tmatrix: m11=" << painter.worldMatrix ().m11 ()
-               << " m12=" << painter.worldMatrix ().m12 ()
-               << " m21=" << painter.worldMatrix ().m21 ()
-               << " m22=" << painter.worldMatrix ().m22 ()
-               << " dx=" << painter.worldMatrix ().dx ()
-               << " dy=" << painter.worldMatrix ().dy ()
-               << endl;
-#endif
-
+    // Fill the entire new image with the background color.
+    newQImage.fill (backgroundColor.isValid () ?
+        backgroundColor.toQColor () : QColor (Qt::transparent));
 
-    // Note: Do _not_ use "p.setRenderHints (QPainter::SmoothPixmapTransform);"
+    // Note: Do _not_ add smoothing to kpTransformWarp (or, formerly,
+    //       "p.setRenderHints (QPainter::SmoothPixmapTransform);")
     //       as the user does not want their image to get blurier every
     //       time they e.g. rotate it (especially important for multiples
     //       of 90 degrees but also true for every other angle).  Being a
     //       pixel-based program, we generally like to preserve RGB values
     //       and avoid unnecessary blurs -- in the worst case, we'd rather
     //       drop pixels, than blur.
-    QPainter p (&newQImage);
-    {
-        // Make sure transparent pixels are drawn into the destination image.
-        p.setCompositionMode (QPainter::CompositionMode_Source);
-
-        // Fill the entire new image with the background color.
-        if (backgroundColor.isValid ())
-        {
-            p.fillRect (newQImage.rect (), backgroundColor.toQColor ());
-        }
-
-        p.setWorldTransform (transformMatrix);
-        p.drawImage (QPoint (0, 0), pm);
-    }
-    p.end ();
+    //
+    // This also replaces transparent pixels in the destination image, as
+    // QPainter::CompositionMode_Source used to.
+    kpTransformWarp::warp (&newQImage, pm, transformMatrix);
 
 #if DEBUG_KP_PIXMAP_FX && 1
     qCDebug(kpLogPixmapfx) << "Done";
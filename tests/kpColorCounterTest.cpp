@@ -0,0 +1,249 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpColorCounter.h"
+
+#include <QImage>
+#include <QSet>
+#include <QTest>
+#include <QVector>
+
+
+// Returns the distinct colors of <image>, as kpColorCounter should report
+// them, worked out the slow way.
+static QVector <QRgb> ReferenceDistinctColors (const QImage &image)
+{
+    // (unpremultiply with qUnpremultiply(), like kpColorCounter, rather
+    //  than with convertToFormat(), which may round differently)
+    const bool isPremultiplied =
+        (image.format () == QImage::Format_ARGB32_Premultiplied);
+    const QImage image32 = isPremultiplied ?
+        image : image.convertToFormat (QImage::Format_ARGB32);
+
+    QVector <QRgb> ret;
+    for (int y = 0; y < image32.height (); y++)
+    {
+        const auto *line = reinterpret_cast <const QRgb *> (image32.constScanLine (y));
+        for (int x = 0; x < image32.width (); x++)
+        {
+            QRgb pixel = isPremultiplied ? qUnpremultiply (line [x]) : line [x];
+            if (qAlpha (pixel) == 0) {
+                pixel = 0;
+            }
+
+            if (!ret.contains (pixel)) {
+                ret.append (pixel);
+            }
+        }
+    }
+
+    return ret;
+}
+
+// Returns <image> as QImage::Format_ARGB32, with every fully transparent
+// pixel set to 0.
+static QImage Normalized (const QImage &image)
+{
+    QImage ret = image.convertToFormat (QImage::Format_ARGB32);
+    for (int y = 0; y < ret.height (); y++)
+    {
+        auto *line = reinterpret_cast <QRgb *> (ret.scanLine (y));
+        for (int x = 0; x < ret.width (); x++)
+        {
+            if (qAlpha (line [x]) == 0) {
+                line [x] = 0;
+            }
+        }
+    }
+
+    return ret;
+}
+
+// Returns a <width>x<height> image of <format> that cycles through
+// <numColors> colors, in runs of <runLength> pixels.
+static QImage MakeImage (int width, int height, QImage::Format format,
+        int numColors, int runLength)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+    int i = 0;
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++, i++)
+        {
+            const int color = (i / runLength) % numColors;
+            ret.setPixel (x, y,
+                qRgba (color & 0xFF, color >> 8, color * 37 % 256, 255));
+        }
+    }
+
+    return ret.convertToFormat (format);
+}
+
+//---------------------------------------------------------------------
+
+class kpColorCounterTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void distinctColors_data ();
+    void distinctColors ();
+
+    void tooManyColors ();
+    void transparentPixelsAreOneColor ();
+
+    void toIndexed_data ();
+    void toIndexed ();
+};
+
+//---------------------------------------------------------------------
+
+void kpColorCounterTest::distinctColors_data ()
+{
+    QTest::addColumn <QImage> ("image");
+
+    QTest::newRow ("one color") << MakeImage (17, 9, QImage::Format_RGB32, 1, 1);
+    QTest::newRow ("runs") << MakeImage (64, 64, QImage::Format_RGB32, 200, 7);
+    QTest::newRow ("no runs") << MakeImage (64, 64, QImage::Format_ARGB32, 256, 1);
+    QTest::newRow ("premultiplied")
+        << MakeImage (64, 64, QImage::Format_ARGB32_Premultiplied, 100, 3);
+    QTest::newRow ("RGB16") << MakeImage (33, 31, QImage::Format_RGB16, 50, 5);
+    QTest::newRow ("indexed")
+        << MakeImage (40, 40, QImage::Format_ARGB32, 20, 2)
+               .convertToFormat (QImage::Format_Indexed8, Qt::ThresholdDither);
+
+    QImage translucent = MakeImage (32, 32, QImage::Format_ARGB32, 16, 4);
+    for (int x = 0; x < translucent.width (); x++) {
+        translucent.setPixel (x, 5, qRgba (255, 0, 0, x * 8));
+    }
+    QTest::newRow ("translucent") << translucent;
+    QTest::newRow ("translucent premultiplied")
+        << translucent.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+}
+
+void kpColorCounterTest::distinctColors ()
+{
+    QFETCH (QImage, image);
+
+    const QVector <QRgb> expected = ::ReferenceDistinctColors (image);
+
+    QVector <QRgb> colors;
+    QVERIFY (kpColorCounter::distinctColors (image, expected.size (), &colors));
+
+    // (the order can differ for premultiplied images, where two different
+    //  premultiplied colors can stand for the same unpremultiplied color)
+    QCOMPARE (colors.size (), expected.size ());
+    QCOMPARE (QSet <QRgb>::fromList (colors.toList ()),
+              QSet <QRgb>::fromList (expected.toList ()));
+
+    if (expected.size () > 1) {
+        QVERIFY (!kpColorCounter::distinctColors (image, expected.size () - 1));
+    }
+}
+
+//---------------------------------------------------------------------
+
+void kpColorCounterTest::tooManyColors ()
+{
+    const QImage image = MakeImage (64, 64, QImage::Format_RGB32, 300, 1);
+
+    // Giving up must not stop a later, bigger search of the same image
+    // from succeeding...
+    QVERIFY (!kpColorCounter::distinctColors (image, 256));
+    QVERIFY (!kpColorCounter::distinctColors (image, 299));
+
+    QVector <QRgb> colors;
+    QVERIFY (kpColorCounter::distinctColors (image, 300, &colors));
+    QCOMPARE (colors.size (), 300);
+
+    // ...and a successful search must still answer smaller ones correctly.
+    QVERIFY (!kpColorCounter::distinctColors (image, 256));
+    QVERIFY (kpColorCounter::distinctColors (image, 1000));
+
+    QVERIFY (!kpColorCounter::fitsInColorTable (image, 8));
+}
+
+void kpColorCounterTest::transparentPixelsAreOneColor ()
+{
+    QImage image (16, 16, QImage::Format_ARGB32);
+    for (int y = 0; y < image.height (); y++)
+    {
+        for (int x = 0; x < image.width (); x++) {
+            image.setPixel (x, y, qRgba (x * 16, y * 16, 7, 0));
+        }
+    }
+    image.setPixel (3, 3, qRgba (1, 2, 3, 255));
+
+    QVector <QRgb> colors;
+    QVERIFY (kpColorCounter::distinctColors (image, 2, &colors));
+    QCOMPARE (colors, QVector <QRgb> () << 0 << qRgba (1, 2, 3, 255));
+
+    // Transparency can't go in a low color depth file.
+    QVERIFY (!kpColorCounter::fitsInColorTable (image, 8));
+}
+
+//---------------------------------------------------------------------
+
+void kpColorCounterTest::toIndexed_data ()
+{
+    QTest::addColumn <QImage> ("image");
+    QTest::addColumn <int> ("depth");
+
+    QTest::newRow ("8-bit") << MakeImage (50, 41, QImage::Format_RGB32, 256, 3) << 8;
+    QTest::newRow ("8-bit, few colors") << MakeImage (50, 41, QImage::Format_RGB32, 5, 9) << 8;
+    QTest::newRow ("1-bit") << MakeImage (67, 13, QImage::Format_RGB32, 2, 5) << 1;
+    QTest::newRow ("1-bit, one color") << MakeImage (67, 13, QImage::Format_RGB32, 1, 1) << 1;
+
+    QImage transparent = MakeImage (20, 20, QImage::Format_ARGB32, 30, 1);
+    for (int x = 0; x < transparent.width (); x++) {
+        transparent.setPixel (x, 10, qRgba (x, 0, 0, 0));
+    }
+    QTest::newRow ("transparent") << transparent << 8;
+}
+
+void kpColorCounterTest::toIndexed ()
+{
+    QFETCH (QImage, image);
+    QFETCH (int, depth);
+
+    QVector <QRgb> colors;
+    QVERIFY (kpColorCounter::distinctColors (image, 1 << depth, &colors));
+
+    const QImage indexed = kpColorCounter::toIndexed (image, colors, depth);
+    QCOMPARE (indexed.depth (), depth);
+    QCOMPARE (indexed.size (), image.size ());
+
+    // Must have lost nothing.
+    QCOMPARE (::Normalized (indexed), ::Normalized (image));
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpColorCounterTest)
+
+#include "kpColorCounterTest.moc"
@@ -0,0 +1,264 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/effects/kpEffectHSV.h"
+
+#include <cmath>
+
+#include <QImage>
+#include <QString>
+#include <QTest>
+
+
+//
+// The per-pixel maths that kpEffectHSV used before it learnt to process
+// whole scanlines, copied verbatim.  kpEffectHSV must still give exactly
+// the same results.
+//
+
+static void ReferenceColorToHSV(unsigned int c, float* pHue, float* pSaturation, float* pValue)
+{
+    int r = qRed(c);
+    int g = qGreen(c);
+    int b = qBlue(c);
+    int min{};
+    if(b >= g && b >= r)
+    {
+        // Blue
+        min = qMin(r, g);
+        if(b != min)
+        {
+            *pHue = static_cast<float> (r - g) / ((b - min) * 6) + static_cast<float> (2) / 3;
+            *pSaturation = 1.0f - static_cast<float> (min) / static_cast<float> (b);
+        }
+        else
+        {
+            *pHue = 0;
+            *pSaturation = 0;
+        }
+        *pValue = static_cast<float> (b) / 255;
+    }
+    else if(g >= r)
+    {
+        // Green
+        min = qMin(b, r);
+        if(g != min)
+        {
+            *pHue = static_cast<float> (b - r) / ((g - min) * 6) + static_cast<float> (1) / 3;
+            *pSaturation = 1.0f - static_cast<float> (min) / static_cast<float> (g);
+        }
+        else
+        {
+            *pHue = 0;
+            *pSaturation = 0;
+        }
+        *pValue = static_cast<float> (g) / 255;
+    }
+    else
+    {
+        // Red
+        min = qMin(g, b);
+        if(r != min)
+        {
+            *pHue = static_cast<float> (g - b) / ((r - min) * 6);
+            if(*pHue < 0) {
+                (*pHue) += 1.0f;
+            }
+            *pSaturation = 1.0f - static_cast<float> (min) / static_cast<float> (r);
+        }
+        else
+        {
+            *pHue = 0;
+            *pSaturation = 0;
+        }
+        *pValue = static_cast<float> (r) / 255;
+    }
+}
+
+static unsigned int ReferenceHSVToColor(int alpha, float hue, float saturation, float value)
+{
+    hue *= 5.999999f;
+    int h = static_cast<int> (hue);
+    float f = hue - h;
+    float p = value * (1.0 - saturation);
+    float q = value * (1.0 - ((h & 1) == 0 ? 1.0 - f : f) * saturation);
+    switch(h)
+    {
+        case 0: return qRgba(static_cast<int> (value * 255.999999),
+                             static_cast<int> (q * 255.999999),
+                             static_cast<int> (p * 255.999999), alpha);
+
+        case 1: return qRgba(static_cast<int> (q * 255.999999),
+                             static_cast<int> (value * 255.999999),
+                             static_cast<int> (p * 255.999999), alpha);
+
+        case 2: return qRgba(static_cast<int> (p * 255.999999),
+                             static_cast<int> (value * 255.999999),
+                             static_cast<int> (q * 255.999999), alpha);
+
+        case 3: return qRgba(static_cast<int> (p * 255.999999),
+                             static_cast<int> (q * 255.999999),
+                             static_cast<int> (value * 255.999999), alpha);
+
+        case 4: return qRgba(static_cast<int> (q * 255.999999),
+                             static_cast<int> (p * 255.999999),
+                             static_cast<int> (value * 255.999999), alpha);
+
+        case 5: return qRgba(static_cast<int> (value * 255.999999),
+                             static_cast<int> (p * 255.999999),
+                             static_cast<int> (q * 255.999999), alpha);
+    }
+    return qRgba(0, 0, 0, alpha);
+}
+
+static QRgb ReferenceAdjustHSV (QRgb pix, double hueDiv360, double saturation, double value)
+{
+    float h, s, v;
+    ::ReferenceColorToHSV(pix, &h, &s, &v);
+
+    const int alpha = qAlpha(pix);
+
+    h += static_cast<float> (hueDiv360);
+    h -= std::floor(h);
+
+    s = qMax(0.0f, qMin(static_cast<float>(1), s + static_cast<float> (saturation)));
+
+    v = qMax(0.0f, qMin(static_cast<float>(1), v + static_cast<float> (value)));
+
+    return ::ReferenceHSVToColor(alpha, h, s, v);
+}
+
+// QImage::pixel() and QImage::setPixel() don't convert Format_ARGB32
+// pixels, so this is what kpEffectHSV used to do for such images.
+static QImage ReferenceApplyEffect (const QImage &image,
+        double hue, double saturation, double value)
+{
+    Q_ASSERT (image.format () == QImage::Format_ARGB32);
+
+    QImage result = image;
+    for (int y = 0; y < result.height (); y++)
+    {
+        auto *line = reinterpret_cast <QRgb *> (result.scanLine (y));
+        for (int x = 0; x < result.width (); x++) {
+            line [x] = ::ReferenceAdjustHSV (line [x], hue / 360, saturation, value);
+        }
+    }
+
+    return result;
+}
+
+//---------------------------------------------------------------------
+
+class kpEffectHSVTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void initTestCase ();
+
+    void matchesReference_data ();
+    void matchesReference ();
+
+private:
+    QImage m_allColors;
+};
+
+//---------------------------------------------------------------------
+
+void kpEffectHSVTest::initTestCase ()
+{
+    // All 256 values of each channel, in every combination.  Each of these
+    // 2^24 colors appears only once, with one of 4 alpha values depending
+    // on its column (the alpha doesn't take part in the maths, it's only
+    // carried through).
+    m_allColors = QImage (4096, 4096, QImage::Format_ARGB32);
+    for (int y = 0; y < m_allColors.height (); y++)
+    {
+        auto *line = reinterpret_cast <QRgb *> (m_allColors.scanLine (y));
+        for (int x = 0; x < m_allColors.width (); x++)
+        {
+            const uint alpha = 255 - (x & 3) * 85;
+            line [x] = (alpha << 24) | (uint (y) * 4096 + uint (x));
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+void kpEffectHSVTest::matchesReference_data ()
+{
+    QTest::addColumn <double> ("hue");
+    QTest::addColumn <double> ("saturation");
+    QTest::addColumn <double> ("value");
+
+    QTest::newRow ("darker") << 0.0 << 0.0 << -0.5;
+    QTest::newRow ("slightly lighter") << 0.0 << 0.0 << 1.0 / 255;
+    QTest::newRow ("white") << 0.0 << 0.0 << 1.0;
+    QTest::newRow ("desaturated") << 0.0 << -0.5 << 0.0;
+    QTest::newRow ("saturated") << 0.0 << 0.3 << 0.0;
+    QTest::newRow ("hue") << 120.0 << 0.0 << 0.0;
+    QTest::newRow ("everything") << -45.0 << 0.2 << -0.2;
+}
+
+void kpEffectHSVTest::matchesReference ()
+{
+    QFETCH (double, hue);
+    QFETCH (double, saturation);
+    QFETCH (double, value);
+
+    const QImage expected =
+        ::ReferenceApplyEffect (m_allColors, hue, saturation, value);
+    const QImage actual =
+        kpEffectHSV::applyEffect (m_allColors, hue, saturation, value);
+
+    QCOMPARE (actual.format (), expected.format ());
+    QCOMPARE (actual.size (), expected.size ());
+
+    for (int y = 0; y < expected.height (); y++)
+    {
+        const auto *expectedLine = reinterpret_cast <const QRgb *> (expected.constScanLine (y));
+        const auto *actualLine = reinterpret_cast <const QRgb *> (actual.constScanLine (y));
+
+        for (int x = 0; x < expected.width (); x++)
+        {
+            if (actualLine [x] != expectedLine [x])
+            {
+                QFAIL (qPrintable (QStringLiteral ("%1 became %2, expected %3")
+                    .arg (m_allColors.pixel (x, y), 8, 16, QLatin1Char ('0'))
+                    .arg (actualLine [x], 8, 16, QLatin1Char ('0'))
+                    .arg (expectedLine [x], 8, 16, QLatin1Char ('0'))));
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpEffectHSVTest)
+
+#include "kpEffectHSVTest.moc"
@@ -0,0 +1,142 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/effects/kpEffectReduceToPalette.h"
+
+#include <QImage>
+#include <QSet>
+#include <QString>
+#include <QTest>
+#include <QThreadPool>
+#include <QVector>
+
+
+// Returns a <width>x<height> gradient, partly translucent, which dithers
+// to a different color in most pixels.
+static QImage MakeImage (int width, int height)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            ret.setPixel (x, y, qRgba (x * 255 / width, y * 255 / height,
+                (x + y) % 256, (x % 17 == 0) ? 0 : (y % 13 == 0) ? 128 : 255));
+        }
+    }
+
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+class kpEffectReduceToPaletteTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void init ();
+    void cleanup ();
+
+    void sameForAnyThreadCount_data ();
+    void sameForAnyThreadCount ();
+
+private:
+    int m_maxThreadCount;
+};
+
+//---------------------------------------------------------------------
+
+void kpEffectReduceToPaletteTest::init ()
+{
+    m_maxThreadCount = QThreadPool::globalInstance ()->maxThreadCount ();
+}
+
+void kpEffectReduceToPaletteTest::cleanup ()
+{
+    QThreadPool::globalInstance ()->setMaxThreadCount (m_maxThreadCount);
+}
+
+//---------------------------------------------------------------------
+
+void kpEffectReduceToPaletteTest::sameForAnyThreadCount_data ()
+{
+    QTest::addColumn <bool> ("dither");
+
+    QTest::newRow ("dither") << true;
+    QTest::newRow ("no dither") << false;
+}
+
+// The output must not depend on how the image is split between threads
+// (in particular, dithering must not restart wherever a thread's band
+// happens to start).
+void kpEffectReduceToPaletteTest::sameForAnyThreadCount ()
+{
+    QFETCH (bool, dither);
+
+    // (tall enough for several bands)
+    const QImage image = ::MakeImage (300, 1000);
+
+    QVector <QRgb> palette;
+    for (int i = 0; i < 27; i++) {
+        palette.append (qRgb (i % 3 * 127, i / 3 % 3 * 127, i / 9 * 127));
+    }
+
+    QThreadPool::globalInstance ()->setMaxThreadCount (1);
+    const QImage expected = kpEffectReduceToPalette::applyEffect (image, palette, dither);
+
+    QSet <QRgb> paletteColors;
+    for (const QRgb rgb : palette) {
+        paletteColors.insert (rgb);
+    }
+    for (int y = 0; y < expected.height (); y++)
+    {
+        for (int x = 0; x < expected.width (); x++)
+        {
+            const QRgb pixel = expected.pixel (x, y);
+            if (qAlpha (pixel) == 255 && !paletteColors.contains (pixel))
+            {
+                QFAIL (qPrintable (QStringLiteral ("(%1,%2) is not in the palette")
+                    .arg (x).arg (y)));
+            }
+        }
+    }
+
+    for (const int numThreads : {2, 3, 8})
+    {
+        QThreadPool::globalInstance ()->setMaxThreadCount (numThreads);
+        QCOMPARE (kpEffectReduceToPalette::applyEffect (image, palette, dither),
+                  expected);
+    }
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpEffectReduceToPaletteTest)
+
+#include "kpEffectReduceToPaletteTest.moc"
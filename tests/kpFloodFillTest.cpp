@@ -0,0 +1,182 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpFloodFill.h"
+
+#include <QImage>
+#include <QPoint>
+#include <QString>
+#include <QTest>
+
+#include "imagelib/kpColor.h"
+#include "pixmapfx/kpPixmapFX.h"
+
+
+// Returns a <width>x<height> image of <format> made of a few colors, some
+// of them close to each other and some translucent.
+static QImage MakeImage (int width, int height, QImage::Format format)
+{
+    static const QRgb colors [] =
+    {
+        qRgba (200, 10, 10, 255),
+        qRgba (205, 12, 8, 255),  // (similar to the one above)
+        qRgba (10, 200, 10, 255),
+        qRgba (10, 10, 200, 128),
+        qRgba (0, 0, 0, 0),
+        qRgba (255, 255, 255, 255)
+    };
+    const int numColors = int (sizeof (colors) / sizeof (colors [0]));
+
+    QImage ret (width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) {
+            ret.setPixel (x, y, colors [(x / 3 + y / 5 + x * y % 7) % numColors]);
+        }
+    }
+
+    return ret.convertToFormat (format);
+}
+
+//---------------------------------------------------------------------
+
+class kpFloodFillTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void replaceAllRoundTrip_data ();
+    void replaceAllRoundTrip ();
+};
+
+//---------------------------------------------------------------------
+
+void kpFloodFillTest::replaceAllRoundTrip_data ()
+{
+    QTest::addColumn <QImage> ("image");
+    QTest::addColumn <QPoint> ("seed");
+    QTest::addColumn <QRgb> ("color");
+    QTest::addColumn <double> ("similarity");
+
+    // (wider than a changeMask word and taller than a kpParallel band)
+    const int W = 101, H = 77;
+    const QRgb orange = qRgba (255, 128, 0, 255);
+    const QRgb transparent = qRgba (0, 0, 0, 0);
+
+    // (0, 0) is qRgba (200, 10, 10, 255) and (0, 15) is translucent.
+    QTest::newRow ("exact")
+        << MakeImage (W, H, QImage::Format_ARGB32_Premultiplied)
+        << QPoint (0, 0) << orange << 0.0;
+    QTest::newRow ("similar")
+        << MakeImage (W, H, QImage::Format_ARGB32_Premultiplied)
+        << QPoint (0, 0) << orange << 0.05;
+    QTest::newRow ("translucent")
+        << MakeImage (W, H, QImage::Format_ARGB32_Premultiplied)
+        << QPoint (0, 15) << orange << 0.0;
+    QTest::newRow ("to transparent")
+        << MakeImage (W, H, QImage::Format_ARGB32_Premultiplied)
+        << QPoint (0, 0) << transparent << 0.05;
+    QTest::newRow ("not premultiplied")
+        << MakeImage (W, H, QImage::Format_ARGB32)
+        << QPoint (0, 15) << orange << 0.05;
+    QTest::newRow ("opaque")
+        << MakeImage (W, H, QImage::Format_RGB32)
+        << QPoint (0, 0) << orange << 0.05;
+    QTest::newRow ("indexed")
+        << MakeImage (W, H, QImage::Format_Indexed8)
+        << QPoint (0, 0) << qRgba (10, 200, 10, 255) << 0.0;
+}
+
+void kpFloodFillTest::replaceAllRoundTrip ()
+{
+    QFETCH (QImage, image);
+    QFETCH (QPoint, seed);
+    QFETCH (QRgb, color);
+    QFETCH (double, similarity);
+
+    const QImage original = image;
+    const kpColor fillColor = qAlpha (color) == 0 ? kpColor::Transparent : kpColor (color);
+    const int processedSimilarity = kpColor::processSimilarity (similarity);
+
+    kpFloodFill floodFill (&image, seed.x (), seed.y (), fillColor, processedSimilarity);
+    floodFill.setReplaceAllSimilarColors ();
+
+    const kpColor colorToChange = floodFill.colorToChange ();
+    const QVector <QRgb> oldColors = floodFill.colorsOfPixelsToChange ();
+
+    floodFill.fill ();
+    QCOMPARE (image.size (), original.size ());
+    if (kpPixmapFX::isIndexed (original)) {
+        QCOMPARE (image.format (), original.format ());
+    }
+
+    // Every similar pixel, wherever it is, and nothing else must have
+    // changed.
+    int numChanged = 0;
+    for (int y = 0; y < original.height (); y++)
+    {
+        for (int x = 0; x < original.width (); x++)
+        {
+            const kpColor before = kpPixmapFX::getColorAtPixel (original, x, y);
+            const kpColor after = kpPixmapFX::getColorAtPixel (image, x, y);
+
+            if (before.isSimilarTo (colorToChange, processedSimilarity))
+            {
+                numChanged++;
+                if (fillColor.isTransparent () ? !after.isTransparent () :
+                        !(after == fillColor))
+                {
+                    QFAIL (qPrintable (QStringLiteral ("(%1,%2) was not filled")
+                        .arg (x).arg (y)));
+                }
+            }
+            else if (original.pixel (x, y) != image.pixel (x, y))
+            {
+                QFAIL (qPrintable (QStringLiteral ("(%1,%2) should not have changed")
+                    .arg (x).arg (y)));
+            }
+        }
+    }
+    QVERIFY (numChanged > 0);
+    QVERIFY (numChanged < original.width () * original.height ());
+
+    QVERIFY (oldColors.isEmpty () == (processedSimilarity == kpColor::Exact));
+    if (!oldColors.isEmpty ()) {
+        QCOMPARE (oldColors.size (), numChanged);
+    }
+
+    // Undo must give back exactly the same pixels.
+    floodFill.unfill (oldColors);
+    QCOMPARE (image, original);
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_MAIN (kpFloodFillTest)
+
+#include "kpFloodFillTest.moc"
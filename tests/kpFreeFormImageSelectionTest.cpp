@@ -0,0 +1,167 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "layers/selections/image/kpFreeFormImageSelection.h"
+
+#include <QBitmap>
+#include <QColor>
+#include <QImage>
+#include <QPoint>
+#include <QPolygon>
+#include <QRect>
+#include <QString>
+#include <QTest>
+
+
+// Returns <bitmap> as an image whose opaque pixels are
+// QColor (Qt::color1).rgb ().
+static QImage BitmapImage (const QBitmap &bitmap)
+{
+    return bitmap.toImage ().convertToFormat (QImage::Format_RGB32);
+}
+
+//---------------------------------------------------------------------
+
+class kpFreeFormImageSelectionTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void sameAsPolygon_data ();
+    void sameAsPolygon ();
+};
+
+//---------------------------------------------------------------------
+
+void kpFreeFormImageSelectionTest::sameAsPolygon_data ()
+{
+    QTest::addColumn <QPolygon> ("points");
+    QTest::addColumn <QPoint> ("moveBy");
+    QTest::addColumn <bool> ("flipHoriz");
+    QTest::addColumn <bool> ("flipVert");
+
+    const QPolygon triangle = QPolygon ()
+        << QPoint (0, 0) << QPoint (20, 5) << QPoint (3, 17);
+    // (self-intersecting)
+    const QPolygon bowTie = QPolygon ()
+        << QPoint (0, 0) << QPoint (20, 20) << QPoint (20, 0) << QPoint (0, 20);
+    const QPolygon star = QPolygon ()
+        << QPoint (10, 0) << QPoint (16, 19) << QPoint (0, 7)
+        << QPoint (20, 7) << QPoint (4, 19);
+    // (already cardinally adjacent, like a freehand lasso)
+    const QPolygon lasso = QPolygon ()
+        << QPoint (5, 5) << QPoint (6, 5) << QPoint (6, 4) << QPoint (7, 4)
+        << QPoint (8, 4) << QPoint (8, 5) << QPoint (8, 6) << QPoint (9, 6)
+        << QPoint (9, 7) << QPoint (8, 7) << QPoint (7, 7) << QPoint (7, 8)
+        << QPoint (6, 8) << QPoint (5, 8) << QPoint (5, 7) << QPoint (4, 7)
+        << QPoint (4, 6) << QPoint (5, 6);
+    const QPolygon negative = QPolygon ()
+        << QPoint (-7, -3) << QPoint (12, -9) << QPoint (4, 8);
+    const QPolygon line = QPolygon ()
+        << QPoint (2, 3) << QPoint (11, 3);
+    const QPolygon point = QPolygon ()
+        << QPoint (5, 5);
+
+    const struct
+    {
+        const char *name;
+        QPolygon points;
+    } shapes [] =
+    {
+        {"triangle", triangle},
+        {"bow tie", bowTie},
+        {"star", star},
+        {"lasso", lasso},
+        {"negative", negative},
+        {"line", line},
+        {"point", point}
+    };
+
+    for (const auto &shape : shapes)
+    {
+        QTest::newRow (shape.name)
+            << shape.points << QPoint (0, 0) << false << false;
+        QTest::newRow (qPrintable (QStringLiteral ("%1 moved").arg (QLatin1String (shape.name))))
+            << shape.points << QPoint (13, -4) << false << false;
+        QTest::newRow (qPrintable (QStringLiteral ("%1 flipped horizontally").arg (QLatin1String (shape.name))))
+            << shape.points << QPoint (0, 0) << true << false;
+        QTest::newRow (qPrintable (QStringLiteral ("%1 flipped vertically").arg (QLatin1String (shape.name))))
+            << shape.points << QPoint (0, 0) << false << true;
+        QTest::newRow (qPrintable (QStringLiteral ("%1 moved and flipped").arg (QLatin1String (shape.name))))
+            << shape.points << QPoint (-6, 9) << true << true;
+    }
+}
+
+// The span mask must select the same pixels that
+// kpAbstractImageSelection::shapeBitmap() draws from calculatePoints()
+// with QPainter::drawPolygon().
+void kpFreeFormImageSelectionTest::sameAsPolygon ()
+{
+    QFETCH (QPolygon, points);
+    QFETCH (QPoint, moveBy);
+    QFETCH (bool, flipHoriz);
+    QFETCH (bool, flipVert);
+
+    kpFreeFormImageSelection sel (points);
+
+    // (calculate the span mask first, so that the changes below must keep
+    //  it up to date)
+    (void) sel.contains (points.first ());
+
+    if (!moveBy.isNull ()) {
+        sel.moveBy (moveBy.x (), moveBy.y ());
+    }
+    if (flipHoriz || flipVert) {
+        sel.flip (flipHoriz, flipVert);
+    }
+
+    const QImage expected = ::BitmapImage (sel.kpAbstractImageSelection::shapeBitmap ());
+    QCOMPARE (::BitmapImage (sel.shapeBitmap ()), expected);
+
+    const QRgb opaque = QColor (Qt::color1).rgb ();
+    const QRect rect = sel.boundingRect ();
+    for (int y = rect.top () - 2; y <= rect.bottom () + 2; y++)
+    {
+        for (int x = rect.left () - 2; x <= rect.right () + 2; x++)
+        {
+            const QPoint p = QPoint (x, y) - rect.topLeft ();
+            const bool inside = expected.valid (p) && expected.pixel (p) == opaque;
+            if (sel.contains (QPoint (x, y)) != inside)
+            {
+                QFAIL (qPrintable (QStringLiteral ("contains(%1,%2) != %3")
+                    .arg (x).arg (y).arg (inside)));
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_MAIN (kpFreeFormImageSelectionTest)
+
+#include "kpFreeFormImageSelectionTest.moc"
@@ -0,0 +1,198 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpPNGWriter.h"
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QImage>
+#include <QString>
+#include <QTest>
+
+
+// Returns a <width>x<height> image of <format>, that is partly noise (which
+// doesn't compress) and partly smooth (which does).
+static QImage MakeImage (int width, int height, QImage::Format format)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+
+    quint32 state = 12345;
+    for (int y = 0; y < height; y++)
+    {
+        auto *line = reinterpret_cast <QRgb *> (ret.scanLine (y));
+        for (int x = 0; x < width; x++)
+        {
+            state = state * 1664525u + 1013904223u;
+            if ((y / 16) % 2) {
+                line [x] = state;
+            }
+            else {
+                line [x] = qRgba (x % 256, y % 256, (x + y) % 256, (x * 3) % 256);
+            }
+        }
+    }
+
+    if (format == QImage::Format_RGB32)
+    {
+        for (int y = 0; y < height; y++)
+        {
+            auto *line = reinterpret_cast <QRgb *> (ret.scanLine (y));
+            for (int x = 0; x < width; x++) {
+                line [x] |= 0xFF000000;
+            }
+        }
+    }
+
+    return ret.convertToFormat (format);
+}
+
+// Returns <image> as unpremultiplied QImage::Format_ARGB32, the way
+// kpPNGWriter unpremultiplies it.
+static QImage Unpremultiplied (const QImage &image)
+{
+    if (image.format () != QImage::Format_ARGB32_Premultiplied) {
+        return image.convertToFormat (QImage::Format_ARGB32);
+    }
+
+    QImage ret (image.size (), QImage::Format_ARGB32);
+    for (int y = 0; y < image.height (); y++)
+    {
+        const auto *line = reinterpret_cast <const QRgb *> (image.constScanLine (y));
+        auto *retLine = reinterpret_cast <QRgb *> (ret.scanLine (y));
+        for (int x = 0; x < image.width (); x++) {
+            retLine [x] = qUnpremultiply (line [x]);
+        }
+    }
+
+    return ret;
+}
+
+// Writes <image> with kpPNGWriter and reads it back with Qt's PNG reader.
+static QImage RoundTrip (const QImage &image, int compressionLevel)
+{
+    QByteArray data;
+    QBuffer buffer (&data);
+    buffer.open (QIODevice::WriteOnly);
+    if (!kpPNGWriter::write (image, &buffer, compressionLevel)) {
+        return QImage ();
+    }
+    buffer.close ();
+
+    QImage ret;
+    ret.loadFromData (data, "PNG");
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+class kpPNGWriterTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void canWrite ();
+
+    void roundTrip_data ();
+    void roundTrip ();
+
+    void metaInfo ();
+};
+
+//---------------------------------------------------------------------
+
+void kpPNGWriterTest::canWrite ()
+{
+    QVERIFY (kpPNGWriter::canWrite (MakeImage (4, 4, QImage::Format_ARGB32)));
+    QVERIFY (kpPNGWriter::canWrite (MakeImage (4, 4, QImage::Format_RGB32)));
+    QVERIFY (kpPNGWriter::canWrite (MakeImage (4, 4, QImage::Format_ARGB32_Premultiplied)));
+
+    QVERIFY (!kpPNGWriter::canWrite (QImage ()));
+    QVERIFY (!kpPNGWriter::canWrite (MakeImage (4, 4, QImage::Format_RGB16)));
+    QVERIFY (!kpPNGWriter::canWrite (MakeImage (4, 4, QImage::Format_Indexed8)));
+}
+
+//---------------------------------------------------------------------
+
+void kpPNGWriterTest::roundTrip_data ()
+{
+    QTest::addColumn <QImage> ("image");
+    QTest::addColumn <int> ("compressionLevel");
+
+    QTest::newRow ("1x1") << MakeImage (1, 1, QImage::Format_ARGB32) << -1;
+    QTest::newRow ("one row") << MakeImage (5000, 1, QImage::Format_ARGB32) << -1;
+    QTest::newRow ("one column") << MakeImage (1, 5000, QImage::Format_RGB32) << -1;
+
+    // Big enough for many compressed blocks and more than one IDAT chunk.
+    QTest::newRow ("opaque") << MakeImage (900, 700, QImage::Format_RGB32) << -1;
+    QTest::newRow ("transparent") << MakeImage (900, 700, QImage::Format_ARGB32) << -1;
+    QTest::newRow ("premultiplied")
+        << MakeImage (900, 700, QImage::Format_ARGB32_Premultiplied) << -1;
+    QTest::newRow ("stored") << MakeImage (900, 700, QImage::Format_ARGB32) << 0;
+    QTest::newRow ("fastest") << MakeImage (900, 700, QImage::Format_ARGB32) << 1;
+    QTest::newRow ("smallest") << MakeImage (300, 200, QImage::Format_ARGB32) << 9;
+}
+
+void kpPNGWriterTest::roundTrip ()
+{
+    QFETCH (QImage, image);
+    QFETCH (int, compressionLevel);
+
+    const QImage actual = ::RoundTrip (image, compressionLevel);
+    QVERIFY (!actual.isNull ());
+    QCOMPARE (actual.size (), image.size ());
+    QCOMPARE (actual.hasAlphaChannel (), image.format () != QImage::Format_RGB32);
+
+    QCOMPARE (actual.convertToFormat (QImage::Format_ARGB32), ::Unpremultiplied (image));
+}
+
+//---------------------------------------------------------------------
+
+void kpPNGWriterTest::metaInfo ()
+{
+    QImage image = MakeImage (10, 10, QImage::Format_ARGB32);
+    image.setDotsPerMeterX (2835);
+    image.setDotsPerMeterY (5670);
+    image.setOffset (QPoint (12, 34));
+    image.setText (QStringLiteral ("Title"), QStringLiteral ("Latin-1 café"));
+    image.setText (QStringLiteral ("Comment"), QStringLiteral ("Not Latin-1 ✓"));
+
+    const QImage actual = ::RoundTrip (image, -1);
+    QVERIFY (!actual.isNull ());
+
+    QCOMPARE (actual.dotsPerMeterX (), 2835);
+    QCOMPARE (actual.dotsPerMeterY (), 5670);
+    QCOMPARE (actual.offset (), QPoint (12, 34));
+    QCOMPARE (actual.text (QStringLiteral ("Title")), image.text (QStringLiteral ("Title")));
+    QCOMPARE (actual.text (QStringLiteral ("Comment")), image.text (QStringLiteral ("Comment")));
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpPNGWriterTest)
+
+#include "kpPNGWriterTest.moc"
@@ -0,0 +1,197 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpPainter.h"
+
+#include <QColor>
+#include <QImage>
+#include <QList>
+#include <QPainter>
+#include <QPoint>
+#include <QRect>
+#include <QTest>
+#include <QVector>
+
+#include "generic/kpRandom.h"
+#include "imagelib/kpColor.h"
+
+
+// Replays the spray of kpPainter::sprayPoints() with a generator seeded with
+// <seed>, drawing each dot with QPainter::drawPoint(), like spraying always
+// used to.  Returns the bounding rectangle of the dots inside <image>.
+static QRect ReferenceSpray (QImage *image, const QList <QPoint> &points,
+        const QRgb color, int spraycanSize, quint32 seed)
+{
+    // The squares around a point, in the order sprayPoints() numbers them,
+    // and which of them are within the spraycan's circle.
+    const int radius = spraycanSize / 2;
+    QVector <QPoint> disc;
+    for (int dy = -radius; dy < spraycanSize - radius; dy++)
+    {
+        for (int dx = -radius; dx < spraycanSize - radius; dx++)
+        {
+            if (dx * dx + dy * dy <= radius * radius) {
+                disc.append (QPoint (dx, dy));
+            }
+        }
+    }
+
+    kpRandom random (seed);
+    QRect dirtyRect;
+
+    QPainter painter (image);
+    painter.setPen (QColor::fromRgba (color));
+
+    for (const auto &p : points)
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            const quint32 square = random.bounded (quint32 (spraycanSize * spraycanSize));
+            if (square >= quint32 (disc.size ())) {
+                continue;
+            }
+
+            const QPoint dot = p + disc [int (square)];
+            painter.drawPoint (dot);
+
+            if (image->rect ().contains (dot)) {
+                dirtyRect |= QRect (dot, dot);
+            }
+        }
+    }
+
+    return dirtyRect;
+}
+
+//---------------------------------------------------------------------
+
+class kpPainterTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void sprayPoints_data ();
+    void sprayPoints ();
+
+    void sprayPointsTransparent ();
+};
+
+//---------------------------------------------------------------------
+
+void kpPainterTest::sprayPoints_data ()
+{
+    QTest::addColumn <int> ("format");
+    QTest::addColumn <QRgb> ("color");
+    QTest::addColumn <int> ("spraycanSize");
+    QTest::addColumn <quint32> ("seed");
+
+    const QRgb opaque = qRgba (200, 30, 90, 255);
+    const QRgb translucent = qRgba (200, 30, 90, 100);
+
+    QTest::newRow ("opaque premultiplied")
+        << int (QImage::Format_ARGB32_Premultiplied) << opaque << 9 << 1u;
+    QTest::newRow ("opaque not premultiplied")
+        << int (QImage::Format_ARGB32) << opaque << 9 << 2u;
+    QTest::newRow ("opaque no alpha")
+        << int (QImage::Format_RGB32) << opaque << 17 << 3u;
+    QTest::newRow ("opaque size 1")
+        << int (QImage::Format_ARGB32_Premultiplied) << opaque << 1 << 4u;
+
+    // (the dots pile up on each other, so must be blended one by one)
+    QTest::newRow ("translucent premultiplied")
+        << int (QImage::Format_ARGB32_Premultiplied) << translucent << 9 << 5u;
+    QTest::newRow ("translucent not premultiplied")
+        << int (QImage::Format_ARGB32) << translucent << 4 << 6u;
+    QTest::newRow ("translucent no alpha")
+        << int (QImage::Format_RGB32) << translucent << 17 << 7u;
+}
+
+void kpPainterTest::sprayPoints ()
+{
+    QFETCH (int, format);
+    QFETCH (QRgb, color);
+    QFETCH (int, spraycanSize);
+    QFETCH (quint32, seed);
+
+    QImage original (40, 30, QImage::Format (format));
+    for (int y = 0; y < original.height (); y++)
+    {
+        for (int x = 0; x < original.width (); x++) {
+            original.setPixel (x, y, qRgba (x * 6, y * 8, 128, (x + y) % 3 ? 255 : 60));
+        }
+    }
+
+    // (some of the dots fall outside the image)
+    QList <QPoint> points;
+    points << QPoint (0, 0) << QPoint (20, 15) << QPoint (21, 15)
+           << QPoint (20, 15) << QPoint (39, 29) << QPoint (-3, 12);
+
+    QImage expected = original;
+    const QRect expectedDirtyRect = ::ReferenceSpray (&expected, points,
+        color, spraycanSize, seed);
+    QVERIFY (!expectedDirtyRect.isEmpty ());
+
+    QImage image = original;
+    kpRandom random (seed);
+    const QRect dirtyRect = kpPainter::sprayPoints (&image, points,
+        kpColor (color), spraycanSize, &random);
+
+    QCOMPARE (dirtyRect, expectedDirtyRect);
+    QCOMPARE (image.convertToFormat (QImage::Format_ARGB32),
+              expected.convertToFormat (QImage::Format_ARGB32));
+
+    // Replaying with the same seed sprays the same dots.
+    QImage again = original;
+    kpRandom sameRandom (seed);
+    QCOMPARE (kpPainter::sprayPoints (&again, points,
+                  kpColor (color), spraycanSize, &sameRandom),
+              dirtyRect);
+    QCOMPARE (again, image);
+}
+
+//---------------------------------------------------------------------
+
+void kpPainterTest::sprayPointsTransparent ()
+{
+    QImage image (10, 10, QImage::Format_ARGB32_Premultiplied);
+    image.fill (qRgba (1, 2, 3, 255));
+    const QImage original = image;
+
+    kpRandom random (1);
+    const QRect dirtyRect = kpPainter::sprayPoints (&image,
+        QList <QPoint> () << QPoint (5, 5), kpColor::Transparent, 5, &random);
+
+    QVERIFY (dirtyRect.isEmpty ());
+    QCOMPARE (image, original);
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpPainterTest)
+
+#include "kpPainterTest.moc"
@@ -0,0 +1,200 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/kpPixelReplicator.h"
+
+#include <QColor>
+#include <QImage>
+#include <QPainter>
+#include <QPoint>
+#include <QRect>
+#include <QString>
+#include <QTest>
+
+
+// Returns <a> / <b> rounded towards negative infinity, for <b> > 0.
+static int FloorDiv (int a, int b)
+{
+    return (a >= 0) ? (a / b) : -((-a + b - 1) / b);
+}
+
+// Returns a <width>x<height> image with every pixel different, some of
+// them translucent and some transparent.
+static QImage MakeDocImage (int width, int height)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const int alpha = ((x + y) % 5 == 0) ? 0 :
+                              ((x + y) % 5 == 1) ? 100 : 255;
+            ret.setPixel (x, y, qRgba (x * 13 % 256, y * 29 % 256, (x ^ y) * 7 % 256, alpha));
+        }
+    }
+
+    return ret.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+}
+
+// Returns what kpView::paintEventDrawDoc_Unclipped() used to draw for
+// <viewRect> at non-integer zoom levels, followed by what
+// kpView::paintEventDrawGridLines() draws, onto a transparent image.
+static QImage PaintWithQPainter (const QImage &docImage, const QRect &docRect,
+        const QRect &viewRect, const QPoint &origin,
+        int hzoom, int vzoom, bool withGridLines)
+{
+    QImage ret (viewRect.size (), QImage::Format_ARGB32_Premultiplied);
+    ret.fill (0);
+
+    QPainter painter (&ret);
+    painter.setCompositionMode (QPainter::CompositionMode_Source);
+
+    painter.translate (-viewRect.x (), -viewRect.y ());
+    painter.save ();
+    painter.translate (origin.x (), origin.y ());
+    painter.scale (hzoom, vzoom);
+    painter.drawImage (docRect, docImage);
+    painter.restore ();
+
+    if (withGridLines)
+    {
+        painter.setPen (Qt::gray);
+
+        int starty = viewRect.top ();
+        if (starty % vzoom) {
+            starty = (starty + vzoom) / vzoom * vzoom;
+        }
+        for (int y = starty; y <= viewRect.bottom (); y += vzoom) {
+            painter.drawLine (viewRect.left (), y, viewRect.right (), y);
+        }
+
+        int startx = viewRect.left ();
+        if (startx % hzoom) {
+            startx = (startx + hzoom) / hzoom * hzoom;
+        }
+        for (int x = startx; x <= viewRect.right (); x += hzoom) {
+            painter.drawLine (x, viewRect.top (), x, viewRect.bottom ());
+        }
+    }
+
+    painter.end ();
+    return ret;
+}
+
+//---------------------------------------------------------------------
+
+class kpPixelReplicatorTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void sameAsQPainter_data ();
+    void sameAsQPainter ();
+};
+
+//---------------------------------------------------------------------
+
+void kpPixelReplicatorTest::sameAsQPainter_data ()
+{
+    QTest::addColumn <QRect> ("viewRect");
+    QTest::addColumn <QPoint> ("origin");
+    QTest::addColumn <int> ("hzoom");
+    QTest::addColumn <int> ("vzoom");
+    QTest::addColumn <bool> ("withGridLines");
+
+    for (int grid = 0; grid < 2; grid++)
+    {
+        const bool withGridLines = grid;
+        const char *suffix = withGridLines ? " grid" : "";
+
+        QTest::newRow (qPrintable (QStringLiteral ("2x whole%1").arg (suffix)))
+            << QRect (0, 0, 80, 60) << QPoint (0, 0) << 2 << 2 << withGridLines;
+        QTest::newRow (qPrintable (QStringLiteral ("3x5 unaligned%1").arg (suffix)))
+            << QRect (7, 4, 61, 53) << QPoint (0, 0) << 3 << 5 << withGridLines;
+        QTest::newRow (qPrintable (QStringLiteral ("8x in a doc pixel%1").arg (suffix)))
+            << QRect (9, 10, 5, 3) << QPoint (0, 0) << 8 << 8 << withGridLines;
+
+        // (the view is bigger than the document, so some rows and columns
+        //  are outside it)
+        QTest::newRow (qPrintable (QStringLiteral ("4x past the document%1").arg (suffix)))
+            << QRect (0, 0, 200, 180) << QPoint (13, 9) << 4 << 4 << withGridLines;
+        QTest::newRow (qPrintable (QStringLiteral ("2x3 past the document%1").arg (suffix)))
+            << QRect (30, 20, 90, 200) << QPoint (5, 7) << 2 << 3 << withGridLines;
+
+        // (taller than a kpParallel band)
+        QTest::newRow (qPrintable (QStringLiteral ("2x big%1").arg (suffix)))
+            << QRect (1, 1, 400, 900) << QPoint (0, 0) << 2 << 2 << withGridLines;
+    }
+}
+
+void kpPixelReplicatorTest::sameAsQPainter ()
+{
+    QFETCH (QRect, viewRect);
+    QFETCH (QPoint, origin);
+    QFETCH (int, hzoom);
+    QFETCH (int, vzoom);
+    QFETCH (bool, withGridLines);
+
+    const QImage doc = ::MakeDocImage (41, 33 * 14);
+
+    // Like kpView::paintEventGetDocRect().
+    const QRect docRect = QRect (
+        QPoint (::FloorDiv (viewRect.left () - origin.x (), hzoom),
+                ::FloorDiv (viewRect.top () - origin.y (), vzoom)),
+        QPoint (::FloorDiv (viewRect.right () - origin.x (), hzoom),
+                ::FloorDiv (viewRect.bottom () - origin.y (), vzoom)))
+            .intersected (doc.rect ());
+    QVERIFY (!docRect.isEmpty ());
+    const QImage docImage = doc.copy (docRect);
+
+    const QImage expected = ::PaintWithQPainter (docImage, docRect,
+        viewRect, origin, hzoom, vzoom, withGridLines);
+    const QImage actual = kpPixelReplicator::replicate (docImage, docRect,
+        viewRect, origin, hzoom, vzoom, withGridLines);
+
+    QCOMPARE (actual.size (), expected.size ());
+    for (int y = 0; y < expected.height (); y++)
+    {
+        for (int x = 0; x < expected.width (); x++)
+        {
+            if (actual.pixel (x, y) != expected.pixel (x, y))
+            {
+                QFAIL (qPrintable (QStringLiteral ("(%1,%2): got %3, expected %4")
+                    .arg (x).arg (y)
+                    .arg (actual.pixel (x, y), 8, 16, QLatin1Char ('0'))
+                    .arg (expected.pixel (x, y), 8, 16, QLatin1Char ('0'))));
+            }
+        }
+    }
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpPixelReplicatorTest)
+
+#include "kpPixelReplicatorTest.moc"
@@ -0,0 +1,222 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "pixmapfx/kpPixmapFX.h"
+
+#include <QDebug>
+#include <QImage>
+#include <QRect>
+#include <QRegion>
+#include <QTest>
+
+
+static const int T = kpPixmapFX::ChangedRegionTileSize;
+
+// Returns the tiles in which <oldImage> and <newImage> differ, worked out
+// a pixel at a time.
+static QRegion ReferenceChangedRegion (const QImage &oldImage, const QImage &newImage)
+{
+    QRegion ret;
+    for (int tileY = 0; tileY < newImage.height (); tileY += T)
+    {
+        for (int tileX = 0; tileX < newImage.width (); tileX += T)
+        {
+            const QRect tile = QRect (tileX, tileY, T, T) & newImage.rect ();
+
+            bool changed = false;
+            for (int y = tile.top (); y <= tile.bottom () && !changed; y++)
+            {
+                for (int x = tile.left (); x <= tile.right () && !changed; x++)
+                {
+                    changed = newImage.depth () <= 8 ?
+                        oldImage.pixelIndex (x, y) != newImage.pixelIndex (x, y) :
+                        oldImage.pixel (x, y) != newImage.pixel (x, y);
+                }
+            }
+
+            if (changed) {
+                ret += tile;
+            }
+        }
+    }
+
+    return ret;
+}
+
+// Returns a <width>x<height> image of <format>, with a pattern in it.
+static QImage MakeImage (int width, int height, QImage::Format format)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) {
+            ret.setPixel (x, y, qRgba (x % 256, y % 256, ((x / 3) % 2) * 255, 255));
+        }
+    }
+
+    return ret.convertToFormat (format, Qt::ThresholdDither);
+}
+
+// Returns <image> with pixel (<x>, <y>) changed.
+static QImage ChangePixel (const QImage &image, int x, int y)
+{
+    QImage ret = image;
+    if (ret.depth () <= 8) {
+        ret.setPixel (x, y, ret.pixelIndex (x, y) ? 0 : 1);
+    }
+    else {
+        ret.setPixel (x, y, ret.pixel (x, y) ^ 0x00800000);
+    }
+
+    return ret;
+}
+
+static bool SameRegion (const QRegion &a, const QRegion &b)
+{
+    return a.xored (b).isEmpty ();
+}
+
+//---------------------------------------------------------------------
+
+class kpPixmapFXTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void changedRegionUnchanged ();
+    void changedRegionDifferentImages ();
+
+    void changedRegion_data ();
+    void changedRegion ();
+};
+
+//---------------------------------------------------------------------
+
+void kpPixmapFXTest::changedRegionUnchanged ()
+{
+    const QImage image = MakeImage (300, 200, QImage::Format_ARGB32_Premultiplied);
+
+    // Sharing the same pixels.
+    QVERIFY (kpPixmapFX::changedRegion (image, image).isEmpty ());
+
+    // Equal, but not shared.
+    const QImage copy = image.copy ();
+    QVERIFY (copy.cacheKey () != image.cacheKey ());
+    QVERIFY (kpPixmapFX::changedRegion (image, copy).isEmpty ());
+}
+
+void kpPixmapFXTest::changedRegionDifferentImages ()
+{
+    const QImage image = MakeImage (100, 50, QImage::Format_ARGB32_Premultiplied);
+
+    // Different sizes -- both images.
+    const QImage bigger = MakeImage (80, 90, QImage::Format_ARGB32_Premultiplied);
+    QVERIFY (::SameRegion (kpPixmapFX::changedRegion (image, bigger),
+                           QRegion (0, 0, 100, 50) + QRegion (0, 0, 80, 90)));
+
+    // Different formats.
+    const QImage rgb32 = image.convertToFormat (QImage::Format_RGB32);
+    QVERIFY (::SameRegion (kpPixmapFX::changedRegion (image, rgb32),
+                           QRegion (image.rect ())));
+
+    // Different color tables.
+    const QImage indexed = MakeImage (100, 50, QImage::Format_Indexed8);
+    QImage recolored = indexed;
+    recolored.setColor (0, qRgb (1, 2, 3) ^ indexed.color (0));
+    QVERIFY (::SameRegion (kpPixmapFX::changedRegion (indexed, recolored),
+                           QRegion (indexed.rect ())));
+}
+
+//---------------------------------------------------------------------
+
+void kpPixmapFXTest::changedRegion_data ()
+{
+    QTest::addColumn <QImage> ("oldImage");
+    QTest::addColumn <QImage> ("newImage");
+    QTest::addColumn <QRegion> ("expected");
+
+    const QImage image = MakeImage (300, 200, QImage::Format_ARGB32_Premultiplied);
+
+    QTest::newRow ("one pixel")
+        << image << ChangePixel (image, 70, 130)
+        << QRegion (T, 2 * T, T, T);
+    QTest::newRow ("first pixel")
+        << image << ChangePixel (image, 0, 0)
+        << QRegion (0, 0, T, T);
+    QTest::newRow ("last pixel, in a partial tile")
+        << image << ChangePixel (image, 299, 199)
+        << QRegion (4 * T, 3 * T, 300 - 4 * T, 200 - 3 * T);
+    QTest::newRow ("adjacent tiles")
+        << image << ChangePixel (ChangePixel (image, T - 1, 5), T, 6)
+        << QRegion (0, 0, 2 * T, T);
+    QTest::newRow ("scattered tiles")
+        << image
+        << ChangePixel (ChangePixel (ChangePixel (image, 1, 1), 200, 1), 1, 199)
+        << QRegion (0, 0, T, T) + QRegion (3 * T, 0, T, T) + QRegion (0, 3 * T, T, 200 - 3 * T);
+
+    const QImage indexed = MakeImage (300, 200, QImage::Format_Indexed8);
+    QTest::newRow ("8-bit")
+        << indexed << ChangePixel (ChangePixel (indexed, 150, 70), 299, 0)
+        << QRegion (2 * T, T, T, T) + QRegion (4 * T, 0, 300 - 4 * T, T);
+
+    const QImage mono = MakeImage (203, 130, QImage::Format_MonoLSB);
+    QTest::newRow ("1-bit")
+        << mono << ChangePixel (ChangePixel (mono, 127, 0), 202, 129)
+        << QRegion (T, 0, T, T) + QRegion (3 * T, 2 * T, 203 - 3 * T, 130 - 2 * T);
+
+    const QImage rgb16 = MakeImage (150, 150, QImage::Format_RGB16);
+    QTest::newRow ("16-bit")
+        << rgb16 << ChangePixel (rgb16, 64, 64)
+        << QRegion (T, T, T, T);
+}
+
+void kpPixmapFXTest::changedRegion ()
+{
+    QFETCH (QImage, oldImage);
+    QFETCH (QImage, newImage);
+    QFETCH (QRegion, expected);
+
+    // (check the test itself)
+    QVERIFY (::SameRegion (::ReferenceChangedRegion (oldImage, newImage), expected));
+
+    const QRegion actual = kpPixmapFX::changedRegion (oldImage, newImage);
+    if (!::SameRegion (actual, expected))
+    {
+        qWarning () << "actual=" << actual << "expected=" << expected;
+        QFAIL ("wrong changed region");
+    }
+
+    // It doesn't matter which way round the images are.
+    QVERIFY (::SameRegion (kpPixmapFX::changedRegion (newImage, oldImage), expected));
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpPixmapFXTest)
+
+#include "kpPixmapFXTest.moc"
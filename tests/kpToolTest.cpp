@@ -0,0 +1,222 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "tools/kpTool.h"
+
+#include <QList>
+#include <QMouseEvent>
+#include <QPoint>
+#include <QStandardPaths>
+#include <QTest>
+
+#include "environments/tools/kpToolEnvironment.h"
+#include "mainWindow/kpMainWindow.h"
+#include "views/kpView.h"
+#include "views/manager/kpViewManager.h"
+
+
+// A tool that batches its draw()s, like the Pen, and records them.
+class kpToolTestTool : public kpTool
+{
+public:
+    explicit kpToolTestTool (kpToolEnvironment *environ)
+        : kpTool (QStringLiteral ("Test"), QStringLiteral ("Test tool"), 0,
+                  environ, nullptr, QStringLiteral ("tool_test"))
+    {
+    }
+
+    struct Draw
+    {
+        QPoint thisPoint, lastPoint;
+        bool shiftPressed;
+    };
+    QList <Draw> draws;
+
+    void pressShift () { setShiftPressed (true); }
+
+protected:
+    bool careAboutModifierState () const override { return true; }
+    bool wantsBatchedDraw () const override { return true; }
+
+    void draw (const QPoint &thisPoint, const QPoint &lastPoint,
+               const QRect &/*normalizedRect*/) override
+    {
+        draws.append ({thisPoint, lastPoint, shiftPressed ()});
+    }
+};
+
+//---------------------------------------------------------------------
+
+class kpToolTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void initTestCase ();
+    void cleanupTestCase ();
+
+    void init ();
+    void cleanup ();
+
+    void modifierChangeDrawsQueuedPointsFirst ();
+    void somethingBelowTheCursorChangedDrawsQueuedPointsFirst ();
+
+private:
+    // Presses the left mouse button at <viewPoints> [0] and drags through
+    // the rest, without returning to the event loop (so that the points
+    // stay queued).  Returns the document points.
+    QList <QPoint> pressAndDrag (const QList <QPoint> &viewPoints);
+    void release (const QPoint &viewPoint);
+
+    kpMainWindow *m_mainWindow{nullptr};
+    kpToolEnvironment *m_toolEnvironment{nullptr};
+    kpView *m_view{nullptr};
+    kpToolTestTool *m_tool{nullptr};
+};
+
+//---------------------------------------------------------------------
+
+void kpToolTest::initTestCase ()
+{
+    QStandardPaths::setTestModeEnabled (true);
+
+    m_mainWindow = new kpMainWindow ();
+    m_toolEnvironment = new kpToolEnvironment (m_mainWindow);
+
+    m_view = m_mainWindow->findChild <kpView *> (QStringLiteral ("mainView"));
+    QVERIFY (m_view);
+    m_mainWindow->viewManager ()->setViewUnderCursor (m_view);
+}
+
+void kpToolTest::cleanupTestCase ()
+{
+    delete m_toolEnvironment;
+    delete m_mainWindow;
+}
+
+void kpToolTest::init ()
+{
+    m_tool = new kpToolTestTool (m_toolEnvironment);
+}
+
+void kpToolTest::cleanup ()
+{
+    delete m_tool;
+    m_tool = nullptr;
+}
+
+//---------------------------------------------------------------------
+
+QList <QPoint> kpToolTest::pressAndDrag (const QList <QPoint> &viewPoints)
+{
+    QList <QPoint> docPoints;
+    for (const auto &viewPoint : viewPoints) {
+        docPoints.append (m_view->transformViewToDoc (viewPoint));
+    }
+
+    QMouseEvent press (QEvent::MouseButtonPress, viewPoints [0],
+        Qt::LeftButton, Qt::LeftButton, Qt::NoModifier);
+    m_tool->mousePressEvent (&press);
+
+    for (int i = 1; i < viewPoints.size (); i++)
+    {
+        QMouseEvent move (QEvent::MouseMove, viewPoints [i],
+            Qt::NoButton, Qt::LeftButton, Qt::NoModifier);
+        m_tool->mouseMoveEvent (&move);
+    }
+
+    return docPoints;
+}
+
+void kpToolTest::release (const QPoint &viewPoint)
+{
+    QMouseEvent release (QEvent::MouseButtonRelease, viewPoint,
+        Qt::LeftButton, Qt::NoButton, Qt::NoModifier);
+    m_tool->mouseReleaseEvent (&release);
+}
+
+//---------------------------------------------------------------------
+
+void kpToolTest::modifierChangeDrawsQueuedPointsFirst ()
+{
+    const QList <QPoint> points = pressAndDrag (QList <QPoint> ()
+        << QPoint (10, 10) << QPoint (11, 10) << QPoint (12, 11) << QPoint (13, 12));
+
+    // Only the press has been drawn -- the moves are queued.
+    QCOMPARE (m_tool->draws.size (), 1);
+    QCOMPARE (m_tool->draws [0].thisPoint, points [0]);
+
+    m_tool->pressShift ();
+
+    // The queued points, in order and with the old modifiers, then the
+    // redraw for the new modifiers.
+    QCOMPARE (m_tool->draws.size (), points.size () + 1);
+    for (int i = 1; i < points.size (); i++)
+    {
+        QCOMPARE (m_tool->draws [i].thisPoint, points [i]);
+        QCOMPARE (m_tool->draws [i].lastPoint, points [i - 1]);
+        QVERIFY (!m_tool->draws [i].shiftPressed);
+    }
+
+    const auto &last = m_tool->draws.last ();
+    QCOMPARE (last.thisPoint, points.last ());
+    QCOMPARE (last.lastPoint, points.last ());
+    QVERIFY (last.shiftPressed);
+
+    release (QPoint (13, 12));
+}
+
+void kpToolTest::somethingBelowTheCursorChangedDrawsQueuedPointsFirst ()
+{
+    const QList <QPoint> points = pressAndDrag (QList <QPoint> ()
+        << QPoint (20, 20) << QPoint (21, 22) << QPoint (23, 24));
+    QCOMPARE (m_tool->draws.size (), 1);
+
+    m_tool->somethingBelowTheCursorChanged ();
+
+    // The queued points must come first.  (Whether it then draws to the
+    // cursor depends on where the -- possibly fake -- cursor is.)
+    QVERIFY (m_tool->draws.size () >= points.size ());
+    for (int i = 1; i < points.size (); i++)
+    {
+        QCOMPARE (m_tool->draws [i].thisPoint, points [i]);
+        QCOMPARE (m_tool->draws [i].lastPoint, points [i - 1]);
+    }
+
+    if (m_tool->draws.size () > points.size ()) {
+        QCOMPARE (m_tool->draws [points.size ()].lastPoint, points.last ());
+    }
+
+    release (QPoint (23, 24));
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_MAIN (kpToolTest)
+
+#include "kpToolTest.moc"
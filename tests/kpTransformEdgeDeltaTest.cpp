@@ -0,0 +1,142 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/transforms/kpTransformEdgeDelta.h"
+
+#include <cstring>
+
+#include <QImage>
+#include <QRect>
+#include <QTest>
+
+
+// Returns a <width>x<height> image, with every pixel different and some of
+// them translucent.
+static QImage MakeImage (int width, int height, QImage::Format format)
+{
+    QImage ret (width, height, QImage::Format_ARGB32);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++)
+        {
+            const int alpha = (x % 4 == 3) ? (y * 16) % 256 : 255;
+            ret.setPixel (x, y, qRgba (x % 256, y % 256, (x + y) % 256, alpha));
+        }
+    }
+
+    return ret.convertToFormat (format);
+}
+
+//---------------------------------------------------------------------
+
+class kpTransformEdgeDeltaTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void nullDelta ();
+
+    void restore_data ();
+    void restore ();
+};
+
+//---------------------------------------------------------------------
+
+void kpTransformEdgeDeltaTest::nullDelta ()
+{
+    QVERIFY (kpTransformEdgeDelta ().isNull ());
+    QCOMPARE (kpTransformEdgeDelta ().size (), kpCommandSize::SizeType (0));
+}
+
+//---------------------------------------------------------------------
+
+void kpTransformEdgeDeltaTest::restore_data ()
+{
+    QTest::addColumn <QImage> ("oldImage");
+    QTest::addColumn <QRect> ("keptRect");
+    QTest::addColumn <QRect> ("expectedKeptRect");
+
+    const QImage image = MakeImage (120, 90, QImage::Format_ARGB32_Premultiplied);
+
+    QTest::newRow ("middle") << image << QRect (10, 20, 50, 30) << QRect (10, 20, 50, 30);
+    QTest::newRow ("top left") << image << QRect (0, 0, 100, 80) << QRect (0, 0, 100, 80);
+    QTest::newRow ("bottom right") << image << QRect (1, 1, 119, 89) << QRect (1, 1, 119, 89);
+    QTest::newRow ("top strip only") << image << QRect (0, 5, 120, 85) << QRect (0, 5, 120, 85);
+    QTest::newRow ("right strip only") << image << QRect (0, 0, 119, 90) << QRect (0, 0, 119, 90);
+    QTest::newRow ("one pixel") << image << QRect (60, 45, 1, 1) << QRect (60, 45, 1, 1);
+    QTest::newRow ("everything") << image << image.rect () << image.rect ();
+    QTest::newRow ("clipped") << image << QRect (-10, 30, 200, 200) << QRect (0, 30, 120, 60);
+    QTest::newRow ("nothing") << image << QRect (200, 200, 10, 10) << QRect ();
+    QTest::newRow ("not premultiplied")
+        << MakeImage (40, 30, QImage::Format_ARGB32) << QRect (5, 5, 10, 10)
+        << QRect (5, 5, 10, 10);
+}
+
+void kpTransformEdgeDeltaTest::restore ()
+{
+    QFETCH (QImage, oldImage);
+    QFETCH (QRect, keptRect);
+    QFETCH (QRect, expectedKeptRect);
+
+    const kpTransformEdgeDelta delta (oldImage, keptRect);
+    QVERIFY (!delta.isNull ());
+    QCOMPARE (delta.oldSize (), oldImage.size ());
+    QCOMPARE (delta.keptRect (), expectedKeptRect);
+
+    // Only the strips outside the kept rectangle are stored.
+    const int keptArea = expectedKeptRect.width () * expectedKeptRect.height ();
+    QCOMPARE (delta.size (),
+        kpCommandSize::SizeType (oldImage.width () * oldImage.height () - keptArea) *
+            oldImage.depth () / 8);
+
+    // e.g. what a crop leaves behind, with something else to its right and
+    // bottom that restore() must ignore.
+    QImage keptImage (expectedKeptRect.width () + 3, expectedKeptRect.height () + 2,
+                      QImage::Format_ARGB32_Premultiplied);
+    keptImage.fill (qRgba (255, 0, 0, 255));
+    if (!expectedKeptRect.isEmpty ())
+    {
+        const QImage kept = oldImage.copy (expectedKeptRect)
+            .convertToFormat (QImage::Format_ARGB32_Premultiplied);
+        for (int y = 0; y < kept.height (); y++)
+        {
+            std::memcpy (keptImage.scanLine (y), kept.constScanLine (y),
+                         size_t (kept.width ()) * 4);
+        }
+    }
+
+    const QImage restored = delta.restore (keptImage);
+    QCOMPARE (restored.format (), QImage::Format_ARGB32_Premultiplied);
+    QCOMPARE (restored, oldImage.convertToFormat (QImage::Format_ARGB32_Premultiplied));
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpTransformEdgeDeltaTest)
+
+#include "kpTransformEdgeDeltaTest.moc"
@@ -0,0 +1,252 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#include "imagelib/transforms/kpTransformWarp.h"
+
+#include <QImage>
+#include <QPainter>
+#include <QPoint>
+#include <QSize>
+#include <QString>
+#include <QTest>
+#include <QTransform>
+
+#include "pixmapfx/kpPixmapFX.h"
+
+
+// Returns a <width>x<height> opaque image with every pixel different
+// (for <width>, <height> <= 256).
+static QImage MakeSourceImage (int width, int height)
+{
+    QImage ret (width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < height; y++)
+    {
+        for (int x = 0; x < width; x++) {
+            ret.setPixel (x, y, qRgba (x, y, (x * 7 + y * 13) % 256, 255));
+        }
+    }
+
+    return ret;
+}
+
+// Returns what kpPixmapFX's TransformPixmap() used to draw before it used
+// kpTransformWarp, onto a transparent image.
+static QImage PaintWithQPainter (const QImage &src, const QTransform &matrix,
+                                 const QSize &size)
+{
+    QImage ret (size, QImage::Format_ARGB32_Premultiplied);
+    ret.fill (0);
+
+    QPainter painter (&ret);
+    painter.setCompositionMode (QPainter::CompositionMode_Source);
+    painter.setWorldTransform (matrix);
+    painter.drawImage (QPoint (0, 0), src);
+    painter.end ();
+
+    return ret;
+}
+
+// Returns whether <rgb> is one of the pixels of <image> at, or next to, (<x>,<y>).
+static bool IsInNeighbourhood (const QImage &image, int x, int y, QRgb rgb)
+{
+    for (int dy = -1; dy <= 1; dy++)
+    {
+        for (int dx = -1; dx <= 1; dx++)
+        {
+            if (image.valid (x + dx, y + dy) && image.pixel (x + dx, y + dy) == rgb) {
+                return true;
+            }
+        }
+    }
+
+    return false;
+}
+
+// Checks that kpTransformWarp::warp() draws <src> with <matrix> the way
+// QPainter does.
+//
+// For multiples of 90 degrees, every pixel centre maps back onto the
+// middle of a source pixel so the output must be identical.  Otherwise,
+// QPainter samples in fixed point and fills the edges of the transformed
+// image with its own rasterizer, so a pixel centre that maps to (almost)
+// exactly a source pixel boundary may pick the other source pixel, or the
+// background at the edges.  Such a pixel must still come from right next
+// to where QPainter put it, and there may only be a few of them.
+static void CompareWithQPainter (const QImage &src, const QTransform &matrix,
+                                 bool exact)
+{
+    const QSize size = matrix.mapRect (src.rect ()).size ();
+
+    const QImage expected = ::PaintWithQPainter (src, matrix, size);
+
+    QImage actual (size, QImage::Format_ARGB32_Premultiplied);
+    actual.fill (0);
+    kpTransformWarp::warp (&actual, src, matrix);
+
+    int mismatches = 0;
+    for (int y = 0; y < expected.height (); y++)
+    {
+        for (int x = 0; x < expected.width (); x++)
+        {
+            const QRgb rgb = actual.pixel (x, y);
+            if (rgb == expected.pixel (x, y)) {
+                continue;
+            }
+
+            mismatches++;
+            if (exact || !::IsInNeighbourhood (expected, x, y, rgb))
+            {
+                QFAIL (qPrintable (QStringLiteral ("(%1,%2): got %3, expected %4")
+                    .arg (x).arg (y)
+                    .arg (rgb, 8, 16, QLatin1Char ('0'))
+                    .arg (expected.pixel (x, y), 8, 16, QLatin1Char ('0'))));
+            }
+        }
+    }
+
+    // (the edges, plus 1% for the inside)
+    const int maxMismatches = 2 * (size.width () + size.height ()) +
+                              size.width () * size.height () / 100;
+    QVERIFY2 (mismatches <= maxMismatches,
+        qPrintable (QStringLiteral ("%1 pixels differ, expected at most %2")
+            .arg (mismatches).arg (maxMismatches)));
+}
+
+//---------------------------------------------------------------------
+
+class kpTransformWarpTest : public QObject
+{
+Q_OBJECT
+
+private slots:
+    void rotate_data ();
+    void rotate ();
+
+    void skew_data ();
+    void skew ();
+
+    void leavesUncoveredPixelsAlone ();
+};
+
+//---------------------------------------------------------------------
+
+void kpTransformWarpTest::rotate_data ()
+{
+    QTest::addColumn <int> ("width");
+    QTest::addColumn <int> ("height");
+    QTest::addColumn <double> ("angle");
+
+    // (odd sizes, a single row or column, and bigger than a kpTransformWarp
+    //  tile)
+    const QSize sizes [] = {QSize (37, 23), QSize (1, 9), QSize (9, 1), QSize (131, 70)};
+    const double angles [] = {90, 180, 270, -90, 30, 45, -17, 123.4};
+
+    for (const QSize &size : sizes)
+    {
+        for (const double angle : angles)
+        {
+            QTest::newRow (qPrintable (QStringLiteral ("%1x%2 %3")
+                    .arg (size.width ()).arg (size.height ()).arg (angle)))
+                << size.width () << size.height () << angle;
+        }
+    }
+}
+
+void kpTransformWarpTest::rotate ()
+{
+    QFETCH (int, width);
+    QFETCH (int, height);
+    QFETCH (double, angle);
+
+    const QImage src = ::MakeSourceImage (width, height);
+    ::CompareWithQPainter (src, kpPixmapFX::rotateMatrix (src, angle),
+        kpPixmapFX::isLosslessRotation (angle));
+}
+
+//---------------------------------------------------------------------
+
+void kpTransformWarpTest::skew_data ()
+{
+    QTest::addColumn <int> ("width");
+    QTest::addColumn <int> ("height");
+    QTest::addColumn <double> ("hangle");
+    QTest::addColumn <double> ("vangle");
+
+    const QSize sizes [] = {QSize (37, 23), QSize (1, 9), QSize (70, 3), QSize (131, 70)};
+    const double angles [][2] = {{30, 0}, {0, 20}, {-45, 0}, {0, -33}, {-20, 10}, {15, 15}};
+
+    for (const QSize &size : sizes)
+    {
+        for (const auto &hv : angles)
+        {
+            QTest::newRow (qPrintable (QStringLiteral ("%1x%2 %3,%4")
+                    .arg (size.width ()).arg (size.height ())
+                    .arg (hv [0]).arg (hv [1])))
+                << size.width () << size.height () << hv [0] << hv [1];
+        }
+    }
+}
+
+void kpTransformWarpTest::skew ()
+{
+    QFETCH (int, width);
+    QFETCH (int, height);
+    QFETCH (double, hangle);
+    QFETCH (double, vangle);
+
+    const QImage src = ::MakeSourceImage (width, height);
+    ::CompareWithQPainter (src, kpPixmapFX::skewMatrix (src, hangle, vangle),
+        false/*not exact*/);
+}
+
+//---------------------------------------------------------------------
+
+void kpTransformWarpTest::leavesUncoveredPixelsAlone ()
+{
+    const QImage src = ::MakeSourceImage (20, 20);
+    const QTransform matrix = kpPixmapFX::rotateMatrix (src, 45);
+
+    QImage dest (matrix.mapRect (src.rect ()).size (),
+                 QImage::Format_ARGB32_Premultiplied);
+    const QRgb background = qRgba (255, 0, 255, 255);
+    dest.fill (background);
+    kpTransformWarp::warp (&dest, src, matrix);
+
+    // (the corners are outside the rotated square)
+    QCOMPARE (dest.pixel (0, 0), background);
+    QCOMPARE (dest.pixel (dest.width () - 1, dest.height () - 1), background);
+
+    // (the middle is covered)
+    QVERIFY (dest.pixel (dest.width () / 2, dest.height () / 2) != background);
+}
+
+//---------------------------------------------------------------------
+
+
+QTEST_GUILESS_MAIN (kpTransformWarpTest)
+
+#include "kpTransformWarpTest.moc"
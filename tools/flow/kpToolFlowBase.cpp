@@ -290,6 +290,22 @@ void kpToolFlowBase::draw (const QPoint &thisPoint, const QPoint &lastPoint, con
 
 //---------------------------------------------------------------------
 
+// virtual
+void kpToolFlowBase::drawPolyline (const QList <QPoint> &points, const QPoint &lastPoint)
+{
+    // Each draw() would otherwise repaint the views immediately.  Instead,
+    // collect the dirty areas and repaint them (immediately) at the end.
+    viewManager ()->setFastUpdates ();
+    viewManager ()->setQueueUpdates ();
+    {
+        kpTool::drawPolyline (points, lastPoint);
+    }
+    viewManager ()->restoreQueueUpdates ();
+    viewManager ()->restoreFastUpdates ();
+}
+
+//---------------------------------------------------------------------
+
 // virtual
 void kpToolFlowBase::cancelShape ()
 {
@@ -75,6 +75,11 @@ class kpToolFlowBase : public kpTool
 
     virtual bool drawShouldProceed(const QPoint & /*thisPoint*/, const QPoint & /*lastPoint*/, const QRect & /*normalizedRect*/) { return true; }
     void draw(const QPoint &thisPoint, const QPoint &lastPoint, const QRect &normalizedRect) override;
+
+    bool wantsBatchedDraw() const override { return true; }
+    // Updates the views once for all of <points>.
+    void drawPolyline(const QList<QPoint> &points, const QPoint &lastPoint) override;
+
     void cancelShape() override;
     void releasedAllButtons() override;
     void endDraw(const QPoint &, const QRect &) override;
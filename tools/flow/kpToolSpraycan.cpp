@@ -41,6 +41,7 @@
 #include "views/kpView.h"
 #include "views/manager/kpViewManager.h"
 
+#include <algorithm>
 #include <cstdlib>
 
 #include "kpLogCategories.h"
@@ -108,6 +109,9 @@ void kpToolSpraycan::beginDraw ()
 
     kpToolFlowBase::beginDraw ();
 
+    // Make the stroke reproducible from the command's seed.
+    m_random = kpRandom (currentCommand ()->seed ());
+
     // We draw even if the user doesn't move the mouse.
     // We still timeout-draw even if the user _does_ move the mouse.
     m_timer->start ();
@@ -127,7 +131,17 @@ QRect kpToolSpraycan::drawLineWithProbability (const QPoint &thisPoint,
 
     QList <QPoint> docPoints = kpPainter::interpolatePoints (lastPoint, thisPoint,
         false/*no need for cardinally adjacency points*/,
-        probability);
+        1.0/*select them below, with the stroke's generator*/);
+    if (probability < 1.0)
+    {
+        const auto probabilityTimes1000 = quint32 (qRound (probability * 1000));
+        docPoints.erase (std::remove_if (docPoints.begin (), docPoints.end (),
+            [this, probabilityTimes1000] (const QPoint &)
+            {
+                return m_random.bounded (1000) >= probabilityTimes1000;
+            }),
+            docPoints.end ());
+    }
 #if DEBUG_KP_TOOL_SPRAYCAN
     qCDebug(kpLogTools) << "\tdocPoints=" << docPoints;
 #endif
@@ -155,18 +169,24 @@ QRect kpToolSpraycan::drawLineWithProbability (const QPoint &thisPoint,
     for (const auto &dp : docPoints)
         imagePoints.append (dp - docRect.topLeft ());
 
-    kpPainter::sprayPoints (&image,
+    const QRect dirtyRect = kpPainter::sprayPoints (&image,
         imagePoints,
         color (mouseButton ()),
-        spraycanSize ());
+        spraycanSize (),
+        &m_random);
+    if (dirtyRect.isEmpty ()) {
+        return  {};
+    }
 
 
+    // Only put back the pixels that were sprayed on.
     viewManager ()->setFastUpdates ();
-    document ()->setImageAt (image, docRect.topLeft ());
+    document ()->setImageAt (image.copy (dirtyRect),
+        docRect.topLeft () + dirtyRect.topLeft ());
     viewManager ()->restoreFastUpdates ();
 
 
-    return docRect;
+    return dirtyRect.translated (docRect.topLeft ());
 }
 
 // public virtual [base kpToolFlowBase]
@@ -31,6 +31,7 @@
 
 
 #include "kpToolFlowBase.h"
+#include "generic/kpRandom.h"
 
 
 class QPoint;
@@ -84,6 +85,9 @@ protected slots:
 protected:
     QTimer *m_timer;
     kpToolWidgetSpraycanSize *m_toolWidgetSpraycanSize;
+
+    // Seeded from the current command at the start of each stroke.
+    kpRandom m_random;
 };
 
 
@@ -68,6 +68,7 @@ kpTool::kpTool(const QString &text, const QString &description,
     d->description = description;
     d->began = false;
     d->viewUnderStartPoint = nullptr;
+    d->drawQueueTimer = nullptr;
     d->userShapeStartPoint = KP_INVALID_POINT;
     d->userShapeEndPoint = KP_INVALID_POINT;
     d->userShapeSize = KP_INVALID_SIZE;
@@ -30,6 +30,7 @@
 #define KP_TOOL_H
 
 
+#include <QList>
 #include <QObject>
 #include <QPoint>
 #include <QRect>
@@ -68,6 +69,10 @@ class kpTool : public QObject
 {
 Q_OBJECT
 
+    // (records color() and colorSimilarity(), and drains the draw queue
+    //  for replays)
+    friend class kpToolInputRecorder;
+
 public:
     // <text> = user-visible name of the tool e.g. "Color Picker"
     // <description> = user-visible description used for tooltips
@@ -228,9 +233,29 @@ protected:
     virtual void draw (const QPoint &thisPoint, const QPoint &lastPoint,
                         const QRect &normalizedRect);
 
+    // Return true if the tool can handle drawPolyline() efficiently.
+    //
+    // Mice and tablets can deliver 1000 mouse move events a second, more
+    // than draw() can keep up with.  So for tools that return true, while
+    // drawing, the points are queued and handed to drawPolyline() once per
+    // display frame instead.
+    virtual bool wantsBatchedDraw () const { return false; }
+
+    // Draws to each of <points> in turn, starting from <lastPoint>.
+    //
+    // The default implementation calls draw() for each point, updating
+    // currentPoint() and lastPoint() to match.
+    virtual void drawPolyline (const QList <QPoint> &points, const QPoint &lastPoint);
+
 private:
     void drawInternal ();
 
+    // Queues currentPoint() for drawPolyline() (see wantsBatchedDraw()).
+    void queueDrawPoint ();
+    // Passes the queued points to drawPolyline().  Call this before
+    // anything that depends on the points having been drawn.
+    void drawQueuedPoints ();
+
 protected:
     // (m_mouseButton will not change from beginDraw())
     virtual void cancelShape ();
@@ -36,17 +36,58 @@
 #include "document/kpDocument.h"
 #include "environments/tools/kpToolEnvironment.h"
 #include "commands/tools/kpToolFloodFillCommand.h"
+#include "layers/tempImage/kpTempImage.h"
+#include "views/manager/kpViewManager.h"
 
 #include "kpLogCategories.h"
 #include <KLocalizedString>
 
 #include <QApplication>
+#include <QAtomicInt>
+#include <QKeyEvent>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QThread>
+#include <QTimer>
+
+//---------------------------------------------------------------------
+
+// Fills that are found quicker than this are applied straight away,
+// without showing their progress.
+static const int SynchronousFillMS = 100;
+
+// How often the progress of a slower fill is shown.
+static const int ProgressIntervalMS = 50;
 
 //---------------------------------------------------------------------
 
 struct kpToolFloodFillPrivate
 {
     kpToolFloodFillCommand *currentCommand;
+
+    //
+    // Finding the pixels to fill in the background (see startFill()).
+    //
+
+    // Runs <fill.prepare()> on <image>, a copy of the document's image.
+    QThread *thread;
+    kpImage image;
+    kpFloodFill *fill;
+    QAtomicInt cancel;
+
+    // Lines found by <thread> but not yet drawn onto <progressImage>.
+    QMutex newLinesMutex;
+    QVector <QRect> newLines;
+
+    // Lines found so far, drawn in the fill color, for the kpTempImage.
+    kpImage progressImage;
+    bool progressClears;
+    QTimer *progressTimer;
+
+    // endDraw() has been called so <currentCommand> should be added to
+    // the command history as soon as it has been executed.
+    bool drawEnded;
 };
 
 //---------------------------------------------------------------------
@@ -58,12 +99,25 @@ kpToolFloodFill::kpToolFloodFill (kpToolEnvironment *environ, QObject *parent)
       d (new kpToolFloodFillPrivate ())
 {
     d->currentCommand = nullptr;
+
+    d->thread = nullptr;
+    d->fill = nullptr;
+    d->progressClears = false;
+    d->drawEnded = false;
+
+    d->progressTimer = new QTimer (this);
+    d->progressTimer->setInterval (::ProgressIntervalMS);
+    connect (d->progressTimer, &QTimer::timeout,
+             this, &kpToolFloodFill::showFillProgress);
 }
 
 //---------------------------------------------------------------------
 
 kpToolFloodFill::~kpToolFloodFill ()
 {
+    stopFill ();
+    delete d->currentCommand;
+
     delete d;
 }
 
@@ -72,7 +126,211 @@ kpToolFloodFill::~kpToolFloodFill ()
 // private
 QString kpToolFloodFill::haventBegunDrawUserMessage () const
 {
-    return i18n ("Click to fill a region.");
+    return i18n ("Click to fill a region, or Shift+click to replace all similar colors.");
+}
+
+//---------------------------------------------------------------------
+
+// Draws the lines found so far by kpToolFloodFill::startFill(), like
+// kpFloodFill::fill() would (see kpTempImage::UserFunctionType).
+static void DrawFillProgress (kpImage *destImage, const QPoint &topLeft,
+                              void *userData)
+{
+    const auto *d = static_cast <const kpToolFloodFillPrivate *> (userData);
+    if (d->progressImage.isNull ()) {
+        return;
+    }
+
+    QPainter painter (destImage);
+
+    // A fully transparent fill erases the pixels.
+    if (d->progressClears) {
+        painter.setCompositionMode (QPainter::CompositionMode_DestinationOut);
+    }
+
+    painter.drawImage (QPoint (0, 0), d->progressImage,
+                       QRect (-topLeft, destImage->size ()));
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpToolFloodFill::startFill ()
+{
+    Q_ASSERT (d->currentCommand && !d->thread);
+
+    // (a shallow copy, so that the document can't change under the thread)
+    d->image = *document ()->imagePointer (true/*allow indexed*/);
+
+    d->fill = new kpFloodFill (&d->image,
+        currentPoint ().x (), currentPoint ().y (),
+        d->currentCommand->color (),
+        d->currentCommand->processedColorSimilarity ());
+    d->fill->setReplaceAllSimilarColors (
+        d->currentCommand->replaceAllSimilarColors ());
+
+    d->cancel.storeRelease (0);
+    d->fill->setCancelFlag (&d->cancel);
+
+    d->fill->setProgressFunction ([this] (const QVector <QRect> &lines)
+    {
+        QMutexLocker lock (&d->newLinesMutex);
+        d->newLines += lines;
+    });
+
+    d->thread = QThread::create ([this] ()
+    {
+        d->fill->prepare ();
+    });
+    connect (d->thread, &QThread::finished,
+             this, &kpToolFloodFill::slotFillFound);
+
+    d->thread->start ();
+
+    // Most fills are found quickly enough that there is no point showing
+    // their progress.
+    if (d->thread->wait (::SynchronousFillMS))
+    {
+        finishFill ();
+        return;
+    }
+
+#if DEBUG_KP_TOOL_FLOOD_FILL && 1
+    qCDebug(kpLogTools) << "\tfill is slow - showing progress";
+#endif
+
+    d->progressClears = d->currentCommand->color ().isTransparent ();
+    d->progressImage = kpImage (d->image.size (),
+                                QImage::Format_ARGB32_Premultiplied);
+    d->progressImage.fill (0);
+
+    viewManager ()->setTempImage (kpTempImage (false/*always display*/,
+        QPoint (0, 0), &::DrawFillProgress, d,
+        d->image.width (), d->image.height ()));
+
+    showFillProgress ();
+    d->progressTimer->start ();
+
+    setUserMessage (i18n ("Filling... Press Esc to cancel."));
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpToolFloodFill::showFillProgress ()
+{
+    QVector <QRect> lines;
+    {
+        QMutexLocker lock (&d->newLinesMutex);
+        lines.swap (d->newLines);
+    }
+
+    if (lines.isEmpty () || d->progressImage.isNull ()) {
+        return;
+    }
+
+    QRect updateRect;
+    {
+        QPainter painter (&d->progressImage);
+        painter.setCompositionMode (QPainter::CompositionMode_Source);
+
+        const QColor color = d->progressClears ?
+            QColor (Qt::black) : d->currentCommand->color ().toQColor ();
+
+        for (const auto &line : lines)
+        {
+            painter.fillRect (line, color);
+            updateRect |= line;
+        }
+    }
+
+    viewManager ()->updateViews (updateRect);
+}
+
+//---------------------------------------------------------------------
+
+// private slot
+void kpToolFloodFill::slotFillFound ()
+{
+    // (not cancelled by stopFill() or finished by finishFill() already,
+    //  possibly followed by a new fill that is still running)
+    if (d->thread && d->thread->isFinished ()) {
+        finishFill ();
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpToolFloodFill::finishFill ()
+{
+    Q_ASSERT (d->thread);
+
+    QApplication::setOverrideCursor (Qt::WaitCursor);
+    {
+        d->thread->wait ();
+
+        d->currentCommand->copyPreparedFrom (*d->fill);
+        d->currentCommand->execute ();
+
+        clearFill ();
+    }
+    QApplication::restoreOverrideCursor ();
+
+    if (d->drawEnded)
+    {
+        commandHistory ()->addCommand (d->currentCommand,
+            false/*no exec - we already did it up there*/);
+
+        // Don't delete - it just got added to the history.
+        d->currentCommand = nullptr;
+        d->drawEnded = false;
+
+        setUserMessage (haventBegunDrawUserMessage ());
+    }
+    else if (hasBegunDraw ())
+    {
+        setUserMessage (cancelUserMessage ());
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpToolFloodFill::stopFill ()
+{
+    if (!d->thread) {
+        return;
+    }
+
+    d->cancel.storeRelease (1);
+    d->thread->wait ();
+
+    clearFill ();
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpToolFloodFill::clearFill ()
+{
+    d->progressTimer->stop ();
+
+    if (!d->progressImage.isNull ())
+    {
+        d->progressImage = kpImage ();
+        viewManager ()->invalidateTempImage ();
+    }
+
+    d->newLines.clear ();
+
+    delete d->thread;
+    d->thread = nullptr;
+
+    delete d->fill;
+    d->fill = nullptr;
+
+    d->image = kpImage ();
 }
 
 //---------------------------------------------------------------------
@@ -85,6 +343,15 @@ void kpToolFloodFill::begin ()
 
 //---------------------------------------------------------------------
 
+// public virtual [base kpTool]
+bool kpToolFloodFill::hasBegunShape () const
+{
+    // The fill might still be running after the mouse was released.
+    return (hasBegunDraw () || d->thread);
+}
+
+//---------------------------------------------------------------------
+
 // public virtual [base kpTool]
 void kpToolFloodFill::beginDraw ()
 {
@@ -92,6 +359,15 @@ void kpToolFloodFill::beginDraw ()
     qCDebug(kpLogTools) << "kpToolFloodFill::beginDraw()";
 #endif
 
+    // Clicked again before the last fill was found?
+    if (d->thread) {
+        finishFill ();
+    }
+
+    Q_ASSERT (!d->currentCommand);
+
+    d->drawEnded = false;
+
     QApplication::setOverrideCursor (Qt::WaitCursor);
     {
         environ ()->flashColorSimilarityToolBarItem ();
@@ -103,6 +379,12 @@ void kpToolFloodFill::beginDraw ()
             color (mouseButton ()), processedColorSimilarity (),
             environ ()->commandEnvironment ());
 
+        // Shift+click replaces the color everywhere, not just in the region
+        // connected to the clicked pixel.
+        if (shiftPressed ()) {
+            d->currentCommand->setReplaceAllSimilarColors ();
+        }
+
     #if DEBUG_KP_TOOL_FLOOD_FILL && 1
         qCDebug(kpLogTools) << "\tperforming new-doc-corner-case check";
     #endif
@@ -114,13 +396,21 @@ void kpToolFloodFill::beginDraw ()
             d->currentCommand->prepareColorToChange ();
 
             d->currentCommand->setFillEntireImage ();
-        }
 
-        d->currentCommand->execute ();
+            d->currentCommand->execute ();
+        }
+        else
+        {
+            // Find the pixels to fill in another thread, so that a big
+            // fill does not freeze the UI and can be cancelled.
+            startFill ();
+        }
     }
     QApplication::restoreOverrideCursor ();
 
-    setUserMessage (cancelUserMessage ());
+    if (!d->thread) {
+        setUserMessage (cancelUserMessage ());
+    }
 }
 
 //---------------------------------------------------------------------
@@ -136,12 +426,27 @@ void kpToolFloodFill::draw (const QPoint &thisPoint, const QPoint &, const QRect
 // public virtual [base kpTool]
 void kpToolFloodFill::cancelShape ()
 {
-    d->currentCommand->unexecute ();
+    if (d->thread)
+    {
+        stopFill ();
+    }
+    else
+    {
+        d->currentCommand->unexecute ();
+    }
 
     delete d->currentCommand;
     d->currentCommand = nullptr;
 
-    setUserMessage (i18n ("Let go of all the mouse buttons."));
+    if (d->drawEnded)
+    {
+        d->drawEnded = false;
+        setUserMessage (haventBegunDrawUserMessage ());
+    }
+    else
+    {
+        setUserMessage (i18n ("Let go of all the mouse buttons."));
+    }
 }
 
 //---------------------------------------------------------------------
@@ -149,7 +454,9 @@ void kpToolFloodFill::cancelShape ()
 // public virtual [base kpTool]
 void kpToolFloodFill::releasedAllButtons ()
 {
-    setUserMessage (haventBegunDrawUserMessage ());
+    if (!d->thread) {
+        setUserMessage (haventBegunDrawUserMessage ());
+    }
 }
 
 //---------------------------------------------------------------------
@@ -157,6 +464,15 @@ void kpToolFloodFill::releasedAllButtons ()
 // public virtual [base kpTool]
 void kpToolFloodFill::endDraw (const QPoint &, const QRect &)
 {
+    if (d->thread)
+    {
+        // Add the command to the history once the fill has been found
+        // (see finishFill()).
+        d->drawEnded = true;
+        setUserMessage (i18n ("Filling... Press Esc to cancel."));
+        return;
+    }
+
     environ ()->commandHistory ()->addCommand (d->currentCommand,
         false/*no exec - we already did it up there*/);
 
@@ -167,3 +483,37 @@ void kpToolFloodFill::endDraw (const QPoint &, const QRect &)
 
 //---------------------------------------------------------------------
 
+// public virtual [base kpTool]
+void kpToolFloodFill::endShape (const QPoint &thisPoint, const QRect &normalizedRect)
+{
+    if (d->thread)
+    {
+        // Something else wants to use the document so we can't keep
+        // filling in the background.
+        d->drawEnded = true;
+        finishFill ();
+    }
+    else
+    {
+        kpTool::endShape (thisPoint, normalizedRect);
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public virtual [base kpTool]
+void kpToolFloodFill::keyPressEvent (QKeyEvent *e)
+{
+    // kpTool only cancels on Esc while a mouse button is down, but the
+    // fill might still be running after the mouse was released.
+    if (e->key () == Qt::Key_Escape && d->thread && !hasBegunDraw ())
+    {
+        cancelShapeInternal ();
+        e->accept ();
+        return;
+    }
+
+    kpTool::keyPressEvent (e);
+}
+
+//---------------------------------------------------------------------
@@ -44,13 +44,31 @@ public:
 private:
     QString haventBegunDrawUserMessage () const;
 
+    // Finds the pixels to fill in another thread, showing them as they are
+    // found.  If that is quick, this finishes the fill before returning.
+    void startFill ();
+    // Waits for the fill to be found and then executes the command.
+    void finishFill ();
+    // Cancels the fill.
+    void stopFill ();
+    void clearFill ();
+
+private slots:
+    void showFillProgress ();
+    void slotFillFound ();
+
 public:
     void begin () override;
+    bool hasBegunShape () const override;
     void beginDraw () override;
     void draw (const QPoint &thisPoint, const QPoint &, const QRect &) override;
     void cancelShape () override;
     void releasedAllButtons () override;
     void endDraw (const QPoint &, const QRect &) override;
+    void endShape (const QPoint &thisPoint = QPoint (),
+                   const QRect &normalizedRect = QRect ()) override;
+
+    void keyPressEvent (QKeyEvent *e) override;
 
 private:
     struct kpToolFloodFillPrivate * const d;
@@ -0,0 +1,427 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#define DEBUG_KP_TOOL_INPUT_RECORDER 0
+
+
+#include "tools/kpToolInputRecorder.h"
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QImage>
+#include <QInputMethodEvent>
+#include <QKeyEvent>
+#include <QMouseEvent>
+#include <QWheelEvent>
+
+#include "kpLogCategories.h"
+
+#include "document/kpDocument.h"
+#include "imagelib/kpColor.h"
+#include "tools/kpTool.h"
+#include "views/kpView.h"
+#include "widgets/toolbars/kpToolToolBar.h"
+#include "widgets/toolbars/options/kpToolWidgetBase.h"
+
+//---------------------------------------------------------------------
+
+static const quint32 RecordingMagic = 0x4B504952;  // "KPIR"
+static const quint32 RecordingVersion = 1;
+
+//---------------------------------------------------------------------
+
+static QDataStream &operator<< (QDataStream &stream, const kpToolInputRecord &record)
+{
+    stream << quint8 (record.kind);
+
+    switch (record.kind)
+    {
+    case kpToolInputRecord::Start:
+        stream << record.documentSize << record.documentHash;
+        break;
+
+    case kpToolInputRecord::State:
+        stream << record.toolName
+               << quint32 (record.foregroundColor) << quint32 (record.backgroundColor)
+               << record.colorSimilarity
+               << qint32 (record.zoomLevelX) << qint32 (record.zoomLevelY)
+               << record.toolWidgetSelections;
+        break;
+
+    case kpToolInputRecord::Event:
+        stream << record.timestampNS << quint16 (record.type)
+               << record.pos << record.angleDelta
+               << qint32 (record.button) << qint32 (record.buttons)
+               << qint32 (record.modifiers)
+               << qint32 (record.key) << record.text << record.preeditText
+               << record.autoRepeat;
+        break;
+    }
+
+    return stream;
+}
+
+//---------------------------------------------------------------------
+
+static QDataStream &operator>> (QDataStream &stream, kpToolInputRecord &record)
+{
+    quint8 kind = 0;
+    stream >> kind;
+    record.kind = kpToolInputRecord::Kind (kind);
+
+    switch (record.kind)
+    {
+    case kpToolInputRecord::Start:
+        stream >> record.documentSize >> record.documentHash;
+        break;
+
+    case kpToolInputRecord::State:
+    {
+        quint32 foregroundColor = 0, backgroundColor = 0;
+        qint32 zoomLevelX = 0, zoomLevelY = 0;
+        stream >> record.toolName
+               >> foregroundColor >> backgroundColor
+               >> record.colorSimilarity
+               >> zoomLevelX >> zoomLevelY
+               >> record.toolWidgetSelections;
+        record.foregroundColor = foregroundColor;
+        record.backgroundColor = backgroundColor;
+        record.zoomLevelX = zoomLevelX;
+        record.zoomLevelY = zoomLevelY;
+        break;
+    }
+
+    case kpToolInputRecord::Event:
+    {
+        quint16 type = 0;
+        qint32 button = 0, buttons = 0, modifiers = 0, key = 0;
+        stream >> record.timestampNS >> type
+               >> record.pos >> record.angleDelta
+               >> button >> buttons >> modifiers
+               >> key >> record.text >> record.preeditText
+               >> record.autoRepeat;
+        record.type = QEvent::Type (type);
+        record.button = button;
+        record.buttons = buttons;
+        record.modifiers = modifiers;
+        record.key = key;
+        break;
+    }
+
+    default:
+        stream.setStatus (QDataStream::ReadCorruptData);
+        break;
+    }
+
+    return stream;
+}
+
+//---------------------------------------------------------------------
+
+// public
+QEvent *kpToolInputRecord::createEvent () const
+{
+    Q_ASSERT (kind == Event);
+
+    const auto modifiersFlags = Qt::KeyboardModifiers (modifiers);
+
+    switch (type)
+    {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseMove:
+        return new QMouseEvent (type, pos, Qt::MouseButton (button),
+                                Qt::MouseButtons (buttons), modifiersFlags);
+
+    case QEvent::Wheel:
+        return new QWheelEvent (pos, pos, QPoint (), angleDelta,
+                                angleDelta.y (), Qt::Vertical,
+                                Qt::MouseButtons (buttons), modifiersFlags);
+
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+        return new QKeyEvent (type, key, modifiersFlags, text, autoRepeat);
+
+    case QEvent::InputMethod:
+    {
+        auto *e = new QInputMethodEvent (preeditText,
+                                         QList <QInputMethodEvent::Attribute> ());
+        e->setCommitString (text);
+        return e;
+    }
+
+    default:
+        return nullptr;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpToolInputRecord::sameStateAs (const kpToolInputRecord &rhs) const
+{
+    return (toolName == rhs.toolName &&
+            foregroundColor == rhs.foregroundColor &&
+            backgroundColor == rhs.backgroundColor &&
+            colorSimilarity == rhs.colorSimilarity &&
+            zoomLevelX == rhs.zoomLevelX &&
+            zoomLevelY == rhs.zoomLevelY &&
+            toolWidgetSelections == rhs.toolWidgetSelections);
+}
+
+//---------------------------------------------------------------------
+
+struct kpToolInputRecording
+{
+    QFile file;
+    QDataStream stream;
+    QElapsedTimer timer;
+
+    bool startRecorded{false};
+    kpToolInputRecord lastState;
+};
+
+static kpToolInputRecording *Recording = nullptr;
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpToolInputRecorder::start (const QString &path)
+{
+    kpToolInputRecorder::stop ();
+
+    auto *recording = new kpToolInputRecording ();
+    recording->file.setFileName (path);
+    if (!recording->file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qCWarning(kpLogTools) << "Could not record input to" << path
+                              << recording->file.errorString ();
+        delete recording;
+        return false;
+    }
+
+    recording->stream.setDevice (&recording->file);
+    recording->stream << RecordingMagic << RecordingVersion;
+    recording->timer.start ();
+
+    ::Recording = recording;
+
+    QObject::connect (qApp, &QCoreApplication::aboutToQuit,
+                      &kpToolInputRecorder::stop);
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpToolInputRecorder::stop ()
+{
+    delete ::Recording;
+    ::Recording = nullptr;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpToolInputRecorder::isRecording ()
+{
+    return (::Recording != nullptr);
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpToolInputRecorder::drawQueuedPoints (kpTool *tool)
+{
+    Q_ASSERT (tool);
+    tool->drawQueuedPoints ();
+}
+
+//---------------------------------------------------------------------
+
+// public static
+void kpToolInputRecorder::record (const kpView *view, kpTool *tool, const QEvent *e)
+{
+    if (!::Recording) {
+        return;
+    }
+
+    Q_ASSERT (view && tool && e);
+
+    kpToolInputRecording *recording = ::Recording;
+
+    if (!recording->startRecorded)
+    {
+        kpToolInputRecord start;
+        start.kind = kpToolInputRecord::Start;
+        start.documentSize = view->document ()->rect ().size ();
+        start.documentHash = kpToolInputRecorder::imageHash (
+            view->document ()->imageWithSelection ());
+
+        recording->stream << start;
+        recording->startRecorded = true;
+    }
+
+    // Tool state
+    kpToolInputRecord state;
+    state.kind = kpToolInputRecord::State;
+    state.toolName = tool->objectName ();
+    state.foregroundColor = tool->color (0).toQRgb ();
+    state.backgroundColor = tool->color (1).toQRgb ();
+    state.colorSimilarity = tool->colorSimilarity ();
+    state.zoomLevelX = view->zoomLevelX ();
+    state.zoomLevelY = view->zoomLevelY ();
+    for (int i = 0; kpToolWidgetBase *w = view->toolToolBar ()->shownToolWidget (i); i++)
+    {
+        state.toolWidgetSelections.append (
+            qMakePair (w->objectName (), QPoint (w->selectedCol (), w->selectedRow ())));
+    }
+
+    if (!state.sameStateAs (recording->lastState))
+    {
+        recording->stream << state;
+        recording->lastState = state;
+    }
+
+    // Event
+    kpToolInputRecord event;
+    event.kind = kpToolInputRecord::Event;
+    event.timestampNS = recording->timer.nsecsElapsed ();
+    event.type = e->type ();
+
+    switch (e->type ())
+    {
+    case QEvent::MouseButtonPress:
+    case QEvent::MouseButtonRelease:
+    case QEvent::MouseMove:
+    {
+        const auto *me = static_cast <const QMouseEvent *> (e);
+        event.pos = me->pos ();
+        event.button = me->button ();
+        event.buttons = me->buttons ();
+        event.modifiers = me->modifiers ();
+        break;
+    }
+
+    case QEvent::Wheel:
+    {
+        const auto *we = static_cast <const QWheelEvent *> (e);
+        event.pos = we->pos ();
+        event.angleDelta = we->angleDelta ();
+        event.buttons = we->buttons ();
+        event.modifiers = we->modifiers ();
+        break;
+    }
+
+    case QEvent::KeyPress:
+    case QEvent::KeyRelease:
+    {
+        const auto *ke = static_cast <const QKeyEvent *> (e);
+        event.key = ke->key ();
+        event.modifiers = ke->modifiers ();
+        event.text = ke->text ();
+        event.autoRepeat = ke->isAutoRepeat ();
+        break;
+    }
+
+    case QEvent::InputMethod:
+    {
+        const auto *ime = static_cast <const QInputMethodEvent *> (e);
+        event.text = ime->commitString ();
+        event.preeditText = ime->preeditString ();
+        break;
+    }
+
+    default:
+        return;
+    }
+
+    recording->stream << event;
+
+#if DEBUG_KP_TOOL_INPUT_RECORDER
+    qCDebug(kpLogTools) << "kpToolInputRecorder::record() type=" << e->type ()
+                        << "t=" << event.timestampNS;
+#endif
+}
+
+//---------------------------------------------------------------------
+
+// public static
+bool kpToolInputRecorder::read (const QString &path, QList <kpToolInputRecord> *records)
+{
+    Q_ASSERT (records);
+
+    QFile file (path);
+    if (!file.open (QIODevice::ReadOnly)) {
+        return false;
+    }
+
+    QDataStream stream (&file);
+
+    quint32 magic = 0, version = 0;
+    stream >> magic >> version;
+    if (magic != RecordingMagic || version != RecordingVersion) {
+        return false;
+    }
+
+    records->clear ();
+    while (!stream.atEnd ())
+    {
+        kpToolInputRecord record;
+        stream >> record;
+        if (stream.status () != QDataStream::Ok) {
+            // (truncated if KolourPaint did not quit normally)
+            break;
+        }
+
+        records->append (record);
+    }
+
+    return true;
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QByteArray kpToolInputRecorder::imageHash (const QImage &image)
+{
+    const QImage argb = image.convertToFormat (QImage::Format_ARGB32_Premultiplied);
+
+    QCryptographicHash hash (QCryptographicHash::Sha1);
+    for (int y = 0; y < argb.height (); y++)
+    {
+        hash.addData (reinterpret_cast <const char *> (argb.constScanLine (y)),
+                      argb.width () * 4);
+    }
+
+    return hash.result ().toHex ();
+}
+
+//---------------------------------------------------------------------
@@ -0,0 +1,128 @@
+/*
+   Copyright (c) 2026 The KolourPaint developers
+   All rights reserved.
+
+   Redistribution and use in source and binary forms, with or without
+   modification, are permitted provided that the following conditions
+   are met:
+
+   1. Redistributions of source code must retain the above copyright
+      notice, this list of conditions and the following disclaimer.
+   2. Redistributions in binary form must reproduce the above copyright
+      notice, this list of conditions and the following disclaimer in the
+      documentation and/or other materials provided with the distribution.
+
+   THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+   IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+   OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+   IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+   INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+   NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+   DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+   THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+   (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+   THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*/
+
+
+#ifndef kpToolInputRecorder_H
+#define kpToolInputRecorder_H
+
+
+#include <QByteArray>
+#include <QEvent>
+#include <QList>
+#include <QPair>
+#include <QPoint>
+#include <QRgb>
+#include <QSize>
+#include <QString>
+
+
+class QImage;
+
+class kpTool;
+class kpView;
+
+
+// One entry in a recording made by kpToolInputRecorder.
+struct kpToolInputRecord
+{
+    enum Kind
+    {
+        // The document at the start of the recording.
+        Start = 0,
+        // The tool and its options, recorded whenever they change.
+        State = 1,
+        // An input event delivered to the tool.
+        Event = 2
+    };
+
+    Kind kind{Event};
+
+    // Start
+    QSize documentSize;
+    QByteArray documentHash;
+
+    // State
+    QString toolName;
+    QRgb foregroundColor{0}, backgroundColor{0};
+    double colorSimilarity{0};
+    int zoomLevelX{100}, zoomLevelY{100};
+    // kpToolWidgetBase::objectName() -> (selectedCol(), selectedRow())
+    QList <QPair <QString, QPoint> > toolWidgetSelections;
+
+    // Event
+    qint64 timestampNS{0};
+    QEvent::Type type{QEvent::None};
+    QPoint pos;  // view coordinates
+    QPoint angleDelta;
+    int button{0}, buttons{0}, modifiers{0};
+    int key{0};
+    QString text;  // key text or input method commit string
+    QString preeditText;
+    bool autoRepeat{false};
+
+    // Returns a new event equivalent to the recorded one (Event only).
+    QEvent *createEvent () const;
+
+    bool sameStateAs (const kpToolInputRecord &rhs) const;
+};
+
+
+//
+// Records the input events that kpView delivers to the current kpTool,
+// together with the tool's state, so that a drawing session can be
+// replayed deterministically for benchmarking (see the --record-input and
+// --replay-input command line options and
+// kpMainWindow::replayToolInput()).
+//
+// Tablet events reach the tools as the mouse events that Qt synthesizes
+// from them so they are recorded as such.
+//
+class kpToolInputRecorder
+{
+public:
+    // Starts recording to <path>, until the application quits.
+    static bool start (const QString &path);
+    static void stop ();
+
+    static bool isRecording ();
+
+    // Called by kpView just before it delivers <e> to <tool>.
+    static void record (const kpView *view, kpTool *tool, const QEvent *e);
+
+    // Draws the points that <tool> has queued to draw on the next display
+    // frame (see kpTool::wantsBatchedDraw()) now, so that replaying can
+    // time the drawing together with the event that queued them.
+    static void drawQueuedPoints (kpTool *tool);
+
+    // Returns the records in the recording at <path>.
+    static bool read (const QString &path, QList <kpToolInputRecord> *records);
+
+    // Returns a hash of the pixels of <image>, for comparing replays.
+    static QByteArray imageHash (const QImage &image);
+};
+
+
+#endif  // kpToolInputRecorder_H
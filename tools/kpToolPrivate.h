@@ -30,6 +30,7 @@
 #define kpToolPrivate_H
 
 
+#include <QList>
 #include <QPoint>
 #include <QPointer>
 
@@ -39,6 +40,8 @@
   #undef environ  // macro on win32
 #endif
 
+class QTimer;
+
 class kpToolAction;
 class kpToolEnvironment;
 
@@ -63,6 +66,11 @@ struct kpToolPrivate
 
     kpView *viewUnderStartPoint;
 
+    // Points waiting for drawPolyline() and the timer that passes them on,
+    // once per display frame (see kpTool::wantsBatchedDraw()).
+    QList <QPoint> queuedDrawPoints;
+    QTimer *drawQueueTimer;
+
 
     // Set to 2 when the user swaps the foreground and background color.
     //
@@ -37,10 +37,14 @@
 #include "kpToolPrivate.h"
 
 #include <QApplication>
+#include <QGuiApplication>
+#include <QScreen>
+#include <QTimer>
 
 #include "kpLogCategories.h"
 
 #include "environments/tools/kpToolEnvironment.h"
+#include "generic/kpTrace.h"
 #include "views/kpView.h"
 #include "views/manager/kpViewManager.h"
 #include "imagelib/kpPainter.h"
@@ -248,6 +252,8 @@ void kpTool::beginDrawInternal ()
 {
     if (!d->beganDraw)
     {
+        KP_TRACE_SCOPE ("tools", "kpTool::beginDraw");
+
         beginDraw ();
 
         d->beganDraw = true;
@@ -305,15 +311,103 @@ void kpTool::draw (const QPoint &, const QPoint &, const QRect &)
 // private
 void kpTool::drawInternal ()
 {
+    KP_TRACE_SCOPE ("tools", "kpTool::draw");
+
     draw (d->currentPoint, d->lastPoint, normalizedRect ());
 }
 
 //---------------------------------------------------------------------
 
+// protected virtual
+void kpTool::drawPolyline (const QList <QPoint> &points, const QPoint &lastPoint)
+{
+    QPoint last = lastPoint;
+    for (const auto &point : points)
+    {
+        d->currentPoint = point;
+        d->lastPoint = last;
+
+        draw (point, last, normalizedRect ());
+
+        last = point;
+    }
+}
+
+//---------------------------------------------------------------------
+
+// Returns the time between display frames.
+static int DrawQueueIntervalMS ()
+{
+    const QScreen *screen = QGuiApplication::primaryScreen ();
+    const qreal refreshRate = screen ? screen->refreshRate () : 60;
+
+    return qMax (1, qRound (1000 / qMax (qreal (1), refreshRate)));
+}
+
+// private
+void kpTool::queueDrawPoint ()
+{
+    if (!d->drawQueueTimer)
+    {
+        d->drawQueueTimer = new QTimer (this);
+        d->drawQueueTimer->setSingleShot (true);
+        d->drawQueueTimer->setTimerType (Qt::PreciseTimer);
+        connect (d->drawQueueTimer, &QTimer::timeout,
+                 this, &kpTool::drawQueuedPoints);
+    }
+
+    d->queuedDrawPoints.append (d->currentPoint);
+
+    if (!d->drawQueueTimer->isActive ()) {
+        d->drawQueueTimer->start (::DrawQueueIntervalMS ());
+    }
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpTool::drawQueuedPoints ()
+{
+    if (d->drawQueueTimer) {
+        d->drawQueueTimer->stop ();
+    }
+
+    if (d->queuedDrawPoints.isEmpty ()) {
+        return;
+    }
+
+    const QList <QPoint> points = d->queuedDrawPoints;
+    d->queuedDrawPoints.clear ();
+
+    if (!d->beganDraw) {
+        return;
+    }
+
+    // (the caller may have already moved on to the next point)
+    const QPoint currentPoint = d->currentPoint;
+
+    {
+        kpTraceScope traceScope ("tools", "kpTool::drawPolyline");
+        if (kpTrace::isEnabled ()) {
+            traceScope.setDetail (QString::number (points.size ()));
+        }
+
+        drawPolyline (points, d->lastPoint);
+    }
+
+    d->currentPoint = currentPoint;
+    d->lastPoint = points.last ();
+}
+
+//---------------------------------------------------------------------
+
 
 // also called by kpView
 void kpTool::cancelShapeInternal ()
 {
+    // (the shape is about to be thrown away)
+    d->queuedDrawPoints.clear ();
+
     if (hasBegunShape ())
     {
         d->beganDraw = false;
@@ -370,8 +464,12 @@ void kpTool::endDrawInternal (const QPoint &thisPoint, const QRect &normalizedRe
         return;
     }
 
+    drawQueuedPoints ();
+
     d->beganDraw = false;
 
+    KP_TRACE_SCOPE ("tools", "kpTool::endDraw");
+
     if (wantEndShape)
     {
     #if DEBUG_KP_TOOL && 0
@@ -377,7 +377,11 @@ void kpTool::notifyModifierStateChanged ()
 {
     if (careAboutModifierState ())
     {
-        if (d->beganDraw) {
+        if (d->beganDraw)
+        {
+            // Keep the points in order.
+            drawQueuedPoints ();
+
             draw (d->currentPoint, d->lastPoint, normalizedRect ());
         }
         else
@@ -397,6 +401,9 @@ void kpTool::setShiftPressed (bool pressed)
         return;
     }
 
+    // (the queued points were made with the old modifiers)
+    drawQueuedPoints ();
+
     d->shiftPressed = pressed;
 
     notifyModifierStateChanged ();
@@ -410,6 +417,9 @@ void kpTool::setControlPressed (bool pressed)
         return;
     }
 
+    // (the queued points were made with the old modifiers)
+    drawQueuedPoints ();
+
     d->controlPressed = pressed;
 
     notifyModifierStateChanged ();
@@ -423,6 +433,9 @@ void kpTool::setAltPressed (bool pressed)
         return;
     }
 
+    // (the queued points were made with the old modifiers)
+    drawQueuedPoints ();
+
     d->altPressed = pressed;
 
     notifyModifierStateChanged ();
@@ -37,6 +37,7 @@
 #include "kpLogCategories.h"
 
 #include "environments/tools/kpToolEnvironment.h"
+#include "generic/kpTrace.h"
 #include "views/kpView.h"
 #include "views/manager/kpViewManager.h"
 
@@ -152,7 +153,10 @@ void kpTool::mousePressEvent (QMouseEvent *e)
 
     beginDrawInternal ();
 
-    draw (d->currentPoint, d->lastPoint, QRect (d->currentPoint, d->currentPoint));
+    {
+        KP_TRACE_SCOPE ("tools", "kpTool::draw");
+        draw (d->currentPoint, d->lastPoint, QRect (d->currentPoint, d->currentPoint));
+    }
     d->lastPoint = d->currentPoint;
 }
 
@@ -202,6 +206,16 @@ void kpTool::mouseMoveEvent (QMouseEvent *e)
         bool dragScrolled = false;
         movedAndAboutToDraw (d->currentPoint, d->lastPoint, view->zoomLevelX (), &dragScrolled);
 
+        if (!dragScrolled && wantsBatchedDraw ())
+        {
+            // Drawn once per display frame, by drawQueuedPoints().
+            queueDrawPoint ();
+            return;
+        }
+
+        // Keep the points in order.
+        drawQueuedPoints ();
+
         if (dragScrolled)
         {
             d->currentPoint = calculateCurrentPoint ();
@@ -260,6 +274,8 @@ void kpTool::mouseReleaseEvent (QMouseEvent *e)
         kpView *view = viewUnderStartPoint ();
         Q_ASSERT (view);
 
+        drawQueuedPoints ();
+
         d->currentPoint = view->transformViewToDoc (e->pos ());
         d->currentViewPoint = e->pos ();
 
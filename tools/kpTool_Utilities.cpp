@@ -157,6 +157,9 @@ void kpTool::somethingBelowTheCursorChanged (const QPoint &currentPoint_,
     qCDebug(kpLogTools) << "\tbegan draw=" << d->beganDraw;
 #endif
 
+    // Keep the points in order.
+    drawQueuedPoints ();
+
     d->currentPoint = currentPoint_;
     d->currentViewPoint = currentViewPoint_;
 
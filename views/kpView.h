@@ -586,7 +586,8 @@ protected:
     // <painter>.
     void paintEventDrawGridLines (QPainter *painter, const QRect &viewRect);
 
-    void paintEventDrawDoc_Unclipped (const QRect &viewRect);
+    bool paintEventDrawDoc_Unclipped (const QRect &viewRect,
+        bool withGridLines);
     void paintEvent (QPaintEvent *e) override;
 
 
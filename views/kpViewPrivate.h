@@ -71,6 +71,10 @@ struct kpViewPrivate
     QRect buddyViewScrollableContainerRectangle;
 
     QRegion queuedUpdateArea;
+
+    // The scrollable container's contents position at the last
+    // paintEvent(), for reporting how much each scroll step repaints.
+    QPoint lastPaintContentsPos;
 };
 
 
@@ -43,6 +43,7 @@
 #include <QMouseEvent>
 
 #include "tools/kpTool.h"
+#include "tools/kpToolInputRecorder.h"
 
 //---------------------------------------------------------------------
 
@@ -61,6 +62,7 @@ void kpView::mouseMoveEvent (QMouseEvent *e)
     setHasMouse (rect ().contains (e->pos ()));
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->mouseMoveEvent (e);
     }
 
@@ -79,6 +81,7 @@ void kpView::mousePressEvent (QMouseEvent *e)
     setHasMouse (true);
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->mousePressEvent (e);
     }
 
@@ -99,6 +102,7 @@ void kpView::mouseReleaseEvent (QMouseEvent *e)
     setHasMouse (rect ().contains (e->pos ()));
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->mouseReleaseEvent (e);
     }
 
@@ -111,6 +115,7 @@ void kpView::mouseReleaseEvent (QMouseEvent *e)
 void kpView::wheelEvent (QWheelEvent *e)
 {
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->wheelEvent (e);
     }
 }
@@ -125,6 +130,7 @@ void kpView::keyPressEvent (QKeyEvent *e)
 #endif
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->keyPressEvent (e);
     }
 
@@ -141,6 +147,7 @@ void kpView::keyReleaseEvent (QKeyEvent *e)
 #endif
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->keyReleaseEvent (e);
     }
 
@@ -157,6 +164,7 @@ void kpView::inputMethodEvent (QInputMethodEvent *e)
 #endif
 
     if (tool ()) {
+        kpToolInputRecorder::record (this, tool (), e);
         tool ()->inputMethodEvent (e);
     }
     e->accept ();
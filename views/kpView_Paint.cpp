@@ -35,13 +35,15 @@
 
 #include <QPainter>
 #include <QPaintEvent>
-#include <QTime>
 #include <QScrollBar>
 
 #include "kpLogCategories.h"
 
+#include "generic/kpStartupProfile.h"
+#include "generic/kpTrace.h"
 #include "layers/selections/kpAbstractSelection.h"
 #include "imagelib/kpColor.h"
+#include "imagelib/kpPixelReplicator.h"
 #include "document/kpDocument.h"
 #include "layers/tempImage/kpTempImage.h"
 #include "layers/selections/text/kpTextSelection.h"
@@ -430,11 +432,16 @@ void kpView::paintEventDrawGridLines (QPainter *painter, const QRect &viewRect)
 // This over-drawing is only safe from Qt's perspective since Qt
 // automatically clips all drawing in paintEvent() (which calls us) to
 // QPaintEvent::region().
-void kpView::paintEventDrawDoc_Unclipped (const QRect &viewRect)
+//
+// At integer zoom levels, this does not draw outside of <viewRect> and, if
+// <withGridLines>, draws the grid lines inside <viewRect> in the same pass.
+// Returns whether it did so.
+bool kpView::paintEventDrawDoc_Unclipped (const QRect &viewRect,
+        bool withGridLines)
 {
+    KP_TRACE_SCOPE ("views", "kpView::paintEventDrawDoc_Unclipped");
+
 #if DEBUG_KP_VIEW_RENDERER
-    QTime timer;
-    timer.start ();
     qCDebug(kpLogViews) << "\tviewRect=" << viewRect;
 #endif
 
@@ -445,7 +452,7 @@ void kpView::paintEventDrawDoc_Unclipped (const QRect &viewRect)
     Q_ASSERT (doc);
 
     if (viewRect.isEmpty ()) {
-        return;
+        return true;
     }
 
     QRect docRect = paintEventGetDocRect (viewRect);
@@ -516,25 +523,33 @@ void kpView::paintEventDrawDoc_Unclipped (const QRect &viewRect)
     #if DEBUG_KP_VIEW_RENDERER && 1
         qCDebug(kpLogViews) << "\torigin=" << origin ();
     #endif
+
+        // Pixel art is usually edited at integer zoom levels, where
+        // replicating pixels ourselves is much faster than QPainter::scale().
+        if (zoomLevelX () >= 200 && zoomLevelX () % 100 == 0 &&
+            zoomLevelY () >= 200 && zoomLevelY () % 100 == 0)
+        {
+            KP_TRACE_SCOPE ("views", "kpView::paintEventDrawDoc_Unclipped replicate");
+
+            painter.drawImage (viewRect.topLeft (),
+                kpPixelReplicator::replicate (docPixmap, docRect, viewRect, origin (),
+                    zoomLevelX () / 100, zoomLevelY () / 100, withGridLines));
+            return withGridLines;
+        }
+
         // Blit scaled version of docPixmap + tempImage.
-    #if DEBUG_KP_VIEW_RENDERER && 1
-        QTime scaleTimer; scaleTimer.start ();
-    #endif
+        KP_TRACE_SCOPE ("views", "kpView::paintEventDrawDoc_Unclipped scale");
+
         // This is the only troublesome part of the method that draws unclipped.
         painter.translate (origin ().x (), origin ().y ());
         painter.scale (double (zoomLevelX ()) / 100.0,
                        double (zoomLevelY ()) / 100.0);
         painter.drawImage (docRect, docPixmap);
         //painter.resetMatrix ();  // back to 1-1 scaling
-    #if DEBUG_KP_VIEW_RENDERER && 1
-        qCDebug(kpLogViews) << "\tscale time=" << scaleTimer.elapsed ();
-    #endif
 
     }  // if (!docRect.isEmpty ()) {
 
-#if DEBUG_KP_VIEW_RENDERER && 1
-    qCDebug(kpLogViews) << "\tdrawDocRect done in: " << timer.restart () << "ms";
-#endif
+    return false;
 }
 
 //---------------------------------------------------------------------
@@ -546,10 +561,10 @@ void kpView::paintEvent (QPaintEvent *e)
     // WARNING: document(), viewManager() and friends might be 0 in this method.
     // TODO: I'm not 100% convinced that we always check if their friends are 0.
 
-#if DEBUG_KP_VIEW_RENDERER && 1
-    QTime timer;
-    timer.start ();
-#endif
+    kpTraceScope traceScope ("views", "kpView::paintEvent");
+    if (kpTrace::isEnabled ()) {
+        traceScope.setDetail (objectName ());
+    }
 
     kpViewManager *vm = viewManager ();
 
@@ -597,14 +612,18 @@ void kpView::paintEvent (QPaintEvent *e)
     // parts of nearby grid lines (which were drawn in a previous iteration)
     // with document pixels.  Those grid line parts are probably not going to
     // be redrawn, so will appear to be missing.
+    bool drewGridLines = true;
     for (const QRect &r : viewRegion)
-      paintEventDrawDoc_Unclipped (r);
+    {
+      if (!paintEventDrawDoc_Unclipped (r, isGridShown ()))
+        drewGridLines = false;
+    }
 
     //
     // Draw Grid Lines
     //
 
-    if ( isGridShown() )
+    if ( isGridShown() && !drewGridLines )
     {
       QPainter painter(this);
       for (const QRect &r : viewRegion)
@@ -629,9 +648,40 @@ void kpView::paintEvent (QPaintEvent *e)
         paintEventDrawSelectionResizeHandles (e->rect ());
     }
 
-#if DEBUG_KP_VIEW_RENDERER && 1
-    qCDebug(kpLogViews) << "\tall done in: " << timer.restart () << "ms";
-#endif
+    // Report how much of the view this paint had to render and how far the
+    // scrollable container moved since the last paint.  When scrolling,
+    // <paintedArea> should only cover the newly exposed strips - the rest
+    // is shifted by Qt's backing store (see kpViewScrollableContainer).
+    if (kpTrace::isEnabled ())
+    {
+        qint64 paintedArea = 0;
+        for (const QRect &r : viewRegion) {
+            paintedArea += qint64 (r.width ()) * r.height ();
+        }
+
+        const QRect visibleRect = visibleRegion ().boundingRect ();
+
+        QPoint contentsPos;
+        if (scrollableContainer ())
+        {
+            contentsPos = QPoint (scrollableContainer ()->horizontalScrollBar ()->value (),
+                                  scrollableContainer ()->verticalScrollBar ()->value ());
+        }
+        const QPoint scrolledBy = contentsPos - d->lastPaintContentsPos;
+        d->lastPaintContentsPos = contentsPos;
+
+        traceScope.setDetail (QStringLiteral ("%1 painted=%2 visible=%3 scrolledBy=%4,%5")
+            .arg (objectName ())
+            .arg (paintedArea)
+            .arg (qint64 (visibleRect.width ()) * visibleRect.height ())
+            .arg (scrolledBy.x ())
+            .arg (scrolledBy.y ()));
+    }
+
+    // (for --startup-profile)
+    if (!kpStartupProfile::isFinished ()) {
+        kpStartupProfile::finish ();
+    }
 }
 
 //---------------------------------------------------------------------
@@ -32,7 +32,9 @@
 #include "kpEffectReduceColorsWidget.h"
 
 #include "imagelib/effects/kpEffectReduceColors.h"
+#include "imagelib/effects/kpEffectReduceToPalette.h"
 #include "commands/imagelib/effects/kpEffectReduceColorsCommand.h"
+#include "commands/imagelib/effects/kpEffectReduceToPaletteCommand.h"
 #include "pixmapfx/kpPixmapFX.h"
 
 #include "kpLogCategories.h"
@@ -48,8 +50,10 @@
 
 
 kpEffectReduceColorsWidget::kpEffectReduceColorsWidget (bool actOnSelection,
-                                                        QWidget *parent)
-    : kpEffectWidgetBase (actOnSelection, parent)
+        const QVector <QRgb> &palette,
+        QWidget *parent)
+    : kpEffectWidgetBase (actOnSelection, parent),
+      m_palette (palette)
 {
     auto *lay = new QVBoxLayout (this);
     lay->setContentsMargins(0, 0, 0, 0);
@@ -66,6 +70,20 @@ kpEffectReduceColorsWidget::kpEffectReduceColorsWidget (bool actOnSelection,
 
     m_24BitRadioButton = new QRadioButton (i18n ("24-&bit color"), this);
 
+    m_paletteRadioButton = new QRadioButton (
+        i18np ("Color &palette (1 color)", "Color &palette (%1 colors)",
+               m_palette.size ()),
+        this);
+
+    m_paletteDitheredRadioButton = new QRadioButton (
+        i18np ("Color palette, 1 color (&dithered)",
+               "Color palette, %1 colors (&dithered)",
+               m_palette.size ()),
+        this);
+
+    m_paletteRadioButton->setEnabled (!m_palette.isEmpty ());
+    m_paletteDitheredRadioButton->setEnabled (!m_palette.isEmpty ());
+
 
     // LOCOMPAT: don't think this is needed
     auto *buttonGroup = new QButtonGroup (this);
@@ -74,6 +92,8 @@ kpEffectReduceColorsWidget::kpEffectReduceColorsWidget (bool actOnSelection,
     buttonGroup->addButton (m_8BitRadioButton);
     buttonGroup->addButton (m_8BitDitheredRadioButton);
     buttonGroup->addButton (m_24BitRadioButton);
+    buttonGroup->addButton (m_paletteRadioButton);
+    buttonGroup->addButton (m_paletteDitheredRadioButton);
 
     m_defaultRadioButton = m_24BitRadioButton;
     m_defaultRadioButton->setChecked (true);
@@ -83,6 +103,8 @@ kpEffectReduceColorsWidget::kpEffectReduceColorsWidget (bool actOnSelection,
     lay->addWidget (m_8BitRadioButton);
     lay->addWidget (m_8BitDitheredRadioButton);
     lay->addWidget (m_24BitRadioButton);
+    lay->addWidget (m_paletteRadioButton);
+    lay->addWidget (m_paletteDitheredRadioButton);
 
     connect (m_blackAndWhiteRadioButton, &QRadioButton::toggled,
              this, &kpEffectReduceColorsWidget::settingsChanged);
@@ -98,6 +120,12 @@ kpEffectReduceColorsWidget::kpEffectReduceColorsWidget (bool actOnSelection,
 
     connect (m_24BitRadioButton, &QRadioButton::toggled,
              this, &kpEffectReduceColorsWidget::settingsChanged);
+
+    connect (m_paletteRadioButton, &QRadioButton::toggled,
+             this, &kpEffectReduceColorsWidget::settingsChanged);
+
+    connect (m_paletteDitheredRadioButton, &QRadioButton::toggled,
+             this, &kpEffectReduceColorsWidget::settingsChanged);
 }
 
 //---------------------------------------------------------------------
@@ -133,7 +161,17 @@ int kpEffectReduceColorsWidget::depth () const
 bool kpEffectReduceColorsWidget::dither () const
 {
     return (m_blackAndWhiteDitheredRadioButton->isChecked () ||
-            m_8BitDitheredRadioButton->isChecked ());
+            m_8BitDitheredRadioButton->isChecked () ||
+            m_paletteDitheredRadioButton->isChecked ());
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpEffectReduceColorsWidget::toPalette () const
+{
+    return (m_paletteRadioButton->isChecked () ||
+            m_paletteDitheredRadioButton->isChecked ());
 }
 
 //---------------------------------------------------------------------
@@ -160,6 +198,10 @@ bool kpEffectReduceColorsWidget::isNoOp () const
 // public virtual [base kpEffectWidgetBase]
 kpImage kpEffectReduceColorsWidget::applyEffect (const kpImage &image)
 {
+    if (toPalette ()) {
+        return kpEffectReduceToPalette::applyEffect (image, m_palette, dither ());
+    }
+
     return kpEffectReduceColors::applyEffect (image, depth (), dither ());
 }
 
@@ -169,6 +211,13 @@ kpImage kpEffectReduceColorsWidget::applyEffect (const kpImage &image)
 kpEffectCommandBase *kpEffectReduceColorsWidget::createCommand (
         kpCommandEnvironment *cmdEnviron) const
 {
+    if (toPalette ())
+    {
+        return new kpEffectReduceToPaletteCommand (m_palette, dither (),
+                                                   m_actOnSelection,
+                                                   cmdEnviron);
+    }
+
     return new kpEffectReduceColorsCommand (depth (), dither (),
                                             m_actOnSelection,
                                             cmdEnviron);
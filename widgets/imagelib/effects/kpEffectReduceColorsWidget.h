@@ -30,6 +30,9 @@
 #define kpEffectReduceColorsWidget_H
 
 
+#include <QRgb>
+#include <QVector>
+
 #include "kpEffectWidgetBase.h"
 
 
@@ -41,12 +44,17 @@ class kpEffectReduceColorsWidget : public kpEffectWidgetBase
 Q_OBJECT
 
 public:
+    // <palette> is offered as another choice, if it is not empty.
     kpEffectReduceColorsWidget (bool actOnSelection,
+                                const QVector <QRgb> &palette,
                                 QWidget *parent);
 
     int depth () const;
     bool dither () const;
 
+    // Whether to reduce to <palette>, instead of to depth().
+    bool toPalette () const;
+
 
     //
     // kpEffectWidgetBase interface
@@ -65,8 +73,12 @@ protected:
                  *m_blackAndWhiteDitheredRadioButton,
                  *m_8BitRadioButton,
                  *m_8BitDitheredRadioButton,
-                 *m_24BitRadioButton;
+                 *m_24BitRadioButton,
+                 *m_paletteRadioButton,
+                 *m_paletteDitheredRadioButton;
     QRadioButton *m_defaultRadioButton;
+
+    QVector <QRgb> m_palette;
 };
 
 
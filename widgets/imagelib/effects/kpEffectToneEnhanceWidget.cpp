@@ -123,7 +123,7 @@ bool kpEffectToneEnhanceWidget::isNoOp () const
 kpImage kpEffectToneEnhanceWidget::applyEffect (const kpImage &image)
 {
     return kpEffectToneEnhance::applyEffect (image,
-        granularity (), amount ());
+        granularity (), amount (), &m_toneMapCache);
 }
 
 // public virtual [base kpEffectWidgetBase]
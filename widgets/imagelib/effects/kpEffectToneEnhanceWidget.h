@@ -33,6 +33,7 @@
 
 #include "kpEffectWidgetBase.h"
 #include "kpNumInput.h"
+#include "imagelib/effects/kpEffectToneEnhance.h"
 
 class kpDoubleNumInput;
 
@@ -62,6 +63,9 @@ public:
 protected:
     kpDoubleNumInput *m_granularityInput;
     kpDoubleNumInput *m_amountInput;
+
+    // (for the preview)
+    kpEffectToneEnhanceCache m_toneMapCache;
 };
 
 
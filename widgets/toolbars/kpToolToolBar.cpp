@@ -51,6 +51,11 @@
 
 //---------------------------------------------------------------------
 
+static const char * const ToolWidgetOpaqueOrTransparentName =
+    "Tool Widget Opaque/Transparent";
+
+//---------------------------------------------------------------------
+
 class kpToolButton : public QToolButton
 {
 public:
@@ -82,28 +87,17 @@ kpToolToolBar::kpToolToolBar(const QString &name, int colsOrRows, QMainWindow *p
       m_baseWidget (nullptr),
       m_baseLayout (nullptr),
       m_toolLayout (nullptr),
+      m_toolWidgetBrush (nullptr),
+      m_toolWidgetEraserSize (nullptr),
+      m_toolWidgetFillStyle (nullptr),
+      m_toolWidgetLineWidth (nullptr),
+      m_toolWidgetOpaqueOrTransparent (nullptr),
+      m_toolWidgetSpraycanSize (nullptr),
       m_previousTool (nullptr), m_currentTool (nullptr)
 {
     m_baseWidget = new QWidget(this);
 
-    m_toolWidgets.append (m_toolWidgetBrush =
-        new kpToolWidgetBrush (m_baseWidget, QStringLiteral("Tool Widget Brush")));
-    m_toolWidgets.append (m_toolWidgetEraserSize =
-        new kpToolWidgetEraserSize (m_baseWidget, QStringLiteral("Tool Widget Eraser Size")));
-    m_toolWidgets.append (m_toolWidgetFillStyle =
-        new kpToolWidgetFillStyle (m_baseWidget, QStringLiteral("Tool Widget Fill Style")));
-    m_toolWidgets.append (m_toolWidgetLineWidth =
-        new kpToolWidgetLineWidth (m_baseWidget, QStringLiteral("Tool Widget Line Width")));
-    m_toolWidgets.append (m_toolWidgetOpaqueOrTransparent =
-        new kpToolWidgetOpaqueOrTransparent (m_baseWidget, QStringLiteral("Tool Widget Opaque/Transparent")));
-    m_toolWidgets.append (m_toolWidgetSpraycanSize =
-        new kpToolWidgetSpraycanSize (m_baseWidget, QStringLiteral("Tool Widget Spraycan Size")));
-
-    for (auto *w : m_toolWidgets)
-    {
-      connect (w, &kpToolWidgetBase::optionSelected,
-               this, &kpToolToolBar::toolWidgetOptionSelected);
-    }
+    // (the tool widgets are created on demand - see toolWidgetBrush() etc.)
 
     adjustToOrientation(orientation());
     connect (this, &kpToolToolBar::orientationChanged,
@@ -262,6 +256,144 @@ void kpToolToolBar::hideAllToolWidgets ()
 
 //---------------------------------------------------------------------
 
+// public
+kpToolWidgetBrush *kpToolToolBar::toolWidgetBrush ()
+{
+    if (!m_toolWidgetBrush)
+    {
+        addToolWidget (m_toolWidgetBrush =
+            new kpToolWidgetBrush (m_baseWidget, QStringLiteral("Tool Widget Brush")),
+            0);
+    }
+
+    return m_toolWidgetBrush;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpToolWidgetEraserSize *kpToolToolBar::toolWidgetEraserSize ()
+{
+    if (!m_toolWidgetEraserSize)
+    {
+        addToolWidget (m_toolWidgetEraserSize =
+            new kpToolWidgetEraserSize (m_baseWidget, QStringLiteral("Tool Widget Eraser Size")),
+            1);
+    }
+
+    return m_toolWidgetEraserSize;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpToolWidgetFillStyle *kpToolToolBar::toolWidgetFillStyle ()
+{
+    if (!m_toolWidgetFillStyle)
+    {
+        addToolWidget (m_toolWidgetFillStyle =
+            new kpToolWidgetFillStyle (m_baseWidget, QStringLiteral("Tool Widget Fill Style")),
+            2);
+    }
+
+    return m_toolWidgetFillStyle;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpToolWidgetLineWidth *kpToolToolBar::toolWidgetLineWidth ()
+{
+    if (!m_toolWidgetLineWidth)
+    {
+        addToolWidget (m_toolWidgetLineWidth =
+            new kpToolWidgetLineWidth (m_baseWidget, QStringLiteral("Tool Widget Line Width")),
+            3);
+    }
+
+    return m_toolWidgetLineWidth;
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpToolWidgetOpaqueOrTransparent *kpToolToolBar::toolWidgetOpaqueOrTransparent ()
+{
+    if (!m_toolWidgetOpaqueOrTransparent)
+    {
+        addToolWidget (m_toolWidgetOpaqueOrTransparent =
+            new kpToolWidgetOpaqueOrTransparent (m_baseWidget,
+                QLatin1String (::ToolWidgetOpaqueOrTransparentName)),
+            4);
+
+        connect (m_toolWidgetOpaqueOrTransparent,
+                 &kpToolWidgetOpaqueOrTransparent::isOpaqueChanged,
+                 this, &kpToolToolBar::drawOpaqueChanged);
+    }
+
+    return m_toolWidgetOpaqueOrTransparent;
+}
+
+//---------------------------------------------------------------------
+
+// public
+bool kpToolToolBar::drawOpaque () const
+{
+    if (m_toolWidgetOpaqueOrTransparent) {
+        return m_toolWidgetOpaqueOrTransparent->isOpaque ();
+    }
+
+    // What the widget would select when created: the saved option, if it
+    // is valid, or else Opaque (see kpToolWidgetBase::finishConstruction()).
+    const QPair <int, int> rowCol = kpToolWidgetBase::defaultSelectedRowAndCol (
+        QLatin1String (::ToolWidgetOpaqueOrTransparentName));
+    return !(rowCol.first == 1/*transparent*/ && rowCol.second == 0);
+}
+
+//---------------------------------------------------------------------
+
+// public
+kpToolWidgetSpraycanSize *kpToolToolBar::toolWidgetSpraycanSize ()
+{
+    if (!m_toolWidgetSpraycanSize)
+    {
+        addToolWidget (m_toolWidgetSpraycanSize =
+            new kpToolWidgetSpraycanSize (m_baseWidget, QStringLiteral("Tool Widget Spraycan Size")),
+            5);
+    }
+
+    return m_toolWidgetSpraycanSize;
+}
+
+//---------------------------------------------------------------------
+
+// private
+void kpToolToolBar::addToolWidget (kpToolWidgetBase *w, int order)
+{
+    // Keep the layout order fixed, whatever order the widgets are created in
+    // (this also determines the option groups of shownToolWidget()).
+    int i = 0;
+    while (i < m_toolWidgetOrders.count () && m_toolWidgetOrders [i] < order) {
+        i++;
+    }
+
+    m_toolWidgets.insert (i, w);
+    m_toolWidgetOrders.insert (i, order);
+
+    connect (w, &kpToolWidgetBase::optionSelected,
+             this, &kpToolToolBar::toolWidgetOptionSelected);
+
+    // (like hideAllToolWidgets() - the tool that wants it will show it)
+    w->hide ();
+
+    // (after the grid of tool buttons)
+    m_baseLayout->insertWidget (1 + i, w,
+        0/*stretch*/,
+        orientation () == Qt::Vertical ? Qt::AlignHCenter : Qt::AlignVCenter);
+}
+
+//---------------------------------------------------------------------
+
 // public
 kpToolWidgetBase *kpToolToolBar::shownToolWidget (int which) const
 {
@@ -72,12 +72,20 @@ public:
 
     void hideAllToolWidgets ();
     // could this be cleaner (the tools have to access them individually somehow)?
-    kpToolWidgetBrush *toolWidgetBrush () const { return m_toolWidgetBrush; }
-    kpToolWidgetEraserSize *toolWidgetEraserSize () const { return m_toolWidgetEraserSize; }
-    kpToolWidgetFillStyle *toolWidgetFillStyle () const { return m_toolWidgetFillStyle; }
-    kpToolWidgetLineWidth *toolWidgetLineWidth () const { return m_toolWidgetLineWidth; }
-    kpToolWidgetOpaqueOrTransparent *toolWidgetOpaqueOrTransparent () const { return m_toolWidgetOpaqueOrTransparent; }
-    kpToolWidgetSpraycanSize *toolWidgetSpraycanSize () const { return m_toolWidgetSpraycanSize; }
+    //
+    // The tool widgets are only created (hidden) on first access, usually
+    // when a tool that uses them is first selected, to keep them out of
+    // startup.
+    kpToolWidgetBrush *toolWidgetBrush ();
+    kpToolWidgetEraserSize *toolWidgetEraserSize ();
+    kpToolWidgetFillStyle *toolWidgetFillStyle ();
+    kpToolWidgetLineWidth *toolWidgetLineWidth ();
+    kpToolWidgetOpaqueOrTransparent *toolWidgetOpaqueOrTransparent ();
+    kpToolWidgetSpraycanSize *toolWidgetSpraycanSize ();
+
+    // Returns whether toolWidgetOpaqueOrTransparent() is set to Opaque,
+    // without creating it.
+    bool drawOpaque () const;
 
     kpToolWidgetBase *shownToolWidget (int which) const;
 
@@ -88,6 +96,9 @@ signals:
     void sigToolSelected (kpTool *tool);  // tool may be 0
     void toolWidgetOptionSelected ();
 
+    // Emitted when toolWidgetOpaqueOrTransparent(), once created, changes.
+    void drawOpaqueChanged (bool isOpaque);
+
 private slots:
     void slotToolButtonClicked ();
 
@@ -99,6 +110,7 @@ private slots:
 
 private:
     void addButton (QAbstractButton *button, Qt::Orientation o, int num);
+    void addToolWidget (kpToolWidgetBase *w, int order);
     void adjustSizeConstraint();
 
     int m_vertCols;
@@ -115,7 +127,10 @@ private:
     kpToolWidgetOpaqueOrTransparent *m_toolWidgetOpaqueOrTransparent;
     kpToolWidgetSpraycanSize *m_toolWidgetSpraycanSize;
 
+    // (in the order that they are laid out in, which is given by the
+    //  parallel list <m_toolWidgetOrders>, not the order of creation)
     QList<kpToolWidgetBase *> m_toolWidgets;
+    QList<int> m_toolWidgetOrders;
 
     QList<kpToolButton *> m_toolButtons;
 
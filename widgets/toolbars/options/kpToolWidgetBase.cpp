@@ -201,19 +201,27 @@ QList <int> kpToolWidgetBase::spreadOutElements (const QList <int> &sizes, int m
 
 // public
 QPair <int, int> kpToolWidgetBase::defaultSelectedRowAndCol () const
+{
+    return kpToolWidgetBase::defaultSelectedRowAndCol (objectName ());
+}
+
+//---------------------------------------------------------------------
+
+// public static
+QPair <int, int> kpToolWidgetBase::defaultSelectedRowAndCol (const QString &name)
 {
     int row = -1, col = -1;
 
-    if (!objectName ().isEmpty ())
+    if (!name.isEmpty ())
     {
         KConfigGroup cfg (KSharedConfig::openConfig (), kpSettingsGroupTools);
 
-        row = cfg.readEntry (objectName () + QLatin1String (" Row"), -1);
-        col = cfg.readEntry (objectName () + QLatin1String (" Col"), -1);
+        row = cfg.readEntry (name + QLatin1String (" Row"), -1);
+        col = cfg.readEntry (name + QLatin1String (" Col"), -1);
     }
 
 #if DEBUG_KP_TOOL_WIDGET_BASE
-    qCDebug(kpLogWidgets) << "kpToolWidgetBase(" << objectName ()
+    qCDebug(kpLogWidgets) << "kpToolWidgetBase(" << name
                << ")::defaultSelectedRowAndCol() returning row=" << row
                << " col=" << col;
 #endif
@@ -67,6 +67,9 @@ private:
 public:  // (only have to use these if you don't use finishConstruction())
     // (rereads from config file)
     QPair <int, int> defaultSelectedRowAndCol () const;
+    // Same as above for the tool widget called <name>, which need not have
+    // been created.
+    static QPair <int, int> defaultSelectedRowAndCol (const QString &name);
     int defaultSelectedRow () const;
     int defaultSelectedCol () const;
 